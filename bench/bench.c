@@ -0,0 +1,941 @@
+// Microbenchmarks for the simulation core. Every synthetic circuit kind is built at
+// each requested scale and timed on:
+//   event      toggle one input, propagate through the fanout lists (sim_run)
+//   levelized  full settle in topological order (levelized_settle)
+//   packed     compiled netlist, 64 vectors per pass (netlist_eval_packed)
+//   parallel   compiled netlist on the thread pool (netlist_eval_parallel)
+//   optimized  compiled netlist after logic simplification (netlist_optimize)
+//   codegen    netlist compiled to native code (netlist_codegen_load); only up to
+//              -c gates, since the C compiler needs seconds per 10k gates
+//   clocked    full clock cycles on the compiled netlist (netlist_clock_cycles), for
+//              circuits with clock sources
+//   timing     static timing analysis (netlist_timing_analyze), and random input
+//              changes simulated with gate delays on the timing wheel (netlist_wheel)
+//   waveform   every net recorded to a VCD file (struct WaveformRecorder) while random
+//              input vectors settle, against the same settles unrecorded
+//   nets       union-find net merges, and the split/rebuild done on wire delete
+//   select     point hit test through the spatial hash, as in the editor
+//   hierarchy  the array multiplier as shared component definitions (struct Component),
+//              and flattened into one netlist (component_flatten)
+// Results go to stdout (or -o) as JSON, one object per circuit, scale and benchmark,
+// so two builds can be compared with a plain diff or a script.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "circuit_gen.h"
+#include "netlist.h"
+#include "netlist_codegen.h"
+#include "netlist_opt.h"
+#include "netlist_timing.h"
+#include "spatial_hash.h"
+#include "thread_pool.h"
+#include "waveform.h"
+
+#define BENCH_SEED 12345u
+#define BENCH_DEFAULT_MIN_TIME 0.25 // Seconds each timed loop runs at least
+#define BENCH_DEFAULT_CODEGEN_GATES 20000 // Largest circuit handed to the C compiler by default
+#define BENCH_MAX_SCALES 16
+// Ring oscillators never settle: event propagation stops after this many
+// evaluations per gate and feedback ranks after this many iterations
+#define BENCH_EVENT_EVALS_PER_GATE 4
+#define BENCH_LOOP_ITERATIONS 8
+// Editor geometry for the selection benchmark (see editor.c)
+#define BENCH_GATE_SIZE 20.0f
+#define BENCH_GATE_PITCH 40.0f
+#define BENCH_CELL_SIZE 80.0f
+#define BENCH_PICKS 4096
+#define BENCH_WAVEFORM_PATH "bench_waveform.vcd" // Removed again after the run
+
+struct BenchOptions
+{
+    size_t scales[BENCH_MAX_SCALES];
+    int scale_count;
+    int kind_enabled[GEN_KIND_COUNT];
+    double min_time;
+    int threads; // 0 = one per CPU
+    size_t codegen_max_gates;
+    const char *output_path;
+};
+
+struct BenchOutput
+{
+    FILE *f;
+    int result_count;
+};
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint32_t next_random(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// ---- JSON output ----
+
+static void json_begin_result(struct BenchOutput *out, const struct GenCircuit *c, size_t scale, const char *bench)
+{
+    fprintf(out->f, "%s\n    {\"circuit\": \"%s\", \"scale\": %zu, \"gates\": %zu, \"benchmark\": \"%s\"",
+            out->result_count++ ? "," : "", gen_kind_name(c->kind), scale, c->gate_count, bench);
+}
+
+static void json_number(struct BenchOutput *out, const char *key, double value)
+{
+    fprintf(out->f, ", \"%s\": %.6g", key, value);
+}
+
+static void json_end_result(struct BenchOutput *out)
+{
+    fprintf(out->f, "}");
+}
+
+// ---- Benchmarks ----
+
+static void bench_event(struct BenchOutput *out, const struct GenCircuit *c, size_t scale, double min_time)
+{
+    struct Levelization levels = {0};
+    struct SimQueue queue;
+    sim_queue_init(&queue);
+    if (!levelize_gates(&levels, c->gates, c->gate_count))
+        return;
+    sim_queue_set_levels(&queue, levels.depth);
+    size_t max_evals = (c->gate_count + 1) * BENCH_EVENT_EVALS_PER_GATE;
+
+    // Start from a settled circuit
+    levelized_settle(&levels, BENCH_LOOP_ITERATIONS);
+
+    uint32_t rng = BENCH_SEED;
+    size_t toggles = 0, evaluations = 0;
+    double start = now_seconds(), elapsed = 0.0;
+    while (elapsed < min_time || toggles == 0)
+    {
+        struct Wire *net = wire_find(c->inputs[next_random(&rng) % c->input_count]);
+        wire_set_state(net, wire_state(net) == HIGH ? LOW : HIGH);
+        sim_schedule_fanout(&queue, net);
+        evaluations += sim_run(&queue, max_evals);
+        sim_queue_clear(&queue);
+        toggles++;
+        elapsed = now_seconds() - start;
+    }
+
+    json_begin_result(out, c, scale, "event");
+    json_number(out, "depth", levels.depth);
+    json_number(out, "toggles", (double)toggles);
+    json_number(out, "evals_per_toggle", (double)evaluations / (double)toggles);
+    json_number(out, "settle_latency_us", elapsed / (double)toggles * 1e6);
+    json_number(out, "gate_evals_per_sec", (double)evaluations / elapsed);
+    json_end_result(out);
+
+    sim_queue_free(&queue);
+    levelization_free(&levels);
+}
+
+static void bench_levelized(struct BenchOutput *out, const struct GenCircuit *c, size_t scale, double min_time)
+{
+    struct Levelization levels = {0};
+    double start = now_seconds();
+    if (!levelize_gates(&levels, c->gates, c->gate_count))
+        return;
+    double levelize_time = now_seconds() - start;
+
+    size_t settles = 0, evaluations = 0;
+    double elapsed = 0.0;
+    start = now_seconds();
+    while (elapsed < min_time || settles == 0)
+    {
+        evaluations += levelized_settle(&levels, BENCH_LOOP_ITERATIONS);
+        settles++;
+        elapsed = now_seconds() - start;
+    }
+
+    json_begin_result(out, c, scale, "levelized");
+    json_number(out, "levelize_ms", levelize_time * 1e3);
+    json_number(out, "settles", (double)settles);
+    json_number(out, "settle_latency_us", elapsed / (double)settles * 1e6);
+    json_number(out, "gate_evals_per_sec", (double)evaluations / elapsed);
+    json_end_result(out);
+    levelization_free(&levels);
+}
+
+// Bytes held by a compiled netlist plus its net words
+static size_t netlist_bytes(const struct Netlist *nl)
+{
+    size_t depth = (size_t)(nl->depth > 0 ? nl->depth : 0);
+    return nl->gate_count * (4 * sizeof(uint32_t) + 2) +
+           (depth + 1) * 2 * sizeof(size_t) + depth +
+           (nl->group_count + 1) * sizeof(size_t) + nl->group_count * 2 +
+           nl->net_count * (sizeof(struct Wire *) + sizeof(uint32_t) + sizeof(PatternWord)) +
+           nl->wire_table_size * (sizeof(struct Wire *) + sizeof(uint32_t));
+}
+
+// Mean distance between the nets a gate reads and the net it writes: small values
+// mean a rank's reads and writes stay within a few cache lines
+static double net_distance(const struct Netlist *nl)
+{
+    double total = 0.0;
+    size_t count = 0;
+    for (size_t i = 0; i < nl->gate_count; ++i)
+    {
+        uint32_t in[2] = {nl->gate_in1[i], nl->gate_in2[i]};
+        for (int k = 0; k < 2; ++k)
+        {
+            if (in[k] == NETLIST_NET_LOW)
+                continue;
+            total += in[k] > nl->gate_out[i] ? in[k] - nl->gate_out[i] : nl->gate_out[i] - in[k];
+            count++;
+        }
+    }
+    return count ? total / (double)count : 0.0;
+}
+
+static void bench_packed(struct BenchOutput *out, const struct GenCircuit *c, size_t scale, double min_time,
+                         ThreadPool *pool)
+{
+    struct Netlist nl;
+    double start = now_seconds();
+    if (!netlist_compile(&nl, c->gates, c->gate_count, NULL, 0))
+        return;
+    double compile_time = now_seconds() - start;
+    PatternWord *words = malloc((nl.net_count + 1) * sizeof(PatternWord));
+    if (!words)
+    {
+        netlist_free(&nl);
+        return;
+    }
+    netlist_load_states(&nl, words);
+
+    for (int parallel = 0; parallel <= (pool != NULL); ++parallel)
+    {
+        size_t passes = 0, evaluations = 0;
+        double elapsed = 0.0;
+        start = now_seconds();
+        while (elapsed < min_time || passes == 0)
+        {
+            if (parallel)
+                evaluations += netlist_eval_parallel(&nl, words, BENCH_LOOP_ITERATIONS, pool, NETLIST_PARALLEL_MIN_GATES);
+            else
+                evaluations += netlist_eval_packed(&nl, words, BENCH_LOOP_ITERATIONS);
+            passes++;
+            elapsed = now_seconds() - start;
+        }
+
+        json_begin_result(out, c, scale, parallel ? "parallel" : "packed");
+        if (parallel)
+            json_number(out, "threads", thread_pool_size(pool));
+        else
+        {
+            json_number(out, "compile_ms", compile_time * 1e3);
+            json_number(out, "simd", netlist_get_simd());
+            json_number(out, "netlist_bytes_per_gate", (double)netlist_bytes(&nl) / (double)nl.gate_count);
+            json_number(out, "mean_net_distance", net_distance(&nl));
+        }
+        json_number(out, "passes", (double)passes);
+        json_number(out, "evals_per_pass", (double)evaluations / (double)passes);
+        json_number(out, "pass_latency_us", elapsed / (double)passes * 1e6);
+        json_number(out, "gate_evals_per_sec", (double)evaluations / elapsed);
+        json_number(out, "pattern_evals_per_sec", (double)evaluations * NETLIST_PATTERNS_PER_WORD / elapsed);
+        json_end_result(out);
+    }
+    free(words);
+    netlist_free(&nl);
+}
+
+// Simplify the netlist keeping the circuit outputs, then time a packed pass on the result
+static void bench_optimized(struct BenchOutput *out, const struct GenCircuit *c, size_t scale, double min_time)
+{
+    struct Netlist nl, optimized;
+    if (!netlist_compile(&nl, c->gates, c->gate_count, c->outputs, c->output_count))
+        return;
+    uint32_t *keep = malloc((c->output_count + 1) * sizeof(uint32_t));
+    uint32_t *net_map = malloc((nl.net_count + 1) * sizeof(uint32_t));
+    struct NetlistOptStats stats;
+    int ok = keep && net_map;
+    double start = now_seconds();
+    if (ok)
+    {
+        for (size_t i = 0; i < c->output_count; ++i)
+            keep[i] = netlist_net_of(&nl, c->outputs[i]);
+        ok = netlist_optimize(&nl, keep, c->output_count, &optimized, net_map, &stats);
+    }
+    double optimize_time = now_seconds() - start;
+    PatternWord *words = ok ? malloc((optimized.net_count + 1) * sizeof(PatternWord)) : NULL;
+    if (words)
+    {
+        netlist_load_states(&optimized, words);
+        size_t passes = 0, evaluations = 0;
+        double elapsed = 0.0;
+        start = now_seconds();
+        while (elapsed < min_time || passes == 0)
+        {
+            evaluations += netlist_eval_packed(&optimized, words, BENCH_LOOP_ITERATIONS);
+            passes++;
+            elapsed = now_seconds() - start;
+        }
+
+        json_begin_result(out, c, scale, "optimized");
+        json_number(out, "optimize_ms", optimize_time * 1e3);
+        json_number(out, "gates_after", (double)stats.gates_after);
+        json_number(out, "folded", (double)stats.folded);
+        json_number(out, "collapsed", (double)stats.collapsed);
+        json_number(out, "merged", (double)stats.merged);
+        json_number(out, "removed", (double)stats.removed);
+        json_number(out, "evals_per_pass", (double)evaluations / (double)passes);
+        json_number(out, "pass_latency_us", elapsed / (double)passes * 1e6);
+        json_number(out, "gate_evals_per_sec", (double)evaluations / elapsed);
+        json_end_result(out);
+    }
+    free(words);
+    if (ok)
+        netlist_free(&optimized);
+    free(keep);
+    free(net_map);
+    netlist_free(&nl);
+}
+
+// Straight-line C for the netlist, built by the system compiler; the build time is
+// reported separately from the pass latency it buys
+static void bench_codegen(struct BenchOutput *out, const struct GenCircuit *c, size_t scale, double min_time)
+{
+    struct Netlist nl;
+    if (!netlist_compile(&nl, c->gates, c->gate_count, NULL, 0))
+        return;
+    struct NetlistCompiled compiled;
+    double start = now_seconds();
+    int loaded = netlist_codegen_load(&compiled, &nl);
+    double build_time = now_seconds() - start;
+    PatternWord *words = loaded ? malloc((nl.net_count + 1) * sizeof(PatternWord)) : NULL;
+    if (!loaded)
+        fprintf(stderr, "codegen: no C compiler available, skipped\n");
+    if (words)
+    {
+        netlist_load_states(&nl, words);
+        size_t passes = 0, evaluations = 0;
+        double elapsed = 0.0;
+        start = now_seconds();
+        while (elapsed < min_time || passes == 0)
+        {
+            evaluations += netlist_codegen_eval(&compiled, &nl, words, BENCH_LOOP_ITERATIONS);
+            passes++;
+            elapsed = now_seconds() - start;
+        }
+
+        json_begin_result(out, c, scale, "codegen");
+        json_number(out, "build_s", build_time);
+        json_number(out, "passes", (double)passes);
+        json_number(out, "evals_per_pass", (double)evaluations / (double)passes);
+        json_number(out, "pass_latency_us", elapsed / (double)passes * 1e6);
+        json_number(out, "gate_evals_per_sec", (double)evaluations / elapsed);
+        json_number(out, "pattern_evals_per_sec", (double)evaluations * NETLIST_PATTERNS_PER_WORD / elapsed);
+        json_end_result(out);
+    }
+    free(words);
+    netlist_codegen_unload(&compiled);
+    netlist_free(&nl);
+}
+
+// Clock cycles on the compiled netlist: every cycle is a rising and a falling edge,
+// each settling whatever the flip-flops changed
+static void bench_clocked(struct BenchOutput *out, const struct GenCircuit *c, size_t scale, double min_time)
+{
+    struct Netlist nl;
+    if (!netlist_compile(&nl, c->gates, c->gate_count, NULL, 0))
+        return;
+    PatternWord *words = malloc((nl.net_count + 1) * sizeof(PatternWord));
+    struct NetlistClock clock = {0};
+    if (words)
+    {
+        netlist_load_states(&nl, words);
+        netlist_eval_packed(&nl, words, BENCH_LOOP_ITERATIONS);
+    }
+    if (words && netlist_clock_init(&clock, &nl, words) && clock.clock_count > 0)
+    {
+        const uint64_t batch = 16;
+        size_t evaluations = 0;
+        double elapsed = 0.0;
+        double start = now_seconds();
+        while (elapsed < min_time || clock.cycles == 0)
+        {
+            evaluations += netlist_clock_cycles(&clock, &nl, words, batch, BENCH_LOOP_ITERATIONS);
+            elapsed = now_seconds() - start;
+        }
+
+        json_begin_result(out, c, scale, "clocked");
+        json_number(out, "flip_flops", (double)clock.dff_count);
+        json_number(out, "cycles", (double)clock.cycles);
+        json_number(out, "evals_per_cycle", (double)evaluations / (double)clock.cycles);
+        json_number(out, "cycle_latency_us", elapsed / (double)clock.cycles * 1e6);
+        json_number(out, "cycles_per_sec", (double)clock.cycles / elapsed);
+        json_number(out, "gate_evals_per_sec", (double)evaluations / elapsed);
+        json_end_result(out);
+    }
+    netlist_clock_free(&clock);
+    free(words);
+    netlist_free(&nl);
+}
+
+static void bench_timing(struct BenchOutput *out, const struct GenCircuit *c, size_t scale, double min_time)
+{
+    struct Netlist nl;
+    if (!netlist_compile(&nl, c->gates, c->gate_count, c->inputs, c->input_count))
+        return;
+    struct TimingModel model;
+    timing_model_default(&model);
+    PatternWord *settled = malloc((nl.net_count + 1) * sizeof(PatternWord));
+    PatternWord *words = malloc((nl.net_count + 1) * sizeof(PatternWord));
+    uint32_t *input_nets = malloc((c->input_count + 1) * sizeof(uint32_t));
+    struct NetlistTiming timing;
+    struct NetlistWheel wheel;
+    int ok = settled && words && input_nets && netlist_timing_analyze(&timing, &nl, &model);
+    if (ok)
+    {
+        // Every change starts from all inputs LOW, settled (oscillators stopped)
+        netlist_load_states(&nl, settled);
+        for (size_t i = 0; i < c->input_count; ++i)
+        {
+            input_nets[i] = netlist_net_of(&nl, c->inputs[i]);
+            settled[input_nets[i]] = 0;
+        }
+        netlist_eval_packed(&nl, settled, BENCH_LOOP_ITERATIONS);
+        ok = netlist_wheel_init(&wheel, &nl, &model, settled);
+        if (!ok)
+            netlist_timing_free(&timing);
+    }
+    if (ok)
+    {
+        size_t analyses = 0;
+        double sta_time = 0.0;
+        while (sta_time < min_time / 4 || analyses == 0)
+        {
+            struct NetlistTiming again;
+            double start = now_seconds();
+            int analyzed = netlist_timing_analyze(&again, &nl, &model);
+            sta_time += now_seconds() - start;
+            analyses++;
+            netlist_timing_free(&again);
+            if (!analyzed)
+                break;
+        }
+
+        // Oscillators never settle: stop where every path has long finished
+        uint64_t horizon = ((uint64_t)timing.critical_delay + 64) * BENCH_LOOP_ITERATIONS;
+        uint32_t rng = BENCH_SEED;
+        size_t changes = 0, glitches = 0, events = 0, evaluations = 0;
+        uint64_t settle_total = 0;
+        double elapsed = 0.0;
+        while (elapsed < min_time || changes == 0)
+        {
+            memcpy(words, settled, nl.net_count * sizeof(PatternWord));
+            netlist_wheel_reset(&wheel, words);
+            for (size_t i = 0; i < c->input_count; ++i)
+                netlist_wheel_drive(&wheel, input_nets[i],
+                                    ((PatternWord)next_random(&rng) << 32) | next_random(&rng));
+            size_t events_before = wheel.events;
+            double start = now_seconds();
+            evaluations += netlist_wheel_run(&wheel, words, horizon);
+            elapsed += now_seconds() - start;
+            events += wheel.events - events_before;
+            glitches += netlist_wheel_glitches(&wheel, ~(PatternWord)0);
+            settle_total += wheel.last_change;
+            changes++;
+        }
+
+        json_begin_result(out, c, scale, "timing");
+        json_number(out, "critical_ps", (double)timing.critical_delay);
+        json_number(out, "critical_gates", (double)timing.path_length);
+        json_number(out, "sta_ms", sta_time / (double)analyses * 1e3);
+        json_number(out, "settle_ps", (double)settle_total / (double)changes);
+        json_number(out, "glitches_per_change", (double)glitches / (double)changes);
+        json_number(out, "events_per_sec", (double)events / elapsed);
+        json_number(out, "gate_evals_per_sec", (double)evaluations / elapsed);
+        json_end_result(out);
+        netlist_wheel_free(&wheel);
+        netlist_timing_free(&timing);
+    }
+    free(input_nets);
+    free(words);
+    free(settled);
+    netlist_free(&nl);
+}
+
+// Lane 0 of random packed settles, with every net recorded as one VCD signal. The
+// unrecorded settles give the baseline, so sample_ns is the recording cost per step.
+static void bench_waveform(struct BenchOutput *out, const struct GenCircuit *c, size_t scale, double min_time)
+{
+    struct Netlist nl;
+    if (!netlist_compile(&nl, c->gates, c->gate_count, c->inputs, c->input_count))
+        return;
+    PatternWord *words = malloc((nl.net_count + 1) * sizeof(PatternWord));
+    uint32_t *input_nets = malloc((c->input_count + 1) * sizeof(uint32_t));
+    uint32_t *signal_nets = malloc((nl.net_count + 1) * sizeof(uint32_t));
+    struct WaveformRecorder rec;
+    int ok = words && input_nets && signal_nets && waveform_open(&rec, BENCH_WAVEFORM_PATH, 0, "1 ns");
+    if (ok)
+    {
+        netlist_load_states(&nl, words);
+        for (size_t i = 0; i < c->input_count; ++i)
+            input_nets[i] = netlist_net_of(&nl, c->inputs[i]);
+        netlist_eval_packed(&nl, words, BENCH_LOOP_ITERATIONS);
+        char name[32];
+        size_t signals = 0;
+        for (uint32_t n = NETLIST_FIRST_NET; n < nl.net_count; ++n)
+        {
+            snprintf(name, sizeof(name), "net%u", n);
+            signal_nets[signals++] = n;
+            waveform_add_signal(&rec, name, (SignalState)(words[n] & 1));
+        }
+        ok = waveform_start(&rec);
+        if (!ok)
+            waveform_close(&rec);
+    }
+    if (ok)
+    {
+        uint32_t rng = BENCH_SEED;
+        size_t steps = 0, base_steps = 0;
+        double elapsed = 0.0, base_elapsed = 0.0;
+        while (base_elapsed < min_time / 2 || base_steps == 0)
+        {
+            for (size_t i = 0; i < c->input_count; ++i)
+                words[input_nets[i]] = ((PatternWord)next_random(&rng) << 32) | next_random(&rng);
+            double start = now_seconds();
+            netlist_eval_packed(&nl, words, BENCH_LOOP_ITERATIONS);
+            base_elapsed += now_seconds() - start;
+            base_steps++;
+        }
+        while (elapsed < min_time || steps == 0)
+        {
+            for (size_t i = 0; i < c->input_count; ++i)
+                words[input_nets[i]] = ((PatternWord)next_random(&rng) << 32) | next_random(&rng);
+            double start = now_seconds();
+            netlist_eval_packed(&nl, words, BENCH_LOOP_ITERATIONS);
+            waveform_step(&rec, ++steps);
+            waveform_sample_words(&rec, signal_nets, words, 0);
+            elapsed += now_seconds() - start;
+        }
+        size_t memory = waveform_memory_bytes(&rec);
+        double close_start = now_seconds();
+        int written = waveform_close(&rec);
+        double close_time = now_seconds() - close_start;
+
+        if (written)
+        {
+            double sample_time = elapsed / (double)steps - base_elapsed / (double)base_steps;
+            json_begin_result(out, c, scale, "waveform");
+            json_number(out, "signals", (double)(nl.net_count - NETLIST_FIRST_NET));
+            json_number(out, "changes_per_step", (double)rec.changes / (double)steps);
+            json_number(out, "changes_per_sec", (double)rec.changes / (elapsed + close_time));
+            json_number(out, "sample_ns", sample_time > 0.0 ? sample_time * 1e9 : 0.0);
+            json_number(out, "file_mb", (double)rec.bytes_written / 1e6);
+            json_number(out, "memory_kb", (double)memory / 1024.0);
+            json_number(out, "stalls", (double)rec.stalls);
+            json_end_result(out);
+        }
+        remove(BENCH_WAVEFORM_PATH);
+    }
+    free(signal_nets);
+    free(input_nets);
+    free(words);
+    netlist_free(&nl);
+}
+
+// Union-find: join segments into nets of 8 (as drawing connected wires does), then
+// split every net again the way deleting a segment does (reset + re-union)
+static void bench_nets(struct BenchOutput *out, const struct GenCircuit *c, size_t scale, double min_time)
+{
+    const size_t segments_per_net = 8;
+    size_t count = c->wire_count;
+    struct Wire **nodes = malloc(count * sizeof(struct Wire *));
+    if (!nodes)
+        return;
+    size_t created = 0;
+    for (; created < count; ++created)
+    {
+        nodes[created] = wire_create(LOW);
+        if (!nodes[created])
+            break;
+    }
+
+    uint32_t rng = BENCH_SEED;
+    size_t rounds = 0, unions = 0, finds = 0;
+    double merge_time = 0.0, split_time = 0.0, find_time = 0.0;
+    while ((merge_time + split_time + find_time < min_time || rounds == 0) && created == count)
+    {
+        double t0 = now_seconds();
+        for (size_t i = 0; i < count; ++i)
+        {
+            // Join to a random earlier segment of the same net
+            size_t net_first = i - i % segments_per_net;
+            if (i != net_first)
+            {
+                wire_union(nodes[i], nodes[net_first + next_random(&rng) % (i - net_first)]);
+                unions++;
+            }
+        }
+        double t1 = now_seconds();
+        size_t roots = 0;
+        for (size_t i = 0; i < count; ++i)
+            roots += wire_find(nodes[i]) == nodes[i];
+        finds += count;
+        double t2 = now_seconds();
+        for (size_t i = 0; i < count; ++i)
+            wire_reset(nodes[i]);
+        double t3 = now_seconds();
+        merge_time += t1 - t0;
+        find_time += t2 - t1;
+        split_time += t3 - t2;
+        rounds++;
+        if (roots != (count + segments_per_net - 1) / segments_per_net)
+            fprintf(stderr, "nets: expected one root per net, got %zu\n", roots);
+    }
+
+    if (created == count)
+    {
+        json_begin_result(out, c, scale, "nets");
+        json_number(out, "segments", (double)count);
+        json_number(out, "unions_per_sec", (double)unions / merge_time);
+        json_number(out, "finds_per_sec", (double)finds / find_time);
+        json_number(out, "resets_per_sec", (double)(rounds * count) / split_time);
+        json_end_result(out);
+    }
+    for (size_t i = 0; i < created; ++i)
+        wire_destroy(nodes[i]);
+    free(nodes);
+}
+
+// Gates laid out on a square grid; random clicks resolved like hit_test_gate
+static void bench_select(struct BenchOutput *out, const struct GenCircuit *c, size_t scale, double min_time)
+{
+    size_t n = c->gate_count;
+    size_t columns = 1;
+    while (columns * columns < n)
+        columns++;
+    struct SpatialHash grid;
+    spatial_hash_init(&grid, BENCH_CELL_SIZE, BENCH_CELL_SIZE);
+
+    double start = now_seconds();
+    for (size_t i = 0; i < n; ++i)
+    {
+        float x = (float)(i % columns) * BENCH_GATE_PITCH;
+        float y = (float)(i / columns) * BENCH_GATE_PITCH;
+        if (!spatial_hash_insert(&grid, (uint32_t)i, x, y, x + BENCH_GATE_SIZE, y + BENCH_GATE_SIZE))
+        {
+            spatial_hash_free(&grid);
+            return;
+        }
+    }
+    double index_time = now_seconds() - start;
+
+    float extent = (float)columns * BENCH_GATE_PITCH;
+    float *clicks = malloc(2 * BENCH_PICKS * sizeof(float));
+    if (!clicks)
+    {
+        spatial_hash_free(&grid);
+        return;
+    }
+    uint32_t rng = BENCH_SEED;
+    for (int k = 0; k < 2 * BENCH_PICKS; ++k)
+        clicks[k] = (float)(next_random(&rng) % 1000000u) / 1000000.0f * extent;
+
+    size_t picks = 0, hits = 0;
+    double elapsed = 0.0;
+    start = now_seconds();
+    while (elapsed < min_time || picks == 0)
+    {
+        for (int k = 0; k < BENCH_PICKS; ++k)
+        {
+            float px = clicks[2 * k], py = clicks[2 * k + 1];
+            const uint32_t *ids;
+            size_t found = spatial_hash_query(&grid, px, py, px, py, &ids);
+            long best = -1;
+            for (size_t j = 0; j < found; ++j)
+            {
+                float gx = (float)(ids[j] % columns) * BENCH_GATE_PITCH;
+                float gy = (float)(ids[j] / columns) * BENCH_GATE_PITCH;
+                if (px >= gx && px <= gx + BENCH_GATE_SIZE && py >= gy && py <= gy + BENCH_GATE_SIZE &&
+                    (best < 0 || (long)ids[j] < best))
+                    best = (long)ids[j];
+            }
+            hits += best >= 0;
+        }
+        picks += BENCH_PICKS;
+        elapsed = now_seconds() - start;
+    }
+
+    json_begin_result(out, c, scale, "select");
+    json_number(out, "index_ms", index_time * 1e3);
+    json_number(out, "picks", (double)picks);
+    json_number(out, "hit_ratio", (double)hits / (double)picks);
+    json_number(out, "latency_ns", elapsed / (double)picks * 1e9);
+    json_end_result(out);
+    free(clicks);
+    spatial_hash_free(&grid);
+}
+
+// The multiplier as shared definitions: memory is the per-instance state only, and
+// an input toggle re-settles just the cells whose inputs changed
+static void bench_hierarchy(struct BenchOutput *out, const struct GenCircuit *c, size_t scale, double min_time)
+{
+    struct GenComponents lib;
+    if (!gen_build_component_multiplier(&lib, scale))
+        return;
+    struct ComponentInstance instance;
+    if (!component_instance_init(&instance, lib.top))
+    {
+        gen_free_components(&lib);
+        return;
+    }
+    size_t definition_bytes = component_definition_bytes(lib.full_adder) + component_definition_bytes(lib.cell) +
+                              component_definition_bytes(lib.row) + component_definition_bytes(lib.top);
+    double start = now_seconds();
+    size_t first_settle = component_instance_settle(&instance, BENCH_LOOP_ITERATIONS);
+    double first_time = now_seconds() - start;
+
+    uint32_t rng = BENCH_SEED;
+    size_t toggles = 0, evaluations = 0;
+    double elapsed = 0.0;
+    start = now_seconds();
+    while (elapsed < min_time || toggles == 0)
+    {
+        int input = (int)(next_random(&rng) % (uint32_t)lib.top->num_inputs);
+        SignalState value = (SignalState)instance.state[component_input_net(lib.top, input)];
+        component_instance_set_input(&instance, input, value == HIGH ? LOW : HIGH);
+        evaluations += component_instance_settle(&instance, BENCH_LOOP_ITERATIONS);
+        toggles++;
+        elapsed = now_seconds() - start;
+    }
+
+    // The same design flattened for batch simulation
+    struct Netlist nl;
+    uint32_t *pin_nets = malloc(((size_t)lib.top->num_inputs + (size_t)lib.top->num_outputs + 1) * sizeof(uint32_t));
+    start = now_seconds();
+    int flat = pin_nets && component_flatten(lib.top, &nl, pin_nets, pin_nets + lib.top->num_inputs);
+    double flatten_time = now_seconds() - start;
+    PatternWord *words = flat ? malloc((nl.net_count + 1) * sizeof(PatternWord)) : NULL;
+    size_t flat_passes = 0, flat_evaluations = 0;
+    double flat_elapsed = 0.0;
+    if (words)
+    {
+        netlist_load_states(&nl, words);
+        start = now_seconds();
+        while (flat_elapsed < min_time || flat_passes == 0)
+        {
+            flat_evaluations += netlist_eval_packed(&nl, words, BENCH_LOOP_ITERATIONS);
+            flat_passes++;
+            flat_elapsed = now_seconds() - start;
+        }
+    }
+
+    json_begin_result(out, c, scale, "hierarchy");
+    json_number(out, "bits", (double)lib.bits);
+    json_number(out, "instance_gates", (double)lib.top->total_gates);
+    json_number(out, "state_bytes_per_gate", (double)lib.top->state_size / (double)lib.top->total_gates);
+    json_number(out, "definition_bytes", (double)definition_bytes);
+    json_number(out, "first_settle_us", first_time * 1e6);
+    json_number(out, "first_settle_evals", (double)first_settle);
+    json_number(out, "evals_per_toggle", (double)evaluations / (double)toggles);
+    json_number(out, "settle_latency_us", elapsed / (double)toggles * 1e6);
+    json_number(out, "gate_evals_per_sec", (double)evaluations / elapsed);
+    if (words)
+    {
+        json_number(out, "flatten_ms", flatten_time * 1e3);
+        json_number(out, "flat_gates", (double)nl.gate_count);
+        json_number(out, "flat_mean_net_distance", net_distance(&nl));
+        json_number(out, "flat_pass_latency_us", flat_elapsed / (double)flat_passes * 1e6);
+        json_number(out, "flat_gate_evals_per_sec", (double)flat_evaluations / flat_elapsed);
+    }
+    json_end_result(out);
+
+    free(words);
+    if (flat)
+        netlist_free(&nl);
+    free(pin_nets);
+    component_instance_free(&instance);
+    gen_free_components(&lib);
+}
+
+// ---- Driver ----
+
+static void print_usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -s N[,N...]  gate counts to build (default 1000,100000,1000000; k/M suffixes allowed)\n"
+            "  -k NAME      only this circuit kind (repeatable):",
+            program);
+    for (int k = 0; k < GEN_KIND_COUNT; ++k)
+        fprintf(stderr, " %s", gen_kind_name((GenKind)k));
+    fprintf(stderr,
+            "\n"
+            "  -t SECONDS   minimum time per measurement (default %.2f)\n"
+            "  -j N         threads for the parallel benchmark, 0 = one per CPU (default 0)\n"
+            "  -c N         largest circuit for the codegen benchmark, 0 = skip (default %zu)\n"
+            "  -o FILE      write the JSON there instead of stdout\n",
+            BENCH_DEFAULT_MIN_TIME, (size_t)BENCH_DEFAULT_CODEGEN_GATES);
+}
+
+static int parse_scales(struct BenchOptions *opt, char *list)
+{
+    opt->scale_count = 0;
+    for (char *token = strtok(list, ","); token; token = strtok(NULL, ","))
+    {
+        char *end;
+        double value = strtod(token, &end);
+        if (*end == 'k' || *end == 'K')
+            value *= 1e3, end++;
+        else if (*end == 'm' || *end == 'M')
+            value *= 1e6, end++;
+        if (end == token || *end != '\0' || value < 1.0 || value > 1e9 || opt->scale_count == BENCH_MAX_SCALES)
+            return 0;
+        opt->scales[opt->scale_count++] = (size_t)value;
+    }
+    return opt->scale_count > 0;
+}
+
+static int parse_options(int argc, char **argv, struct BenchOptions *opt)
+{
+    memset(opt, 0, sizeof(*opt));
+    opt->scales[0] = 1000;
+    opt->scales[1] = 100000;
+    opt->scales[2] = 1000000;
+    opt->scale_count = 3;
+    opt->min_time = BENCH_DEFAULT_MIN_TIME;
+    opt->codegen_max_gates = BENCH_DEFAULT_CODEGEN_GATES;
+    int any_kind = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (i + 1 >= argc || argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0')
+            return 0;
+        char *value = argv[++i];
+        switch (argv[i - 1][1])
+        {
+        case 's':
+            if (!parse_scales(opt, value))
+                return 0;
+            break;
+        case 'k':
+        {
+            GenKind kind = gen_kind_from_name(value);
+            if (kind == GEN_KIND_COUNT)
+                return 0;
+            opt->kind_enabled[kind] = 1;
+            any_kind = 1;
+            break;
+        }
+        case 't':
+            opt->min_time = atof(value);
+            if (opt->min_time < 0.0)
+                return 0;
+            break;
+        case 'c':
+        {
+            char *end;
+            opt->codegen_max_gates = (size_t)strtoull(value, &end, 10);
+            if (end == value || *end != '\0')
+                return 0;
+            break;
+        }
+        case 'j':
+            opt->threads = atoi(value);
+            if (opt->threads < 0)
+                return 0;
+            break;
+        case 'o':
+            opt->output_path = value;
+            break;
+        default:
+            return 0;
+        }
+    }
+    if (!any_kind)
+    {
+        for (int k = 0; k < GEN_KIND_COUNT; ++k)
+            opt->kind_enabled[k] = 1;
+    }
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    struct BenchOptions opt;
+    if (!parse_options(argc, argv, &opt))
+    {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    struct BenchOutput out = {stdout, 0};
+    if (opt.output_path)
+    {
+        out.f = fopen(opt.output_path, "w");
+        if (!out.f)
+        {
+            fprintf(stderr, "Cannot write %s\n", opt.output_path);
+            return 1;
+        }
+    }
+    ThreadPool *pool = thread_pool_create(opt.threads);
+
+    fprintf(out.f, "{\n  \"schema\": 1,\n  \"simd_supported\": %d,\n  \"threads\": %d,\n  \"min_time_s\": %g,\n"
+                   "  \"sizeof_gate\": %zu,\n  \"sizeof_wire\": %zu,\n  \"results\": [",
+            (int)netlist_simd_supported(), pool ? thread_pool_size(pool) : 1, opt.min_time,
+            sizeof(struct Gate), sizeof(struct Wire));
+
+    int ok = 1;
+    for (int s = 0; s < opt.scale_count && ok; ++s)
+    {
+        for (int k = 0; k < GEN_KIND_COUNT && ok; ++k)
+        {
+            if (!opt.kind_enabled[k])
+                continue;
+            struct GenCircuit c;
+            double start = now_seconds();
+            if (!gen_build(&c, (GenKind)k, opt.scales[s], BENCH_SEED))
+            {
+                fprintf(stderr, "Out of memory building %s at %zu gates\n", gen_kind_name((GenKind)k), opt.scales[s]);
+                ok = 0;
+                break;
+            }
+            fprintf(stderr, "%-16s %8zu gates  built in %.1f ms\n", gen_kind_name((GenKind)k), c.gate_count,
+                    (now_seconds() - start) * 1e3);
+
+            json_begin_result(&out, &c, opt.scales[s], "memory");
+            json_number(&out, "nets", (double)c.wire_count);
+            json_number(&out, "logic_bytes_per_gate", (double)gen_memory_bytes(&c) / (double)c.gate_count);
+            json_end_result(&out);
+
+            bench_event(&out, &c, opt.scales[s], opt.min_time);
+            bench_levelized(&out, &c, opt.scales[s], opt.min_time);
+            bench_packed(&out, &c, opt.scales[s], opt.min_time, pool);
+            bench_optimized(&out, &c, opt.scales[s], opt.min_time);
+            if (c.gate_count <= opt.codegen_max_gates)
+                bench_codegen(&out, &c, opt.scales[s], opt.min_time);
+            bench_clocked(&out, &c, opt.scales[s], opt.min_time);
+            bench_timing(&out, &c, opt.scales[s], opt.min_time);
+            bench_waveform(&out, &c, opt.scales[s], opt.min_time);
+            bench_nets(&out, &c, opt.scales[s], opt.min_time);
+            bench_select(&out, &c, opt.scales[s], opt.min_time);
+            if (c.kind == GEN_ARRAY_MULTIPLIER)
+                bench_hierarchy(&out, &c, opt.scales[s], opt.min_time);
+            gen_free(&c);
+            fflush(out.f);
+        }
+    }
+    fprintf(out.f, "\n  ]\n}\n");
+
+    thread_pool_destroy(pool);
+    if (out.f != stdout)
+        fclose(out.f);
+    return ok ? 0 : 1;
+}
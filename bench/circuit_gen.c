@@ -0,0 +1,557 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "circuit_gen.h"
+
+#define WIDE_BUS_WIDTH 256
+#define RANDOM_DAG_INPUTS 64
+#define ACCUMULATOR_WIDTH 16
+
+static const char *const kind_names[GEN_KIND_COUNT] = {
+    "ripple_adder", "cla_adder", "array_multiplier", "random_dag",
+    "inverter_chain", "ring_oscillator", "wide_bus", "accumulator"};
+
+const char *gen_kind_name(GenKind kind)
+{
+    return (kind >= 0 && kind < GEN_KIND_COUNT) ? kind_names[kind] : "unknown";
+}
+
+GenKind gen_kind_from_name(const char *name)
+{
+    for (int k = 0; k < GEN_KIND_COUNT; ++k)
+    {
+        if (strcmp(name, kind_names[k]) == 0)
+            return (GenKind)k;
+    }
+    return GEN_KIND_COUNT;
+}
+
+static uint32_t next_random(uint32_t *state)
+{
+    // xorshift32
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Append to one of the pointer lists; sets c->failed on allocation failure
+#define GEN_PUSH(c, items, count, capacity, item)                                  \
+    do                                                                             \
+    {                                                                              \
+        if ((count) == (capacity))                                                 \
+        {                                                                          \
+            size_t new_capacity_ = (capacity) == 0 ? 64 : (capacity) * 2;          \
+            void *grown_ = realloc((items), new_capacity_ * sizeof(*(items)));     \
+            if (!grown_)                                                           \
+            {                                                                      \
+                (c)->failed = 1;                                                   \
+                break;                                                             \
+            }                                                                      \
+            (items) = grown_;                                                      \
+            (capacity) = new_capacity_;                                            \
+        }                                                                          \
+        (items)[(count)++] = (item);                                               \
+    } while (0)
+
+static struct Wire *new_wire(struct GenCircuit *c, SignalState state)
+{
+    struct Wire *wire = logic_pool_new_wire(&c->pool, state);
+    if (!wire)
+    {
+        c->failed = 1;
+        return NULL;
+    }
+    GEN_PUSH(c, c->wires, c->wire_count, c->wire_capacity, wire);
+    if (c->failed)
+    {
+        logic_pool_delete_wire(&c->pool, wire);
+        return NULL;
+    }
+    return wire;
+}
+
+static struct Wire *new_input(struct GenCircuit *c)
+{
+    struct Wire *wire = new_wire(c, LOW);
+    if (wire)
+        GEN_PUSH(c, c->inputs, c->input_count, c->input_capacity, wire);
+    return wire;
+}
+
+static void add_output(struct GenCircuit *c, struct Wire *wire)
+{
+    if (wire)
+        GEN_PUSH(c, c->outputs, c->output_count, c->output_capacity, wire);
+}
+
+// New gate reading a and b (either may be NULL); returns its output wire
+static struct Wire *new_gate(struct GenCircuit *c, GateType type, struct Wire *a, struct Wire *b)
+{
+    struct Wire *out = new_wire(c, UNKNOWN);
+    struct Gate *gate = out ? logic_pool_new_gate(&c->pool, type) : NULL;
+    if (!gate)
+    {
+        c->failed = 1;
+        return NULL;
+    }
+    gate->output = out;
+    gate_set_input(gate, 0, a);
+    gate_set_input(gate, 1, b);
+    GEN_PUSH(c, c->gates, c->gate_count, c->gate_capacity, gate);
+    if (c->failed)
+    {
+        logic_pool_delete_gate(&c->pool, gate);
+        return NULL;
+    }
+    return out;
+}
+
+// Sum of up to three bits (NULL = absent); *carry receives the carry or NULL
+static struct Wire *add_bits(struct GenCircuit *c, struct Wire *x, struct Wire *y, struct Wire *z, struct Wire **carry)
+{
+    struct Wire *bits[3];
+    int n = 0;
+    if (x)
+        bits[n++] = x;
+    if (y)
+        bits[n++] = y;
+    if (z)
+        bits[n++] = z;
+
+    *carry = NULL;
+    if (n == 0)
+        return NULL;
+    if (n == 1)
+        return bits[0];
+    struct Wire *p = new_gate(c, XOR, bits[0], bits[1]);
+    if (n == 2)
+    {
+        *carry = new_gate(c, AND, bits[0], bits[1]);
+        return p;
+    }
+    struct Wire *sum = new_gate(c, XOR, p, bits[2]);
+    struct Wire *g = new_gate(c, AND, bits[0], bits[1]);
+    struct Wire *t = new_gate(c, AND, p, bits[2]);
+    *carry = new_gate(c, OR, g, t);
+    return sum;
+}
+
+static void build_ripple_adder(struct GenCircuit *c, size_t target)
+{
+    size_t bits = target / 5 > 0 ? target / 5 : 1;
+    struct Wire *carry = new_input(c);
+    for (size_t i = 0; i < bits && !c->failed; ++i)
+    {
+        struct Wire *a = new_input(c);
+        struct Wire *b = new_input(c);
+        add_output(c, add_bits(c, a, b, carry, &carry));
+    }
+    add_output(c, carry);
+}
+
+// Gates of an n-bit Kogge-Stone adder: p/g per bit, 3 per prefix node, n - 1 sums
+static size_t cla_gate_count(size_t n)
+{
+    size_t total = 2 * n + (n - 1);
+    for (size_t d = 1; d < n; d *= 2)
+        total += 3 * (n - d);
+    return total;
+}
+
+static void build_cla_adder(struct GenCircuit *c, size_t target)
+{
+    size_t n = 1;
+    while (cla_gate_count(n + 1) <= target)
+        n = (cla_gate_count(2 * n) <= target) ? 2 * n : n + 1;
+
+    struct Wire **p = malloc(n * sizeof(struct Wire *));
+    struct Wire **gen = malloc(n * sizeof(struct Wire *));
+    struct Wire **prop = malloc(n * sizeof(struct Wire *));
+    struct Wire **next_gen = malloc(n * sizeof(struct Wire *));
+    struct Wire **next_prop = malloc(n * sizeof(struct Wire *));
+    if (!p || !gen || !prop || !next_gen || !next_prop)
+        c->failed = 1;
+
+    for (size_t i = 0; i < n && !c->failed; ++i)
+    {
+        struct Wire *a = new_input(c);
+        struct Wire *b = new_input(c);
+        p[i] = new_gate(c, XOR, a, b);
+        gen[i] = new_gate(c, AND, a, b);
+        prop[i] = p[i];
+    }
+    // Parallel prefix: after the pass with distance d, gen[i] covers bits [i - 2d + 1, i]
+    for (size_t d = 1; d < n && !c->failed; d *= 2)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (i < d)
+            {
+                next_gen[i] = gen[i];
+                next_prop[i] = prop[i];
+                continue;
+            }
+            next_gen[i] = new_gate(c, OR, gen[i], new_gate(c, AND, prop[i], gen[i - d]));
+            next_prop[i] = new_gate(c, AND, prop[i], prop[i - d]);
+        }
+        memcpy(gen, next_gen, n * sizeof(struct Wire *));
+        memcpy(prop, next_prop, n * sizeof(struct Wire *));
+    }
+    for (size_t i = 0; i < n && !c->failed; ++i)
+        add_output(c, i == 0 ? p[0] : new_gate(c, XOR, p[i], gen[i - 1]));
+    if (!c->failed)
+        add_output(c, gen[n - 1]);
+
+    free(p);
+    free(gen);
+    free(prop);
+    free(next_gen);
+    free(next_prop);
+}
+
+// n^2 partial products plus about 5n(n - 1) adder gates
+static size_t multiplier_bits(size_t target)
+{
+    size_t n = (size_t)sqrt((double)target / 6.0);
+    return n < 2 ? 2 : n;
+}
+
+static void build_array_multiplier(struct GenCircuit *c, size_t target)
+{
+    size_t n = multiplier_bits(target);
+    struct Wire **a = malloc(n * sizeof(struct Wire *));
+    struct Wire **b = malloc(n * sizeof(struct Wire *));
+    struct Wire **acc = calloc(2 * n, sizeof(struct Wire *));
+    if (!a || !b || !acc)
+        c->failed = 1;
+
+    for (size_t i = 0; i < n && !c->failed; ++i)
+        a[i] = new_input(c);
+    for (size_t i = 0; i < n && !c->failed; ++i)
+        b[i] = new_input(c);
+    for (size_t j = 0; j < n && !c->failed; ++j)
+    {
+        // acc += (a * b[j]) << j
+        struct Wire *carry = NULL;
+        for (size_t i = 0; i < n; ++i)
+        {
+            struct Wire *pp = new_gate(c, AND, a[i], b[j]);
+            acc[i + j] = add_bits(c, acc[i + j], pp, carry, &carry);
+        }
+        acc[j + n] = carry;
+    }
+    for (size_t i = 0; i < 2 * n && !c->failed; ++i)
+        add_output(c, acc[i]);
+
+    free(a);
+    free(b);
+    free(acc);
+}
+
+static void build_random_dag(struct GenCircuit *c, size_t target, uint32_t *rng)
+{
+    size_t inputs = target < RANDOM_DAG_INPUTS ? (target > 2 ? target : 2) : RANDOM_DAG_INPUTS;
+    for (size_t i = 0; i < inputs && !c->failed; ++i)
+        new_input(c);
+    for (size_t i = 0; i < target && !c->failed; ++i)
+    {
+        GateType type = (GateType)(AND + next_random(rng) % (XNOR - AND + 1));
+        struct Wire *x = c->wires[next_random(rng) % c->wire_count];
+        struct Wire *y = type == INVERT ? NULL : c->wires[next_random(rng) % c->wire_count];
+        new_gate(c, type, x, y);
+    }
+    size_t first = c->gate_count > RANDOM_DAG_INPUTS ? c->gate_count - RANDOM_DAG_INPUTS : 0;
+    for (size_t i = first; i < c->gate_count && !c->failed; ++i)
+        add_output(c, c->gates[i]->output);
+}
+
+static void build_inverter_chain(struct GenCircuit *c, size_t target)
+{
+    struct Wire *w = new_input(c);
+    for (size_t i = 0; i < target && !c->failed; ++i)
+        w = new_gate(c, INVERT, w, NULL);
+    add_output(c, w);
+}
+
+static void build_ring_oscillator(struct GenCircuit *c, size_t target)
+{
+    // The NAND plus an even number of inverters make an odd number of inversions
+    size_t inverters = (target > 1 ? target - 1 : 0) & ~(size_t)1;
+    if (inverters == 0)
+        inverters = 2;
+    struct Wire *enable = new_input(c);
+    struct Wire *w = new_gate(c, NAND, enable, NULL);
+    if (c->failed)
+        return;
+    struct Gate *head = c->gates[c->gate_count - 1];
+    for (size_t i = 0; i < inverters && !c->failed; ++i)
+        w = new_gate(c, INVERT, w, NULL);
+    if (c->failed)
+        return;
+    gate_set_input(head, 1, w); // Close the loop
+    add_output(c, w);
+}
+
+static void build_wide_bus(struct GenCircuit *c, size_t target)
+{
+    size_t width = target < WIDE_BUS_WIDTH ? (target > 0 ? target : 1) : WIDE_BUS_WIDTH;
+    size_t stages = target / width > 0 ? target / width : 1;
+    struct Wire **bus = malloc(width * sizeof(struct Wire *));
+    if (!bus)
+    {
+        c->failed = 1;
+        return;
+    }
+    for (size_t i = 0; i < width && !c->failed; ++i)
+        bus[i] = new_input(c);
+    static const GateType stage_types[3] = {AND, OR, XOR};
+    for (size_t s = 0; s < stages && !c->failed; ++s)
+    {
+        // One control net fans out to the whole bus
+        struct Wire *control = new_input(c);
+        for (size_t i = 0; i < width; ++i)
+            bus[i] = new_gate(c, stage_types[s % 3], bus[i], control);
+    }
+    for (size_t i = 0; i < width && !c->failed; ++i)
+        add_output(c, bus[i]);
+    free(bus);
+}
+
+// Register r[0] += inputs + 1, r[k] += r[k - 1] on every rising clock edge: about six
+// gates per bit (full adder and flip-flop), all of them busy every cycle
+static void build_accumulator(struct GenCircuit *c, size_t target)
+{
+    size_t registers = target / (6 * ACCUMULATOR_WIDTH) > 0 ? target / (6 * ACCUMULATOR_WIDTH) : 1;
+    struct Wire **addend = malloc(ACCUMULATOR_WIDTH * sizeof(struct Wire *));
+    struct Wire **q = malloc(ACCUMULATOR_WIDTH * sizeof(struct Wire *));
+    struct Gate **dff = malloc(ACCUMULATOR_WIDTH * sizeof(struct Gate *));
+    if (!addend || !q || !dff)
+        c->failed = 1;
+
+    struct Wire *clock = c->failed ? NULL : new_gate(c, CLOCK, NULL, NULL);
+    struct Wire *one = c->failed ? NULL : new_gate(c, CONSTANT_HIGH, NULL, NULL);
+    for (size_t i = 0; i < ACCUMULATOR_WIDTH && !c->failed; ++i)
+        addend[i] = new_input(c);
+    for (size_t r = 0; r < registers && !c->failed; ++r)
+    {
+        // Flip-flops first: the adder reads their outputs, they read its sums
+        for (size_t i = 0; i < ACCUMULATOR_WIDTH && !c->failed; ++i)
+        {
+            q[i] = new_gate(c, DFF, NULL, clock);
+            if (q[i])
+            {
+                wire_set_state(q[i], LOW);
+                dff[i] = c->gates[c->gate_count - 1];
+            }
+        }
+        struct Wire *carry = r == 0 ? one : NULL;
+        for (size_t i = 0; i < ACCUMULATOR_WIDTH && !c->failed; ++i)
+            gate_set_input(dff[i], 0, add_bits(c, q[i], addend[i], carry, &carry));
+        memcpy(addend, q, ACCUMULATOR_WIDTH * sizeof(struct Wire *));
+    }
+    for (size_t i = 0; i < ACCUMULATOR_WIDTH && !c->failed; ++i)
+        add_output(c, q[i]);
+
+    free(addend);
+    free(q);
+    free(dff);
+}
+
+int gen_build(struct GenCircuit *c, GenKind kind, size_t target_gates, uint32_t seed)
+{
+    memset(c, 0, sizeof(*c));
+    logic_pool_init(&c->pool);
+    c->kind = kind;
+    uint32_t rng = seed ? seed : 1;
+    switch (kind)
+    {
+    case GEN_RIPPLE_ADDER:
+        build_ripple_adder(c, target_gates);
+        break;
+    case GEN_CLA_ADDER:
+        build_cla_adder(c, target_gates);
+        break;
+    case GEN_ARRAY_MULTIPLIER:
+        build_array_multiplier(c, target_gates);
+        break;
+    case GEN_RANDOM_DAG:
+        build_random_dag(c, target_gates, &rng);
+        break;
+    case GEN_INVERTER_CHAIN:
+        build_inverter_chain(c, target_gates);
+        break;
+    case GEN_RING_OSCILLATOR:
+        build_ring_oscillator(c, target_gates);
+        break;
+    case GEN_WIDE_BUS:
+        build_wide_bus(c, target_gates);
+        break;
+    case GEN_ACCUMULATOR:
+        build_accumulator(c, target_gates);
+        break;
+    default:
+        c->failed = 1;
+        break;
+    }
+    if (c->failed)
+    {
+        gen_free(c);
+        return 0;
+    }
+    return 1;
+}
+
+void gen_free(struct GenCircuit *c)
+{
+    // Gates and wires go with the pool; only the fanout lists are separate
+    for (size_t i = 0; i < c->wire_count; ++i)
+        wire_release(c->wires[i]);
+    logic_pool_free(&c->pool);
+    free(c->gates);
+    free(c->wires);
+    free(c->inputs);
+    free(c->outputs);
+    memset(c, 0, sizeof(*c));
+}
+
+size_t gen_memory_bytes(const struct GenCircuit *c)
+{
+    size_t bytes = logic_pool_bytes(&c->pool) + wire_state_bytes();
+    for (size_t i = 0; i < c->wire_count; ++i)
+        bytes += (size_t)c->wires[i]->fanout_capacity * sizeof(struct Gate *);
+    return bytes;
+}
+
+// Inputs a, b, cin; outputs sum, cout
+static struct Component *build_full_adder_component(void)
+{
+    struct Component *fa = component_create("full_adder", 3, 2);
+    if (!fa)
+        return NULL;
+    uint32_t a = component_input_net(fa, 0), b = component_input_net(fa, 1), cin = component_input_net(fa, 2);
+    uint32_t p = component_add_net(fa), sum = component_add_net(fa);
+    uint32_t g = component_add_net(fa), t = component_add_net(fa), cout = component_add_net(fa);
+    int ok = component_add_gate(fa, XOR, a, b, p) && component_add_gate(fa, XOR, p, cin, sum) &&
+             component_add_gate(fa, AND, a, b, g) && component_add_gate(fa, AND, p, cin, t) &&
+             component_add_gate(fa, OR, g, t, cout);
+    component_set_output(fa, 0, sum);
+    component_set_output(fa, 1, cout);
+    if (!ok || !component_finalize(fa))
+    {
+        component_destroy(fa);
+        return NULL;
+    }
+    return fa;
+}
+
+// Inputs a, b, sum_in, carry_in; outputs sum_in + a * b + carry_in as (sum, carry)
+static struct Component *build_multiplier_cell(const struct Component *fa)
+{
+    struct Component *cell = component_create("multiplier_cell", 4, 2);
+    if (!cell)
+        return NULL;
+    uint32_t pp = component_add_net(cell), sum = component_add_net(cell), carry = component_add_net(cell);
+    uint32_t pins[5] = {component_input_net(cell, 2), pp, component_input_net(cell, 3), sum, carry};
+    int ok = component_add_gate(cell, AND, component_input_net(cell, 0), component_input_net(cell, 1), pp) &&
+             component_add_instance(cell, fa, pins);
+    component_set_output(cell, 0, sum);
+    component_set_output(cell, 1, carry);
+    if (!ok || !component_finalize(cell))
+    {
+        component_destroy(cell);
+        return NULL;
+    }
+    return cell;
+}
+
+// Inputs a[0..n), b_j, sum_in[0..n); outputs sum_in + a * b_j as sum[0..n), carry
+static struct Component *build_multiplier_row(const struct Component *cell, size_t n)
+{
+    struct Component *row = component_create("multiplier_row", (int)(2 * n + 1), (int)(n + 1));
+    if (!row)
+        return NULL;
+    uint32_t b = component_input_net(row, (int)n);
+    uint32_t carry = COMPONENT_NET_LOW;
+    int ok = 1;
+    for (size_t i = 0; i < n && ok; ++i)
+    {
+        uint32_t sum = component_add_net(row), next_carry = component_add_net(row);
+        uint32_t pins[6] = {component_input_net(row, (int)i), b, component_input_net(row, (int)(n + 1 + i)),
+                            carry, sum, next_carry};
+        ok = component_add_instance(row, cell, pins);
+        component_set_output(row, (int)i, sum);
+        carry = next_carry;
+    }
+    component_set_output(row, (int)n, carry);
+    if (!ok || !component_finalize(row))
+    {
+        component_destroy(row);
+        return NULL;
+    }
+    return row;
+}
+
+static struct Component *build_multiplier_top(const struct Component *row, size_t n)
+{
+    struct Component *top = component_create("array_multiplier", (int)(2 * n), (int)(2 * n));
+    uint32_t *acc = calloc(2 * n, sizeof(uint32_t)); // Running sum, LOW to start
+    uint32_t *pins = malloc((3 * n + 2) * sizeof(uint32_t));
+    int ok = top && acc && pins;
+    for (size_t j = 0; j < n && ok; ++j)
+    {
+        // acc[j .. j + n] = acc[j .. j + n) + a * b[j]
+        for (size_t i = 0; i < n; ++i)
+        {
+            pins[i] = component_input_net(top, (int)i);
+            pins[n + 1 + i] = acc[j + i];
+        }
+        pins[n] = component_input_net(top, (int)(n + j));
+        for (size_t i = 0; i <= n; ++i)
+        {
+            pins[2 * n + 1 + i] = component_add_net(top);
+            ok = ok && pins[2 * n + 1 + i] != COMPONENT_MAX_NETS;
+        }
+        ok = ok && component_add_instance(top, row, pins);
+        for (size_t i = 0; i <= n; ++i)
+            acc[j + i] = pins[2 * n + 1 + i];
+    }
+    for (size_t i = 0; i < 2 * n && ok; ++i)
+        component_set_output(top, (int)i, acc[i]);
+    free(acc);
+    free(pins);
+    if (!ok || !component_finalize(top))
+    {
+        component_destroy(top);
+        return NULL;
+    }
+    return top;
+}
+
+int gen_build_component_multiplier(struct GenComponents *lib, size_t target_gates)
+{
+    memset(lib, 0, sizeof(*lib));
+    lib->bits = multiplier_bits(target_gates);
+    lib->full_adder = build_full_adder_component();
+    lib->cell = lib->full_adder ? build_multiplier_cell(lib->full_adder) : NULL;
+    lib->row = lib->cell ? build_multiplier_row(lib->cell, lib->bits) : NULL;
+    lib->top = lib->row ? build_multiplier_top(lib->row, lib->bits) : NULL;
+    if (!lib->top)
+    {
+        gen_free_components(lib);
+        return 0;
+    }
+    return 1;
+}
+
+void gen_free_components(struct GenComponents *lib)
+{
+    // Users before the definitions they instantiate
+    component_destroy(lib->top);
+    component_destroy(lib->row);
+    component_destroy(lib->cell);
+    component_destroy(lib->full_adder);
+    memset(lib, 0, sizeof(*lib));
+}
@@ -0,0 +1,73 @@
+#ifndef CIRCUIT_GEN_H
+#define CIRCUIT_GEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "component.h"
+#include "logic.h"
+#include "pool.h"
+
+// Synthetic circuits for the benchmarks, built from the same struct Gate / struct Wire
+// objects the editor creates (from a struct LogicPool, like the editor), sized to
+// roughly a requested gate count.
+typedef enum
+{
+    GEN_RIPPLE_ADDER,     // Chain of full adders: depth grows with the width
+    GEN_CLA_ADDER,        // Kogge-Stone carry-lookahead adder: logarithmic depth
+    GEN_ARRAY_MULTIPLIER, // n x n AND array summed by rows of ripple adders
+    GEN_RANDOM_DAG,       // Random 2-input gates reading any earlier wire
+    GEN_INVERTER_CHAIN,   // One long path: depth = gate count
+    GEN_RING_OSCILLATOR,  // NAND-enabled odd inverter ring: one large feedback loop
+    GEN_WIDE_BUS,         // 256-bit bus through stages gated by high-fanout control nets
+    GEN_ACCUMULATOR,      // 16-bit registers on one clock, each adding its neighbour every cycle
+    GEN_KIND_COUNT
+} GenKind;
+
+struct GenCircuit
+{
+    GenKind kind;
+    struct LogicPool pool; // Owns the gates and wires
+    struct Gate **gates;
+    size_t gate_count;
+    size_t gate_capacity;
+    struct Wire **wires; // Every wire created; each is its own net
+    size_t wire_count;
+    size_t wire_capacity;
+    struct Wire **inputs; // Undriven wires, toggled by the benchmarks
+    size_t input_count;
+    size_t input_capacity;
+    struct Wire **outputs;
+    size_t output_count;
+    size_t output_capacity;
+    int failed; // Set by the builders when an allocation fails
+};
+
+const char *gen_kind_name(GenKind kind);
+// GEN_KIND_COUNT if the name is unknown
+GenKind gen_kind_from_name(const char *name);
+
+// Build a circuit of the given kind with about target_gates gates (never fewer than a
+// handful). Inputs start LOW. Returns 0 on allocation failure (c is freed).
+int gen_build(struct GenCircuit *c, GenKind kind, size_t target_gates, uint32_t seed);
+void gen_free(struct GenCircuit *c);
+
+// Heap bytes held by the gates, wires (their pool slabs) and fanout lists
+size_t gen_memory_bytes(const struct GenCircuit *c);
+
+// The array multiplier as a hierarchy of shared definitions: full adder -> multiplier
+// cell (AND + full adder) -> row of cells -> multiplier built from rows. top has
+// inputs a[0..n), b[0..n) and outputs p[0..2n).
+struct GenComponents
+{
+    struct Component *full_adder;
+    struct Component *cell;
+    struct Component *row;
+    struct Component *top;
+    size_t bits;
+};
+
+// Same size rule as GEN_ARRAY_MULTIPLIER. Returns 0 on allocation failure.
+int gen_build_component_multiplier(struct GenComponents *lib, size_t target_gates);
+void gen_free_components(struct GenComponents *lib);
+
+#endif // CIRCUIT_GEN_H
@@ -0,0 +1,565 @@
+#include <stdlib.h>
+#include <string.h>
+#include "component.h"
+#include "pool.h"
+
+struct Component *component_create(const char *name, int num_inputs, int num_outputs)
+{
+    if (num_inputs < 0 || num_outputs < 0)
+        return NULL;
+    struct Component *component = calloc(1, sizeof(struct Component));
+    if (!component)
+        return NULL;
+    size_t name_length = name ? strlen(name) : 0;
+    component->name = malloc(name_length + 1);
+    component->outputs = calloc((size_t)num_outputs + 1, sizeof(uint32_t)); // Unset outputs read LOW
+    if (!component->name || !component->outputs)
+    {
+        component_destroy(component);
+        return NULL;
+    }
+    if (name_length)
+        memcpy(component->name, name, name_length);
+    component->name[name_length] = '\0';
+    component->num_inputs = num_inputs;
+    component->num_outputs = num_outputs;
+    component->num_wires = 1 + (uint32_t)num_inputs;
+    return component;
+}
+
+void component_destroy(struct Component *component)
+{
+    if (!component)
+        return;
+    for (int i = 0; i < component->num_subcomponents; ++i)
+        free(component->subcomponents[i].pins);
+    free(component->subcomponents);
+    free(component->gates);
+    free(component->outputs);
+    free(component->order);
+    free(component->name);
+    free(component);
+}
+
+uint32_t component_input_net(const struct Component *component, int input_index)
+{
+    if (input_index < 0 || input_index >= component->num_inputs)
+        return COMPONENT_MAX_NETS;
+    return 1 + (uint32_t)input_index;
+}
+
+uint32_t component_add_net(struct Component *component)
+{
+    if (component->finalized || component->num_wires == COMPONENT_MAX_NETS - 1)
+        return COMPONENT_MAX_NETS;
+    return component->num_wires++;
+}
+
+void component_set_output(struct Component *component, int output_index, uint32_t net)
+{
+    if (!component->finalized && output_index >= 0 && output_index < component->num_outputs &&
+        net < component->num_wires)
+        component->outputs[output_index] = net;
+}
+
+int component_add_gate(struct Component *component, GateType type, uint32_t in1, uint32_t in2, uint32_t out)
+{
+    if (component->finalized || in1 >= component->num_wires || in2 >= component->num_wires ||
+        out >= component->num_wires || out == COMPONENT_NET_LOW)
+        return 0;
+    if (component->num_gates == component->gate_capacity)
+    {
+        int new_capacity = component->gate_capacity == 0 ? 8 : component->gate_capacity * 2;
+        struct ComponentGate *gates = realloc(component->gates, (size_t)new_capacity * sizeof(struct ComponentGate));
+        if (!gates)
+            return 0;
+        component->gates = gates;
+        component->gate_capacity = new_capacity;
+    }
+    struct ComponentGate *gate = &component->gates[component->num_gates++];
+    gate->type = (uint8_t)type;
+    gate->in1 = in1;
+    gate->in2 = in2;
+    gate->out = out;
+    return 1;
+}
+
+int component_add_instance(struct Component *component, const struct Component *definition, const uint32_t *pins)
+{
+    if (component->finalized || !definition || !definition->finalized || definition == component)
+        return 0;
+    size_t pin_count = (size_t)definition->num_inputs + (size_t)definition->num_outputs;
+    for (size_t p = 0; p < pin_count; ++p)
+    {
+        if (pins[p] >= component->num_wires || (p >= (size_t)definition->num_inputs && pins[p] == COMPONENT_NET_LOW))
+            return 0;
+    }
+    if (component->num_subcomponents == component->subcomponent_capacity)
+    {
+        int new_capacity = component->subcomponent_capacity == 0 ? 8 : component->subcomponent_capacity * 2;
+        struct ComponentCell *cells = realloc(component->subcomponents, (size_t)new_capacity * sizeof(struct ComponentCell));
+        if (!cells)
+            return 0;
+        component->subcomponents = cells;
+        component->subcomponent_capacity = new_capacity;
+    }
+    uint32_t *copy = malloc((pin_count + 1) * sizeof(uint32_t));
+    if (!copy)
+        return 0;
+    memcpy(copy, pins, pin_count * sizeof(uint32_t));
+    struct ComponentCell *cell = &component->subcomponents[component->num_subcomponents++];
+    cell->definition = definition;
+    cell->pins = copy;
+    cell->state_offset = 0;
+    return 1;
+}
+
+// Nets read (reading = 1) or driven by node k of the body, k as in Component.order
+static size_t node_pins(const struct Component *component, size_t k, int reading, const uint32_t **out_pins,
+                        uint32_t scratch[2])
+{
+    if (k < (size_t)component->num_gates)
+    {
+        const struct ComponentGate *gate = &component->gates[k];
+        if (reading)
+        {
+            scratch[0] = gate->in1;
+            scratch[1] = gate->in2;
+            *out_pins = scratch;
+            return 2;
+        }
+        *out_pins = &gate->out;
+        return 1;
+    }
+    const struct ComponentCell *cell = &component->subcomponents[k - (size_t)component->num_gates];
+    size_t inputs = (size_t)cell->definition->num_inputs;
+    if (reading)
+    {
+        *out_pins = cell->pins;
+        return inputs;
+    }
+    *out_pins = cell->pins + inputs;
+    return (size_t)cell->definition->num_outputs;
+}
+
+int component_finalize(struct Component *component)
+{
+    if (component->finalized)
+        return 1;
+    size_t node_count = (size_t)component->num_gates + (size_t)component->num_subcomponents;
+    size_t net_count = component->num_wires;
+    uint32_t *order = malloc((node_count + 1) * sizeof(uint32_t));
+    uint32_t *driver = malloc(net_count * sizeof(uint32_t));
+    size_t *reader_start = calloc(net_count + 1, sizeof(size_t));
+    size_t *indegree = calloc(node_count + 1, sizeof(size_t));
+    if (!order || !driver || !reader_start || !indegree)
+    {
+        free(order);
+        free(driver);
+        free(reader_start);
+        free(indegree);
+        return 0;
+    }
+
+    // Driver of each net (the last node writing it)
+    for (size_t n = 0; n < net_count; ++n)
+        driver[n] = UINT32_MAX;
+    const uint32_t *pins;
+    uint32_t scratch[2];
+    for (size_t k = 0; k < node_count; ++k)
+    {
+        size_t count = node_pins(component, k, 0, &pins, scratch);
+        for (size_t p = 0; p < count; ++p)
+            driver[pins[p]] = (uint32_t)k;
+    }
+
+    // Readers of each net (CSR), and how many driven nets each node waits for
+    size_t read_total = 0;
+    for (size_t k = 0; k < node_count; ++k)
+    {
+        size_t count = node_pins(component, k, 1, &pins, scratch);
+        for (size_t p = 0; p < count; ++p)
+        {
+            reader_start[pins[p] + 1]++;
+            if (driver[pins[p]] != UINT32_MAX)
+                indegree[k]++;
+        }
+        read_total += count;
+    }
+    for (size_t n = 0; n < net_count; ++n)
+        reader_start[n + 1] += reader_start[n];
+    uint32_t *readers = malloc((read_total + 1) * sizeof(uint32_t));
+    size_t *fill = malloc((net_count + 1) * sizeof(size_t));
+    if (!readers || !fill)
+    {
+        free(readers);
+        free(fill);
+        free(order);
+        free(driver);
+        free(reader_start);
+        free(indegree);
+        return 0;
+    }
+    memcpy(fill, reader_start, net_count * sizeof(size_t));
+    for (size_t k = 0; k < node_count; ++k)
+    {
+        size_t count = node_pins(component, k, 1, &pins, scratch);
+        for (size_t p = 0; p < count; ++p)
+            readers[fill[pins[p]]++] = (uint32_t)k;
+    }
+
+    // Kahn's algorithm; order doubles as the queue
+    size_t head = 0, tail = 0;
+    for (size_t k = 0; k < node_count; ++k)
+    {
+        if (indegree[k] == 0)
+            order[tail++] = (uint32_t)k;
+    }
+    while (head < tail)
+    {
+        uint32_t k = order[head++];
+        size_t count = node_pins(component, k, 0, &pins, scratch);
+        for (size_t p = 0; p < count; ++p)
+        {
+            uint32_t net = pins[p];
+            if (driver[net] != k)
+                continue; // Another node is the net's driver
+            for (size_t r = reader_start[net]; r < reader_start[net + 1]; ++r)
+            {
+                if (--indegree[readers[r]] == 0)
+                    order[tail++] = readers[r];
+            }
+        }
+    }
+    // Nodes left over sit on feedback loops: keep them in insertion order and iterate
+    component->cyclic = tail < node_count;
+    if (component->cyclic)
+    {
+        for (size_t k = 0; k < node_count; ++k)
+        {
+            if (indegree[k] != 0)
+                order[tail++] = (uint32_t)k;
+        }
+    }
+
+    // State layout: own nets, the settled flag, then every nested cell
+    size_t offset = net_count + 1;
+    size_t total_gates = (size_t)component->num_gates;
+    for (int i = 0; i < component->num_subcomponents; ++i)
+    {
+        struct ComponentCell *cell = &component->subcomponents[i];
+        cell->state_offset = offset;
+        offset += cell->definition->state_size;
+        total_gates += cell->definition->total_gates;
+    }
+    component->order = order;
+    component->state_size = offset;
+    component->total_gates = total_gates;
+    component->finalized = 1;
+
+    free(readers);
+    free(fill);
+    free(driver);
+    free(reader_start);
+    free(indegree);
+    return 1;
+}
+
+size_t component_definition_bytes(const struct Component *component)
+{
+    size_t bytes = sizeof(struct Component) + strlen(component->name) + 1 +
+                   (size_t)component->gate_capacity * sizeof(struct ComponentGate) +
+                   (size_t)component->subcomponent_capacity * sizeof(struct ComponentCell) +
+                   ((size_t)component->num_outputs + 1) * sizeof(uint32_t);
+    for (int i = 0; i < component->num_subcomponents; ++i)
+    {
+        const struct Component *definition = component->subcomponents[i].definition;
+        bytes += ((size_t)definition->num_inputs + (size_t)definition->num_outputs + 1) * sizeof(uint32_t);
+    }
+    if (component->order)
+        bytes += ((size_t)component->num_gates + (size_t)component->num_subcomponents + 1) * sizeof(uint32_t);
+    return bytes;
+}
+
+// Temporary gates and wires built while flattening, all from one pool
+struct FlattenContext
+{
+    struct LogicPool pool;
+    struct Gate **gates;
+    size_t gate_count;
+    size_t gate_capacity;
+    struct Wire **wires;
+    size_t wire_count;
+    size_t wire_capacity;
+    int failed;
+};
+
+static struct Wire *flatten_wire(struct FlattenContext *ctx)
+{
+    if (ctx->wire_count == ctx->wire_capacity)
+    {
+        size_t capacity = ctx->wire_capacity ? ctx->wire_capacity * 2 : 64;
+        struct Wire **wires = realloc(ctx->wires, capacity * sizeof(struct Wire *));
+        if (!wires)
+            return NULL;
+        ctx->wires = wires;
+        ctx->wire_capacity = capacity;
+    }
+    struct Wire *wire = logic_pool_new_wire(&ctx->pool, UNKNOWN);
+    if (wire)
+        ctx->wires[ctx->wire_count++] = wire;
+    return wire;
+}
+
+static int flatten_gate(struct FlattenContext *ctx, GateType type, struct Wire *in1, struct Wire *in2,
+                        struct Wire *out)
+{
+    if (ctx->gate_count == ctx->gate_capacity)
+    {
+        size_t capacity = ctx->gate_capacity ? ctx->gate_capacity * 2 : 64;
+        struct Gate **gates = realloc(ctx->gates, capacity * sizeof(struct Gate *));
+        if (!gates)
+            return 0;
+        ctx->gates = gates;
+        ctx->gate_capacity = capacity;
+    }
+    struct Gate *gate = logic_pool_new_gate(&ctx->pool, type);
+    if (!gate)
+        return 0;
+    gate_set_input(gate, 0, in1);
+    gate_set_input(gate, 1, in2);
+    gate->output = out;
+    ctx->gates[ctx->gate_count++] = gate;
+    return 1;
+}
+
+// Expand one instance. pins: wires of the inputs then the outputs (NULL reads LOW).
+// An output net of the body becomes the pin wire itself where it can; an output
+// that is an input, LOW or already used by another output goes through a buffer.
+static void flatten_body(struct FlattenContext *ctx, const struct Component *component, struct Wire *const *pins)
+{
+    uint32_t num_inputs = (uint32_t)component->num_inputs;
+    struct Wire **map = calloc(component->num_wires, sizeof(struct Wire *));
+    if (!map)
+    {
+        ctx->failed = 1;
+        return;
+    }
+    for (uint32_t i = 0; i < num_inputs; ++i)
+        map[1 + i] = pins[i];
+    for (int i = 0; i < component->num_outputs; ++i)
+    {
+        uint32_t net = component->outputs[i];
+        if (net > num_inputs && !map[net])
+            map[net] = pins[component->num_inputs + i];
+    }
+    for (uint32_t net = 1 + num_inputs; net < component->num_wires && !ctx->failed; ++net)
+    {
+        if (!map[net] && !(map[net] = flatten_wire(ctx)))
+            ctx->failed = 1;
+    }
+
+    for (int i = 0; i < component->num_gates && !ctx->failed; ++i)
+    {
+        const struct ComponentGate *gate = &component->gates[i];
+        if (!flatten_gate(ctx, (GateType)gate->type, map[gate->in1], map[gate->in2], map[gate->out]))
+            ctx->failed = 1;
+    }
+    for (int i = 0; i < component->num_subcomponents && !ctx->failed; ++i)
+    {
+        const struct ComponentCell *cell = &component->subcomponents[i];
+        size_t pin_count = (size_t)cell->definition->num_inputs + (size_t)cell->definition->num_outputs;
+        struct Wire **cell_pins = malloc((pin_count + 1) * sizeof(struct Wire *));
+        if (!cell_pins)
+        {
+            ctx->failed = 1;
+            break;
+        }
+        for (size_t k = 0; k < pin_count; ++k)
+            cell_pins[k] = map[cell->pins[k]];
+        flatten_body(ctx, cell->definition, cell_pins);
+        free(cell_pins);
+    }
+    for (int i = 0; i < component->num_outputs && !ctx->failed; ++i)
+    {
+        struct Wire *pin = pins[component->num_inputs + i];
+        struct Wire *net = map[component->outputs[i]];
+        if (pin && net != pin && !flatten_gate(ctx, OR, net, NULL, pin))
+            ctx->failed = 1;
+    }
+    free(map);
+}
+
+int component_flatten(const struct Component *top, struct Netlist *nl, uint32_t *input_nets, uint32_t *output_nets)
+{
+    memset(nl, 0, sizeof(*nl));
+    if (!top->finalized)
+        return 0;
+
+    struct FlattenContext ctx = {0};
+    logic_pool_init(&ctx.pool);
+    size_t pin_count = (size_t)top->num_inputs + (size_t)top->num_outputs;
+    struct Wire **pins = malloc((pin_count + 1) * sizeof(struct Wire *));
+    if (!pins)
+        return 0;
+    for (size_t k = 0; k < pin_count && !ctx.failed; ++k)
+    {
+        if (!(pins[k] = flatten_wire(&ctx)))
+            ctx.failed = 1;
+    }
+    if (!ctx.failed)
+        flatten_body(&ctx, top, pins);
+
+    // The top pins are passed as extra wires so unused inputs and outputs still get a net
+    int ok = !ctx.failed && netlist_compile(nl, ctx.gates, ctx.gate_count, pins, pin_count);
+    if (ok)
+    {
+        for (int i = 0; i < top->num_inputs; ++i)
+            input_nets[i] = netlist_net_of(nl, pins[i]);
+        for (int i = 0; i < top->num_outputs; ++i)
+            output_nets[i] = netlist_net_of(nl, pins[top->num_inputs + i]);
+
+        // The wires are about to go away: drop every reference to them
+        for (size_t net = 0; net < nl->net_count; ++net)
+            nl->net_wire[net] = NULL;
+        free(nl->wire_keys);
+        free(nl->wire_nets);
+        nl->wire_keys = NULL;
+        nl->wire_nets = NULL;
+        nl->wire_table_size = 0;
+    }
+
+    // Gates and wires go together, so only the fanout lists need freeing one by one
+    for (size_t i = 0; i < ctx.wire_count; ++i)
+        wire_release(ctx.wires[i]);
+    logic_pool_free(&ctx.pool);
+    free(ctx.gates);
+    free(ctx.wires);
+    free(pins);
+    return ok;
+}
+
+static void init_state(const struct Component *component, uint8_t *state)
+{
+    memset(state, UNKNOWN, component->num_wires);
+    state[COMPONENT_NET_LOW] = LOW;
+    for (int i = 0; i < component->num_inputs; ++i)
+        state[component_input_net(component, i)] = LOW;
+    state[component->num_wires] = 0; // Not settled yet
+    for (int i = 0; i < component->num_subcomponents; ++i)
+        init_state(component->subcomponents[i].definition, state + component->subcomponents[i].state_offset);
+}
+
+int component_instance_init(struct ComponentInstance *instance, const struct Component *definition)
+{
+    instance->definition = NULL;
+    instance->state = NULL;
+    if (!definition->finalized)
+        return 0;
+    instance->state = malloc(definition->state_size);
+    if (!instance->state)
+        return 0;
+    instance->definition = definition;
+    init_state(definition, instance->state);
+    return 1;
+}
+
+void component_instance_free(struct ComponentInstance *instance)
+{
+    free(instance->state);
+    instance->state = NULL;
+    instance->definition = NULL;
+}
+
+void component_instance_set_input(struct ComponentInstance *instance, int input_index, SignalState state)
+{
+    const struct Component *definition = instance->definition;
+    if (input_index < 0 || input_index >= definition->num_inputs)
+        return;
+    uint8_t *net = &instance->state[component_input_net(definition, input_index)];
+    if (*net != (uint8_t)state)
+    {
+        *net = (uint8_t)state;
+        instance->state[definition->num_wires] = 0;
+    }
+}
+
+SignalState component_instance_get_output(const struct ComponentInstance *instance, int output_index)
+{
+    const struct Component *definition = instance->definition;
+    if (output_index < 0 || output_index >= definition->num_outputs)
+        return UNKNOWN;
+    return (SignalState)instance->state[definition->outputs[output_index]];
+}
+
+static size_t settle_state(const struct Component *component, uint8_t *state, int max_iterations)
+{
+    size_t evaluations = 0;
+    size_t node_count = (size_t)component->num_gates + (size_t)component->num_subcomponents;
+    int passes = component->cyclic ? (max_iterations > 0 ? max_iterations : 1) : 1;
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        int changed = 0;
+        for (size_t i = 0; i < node_count; ++i)
+        {
+            uint32_t k = component->order[i];
+            if (k < (uint32_t)component->num_gates)
+            {
+                const struct ComponentGate *gate = &component->gates[k];
+                uint8_t result = (uint8_t)gate_next_state((GateType)gate->type, (SignalState)state[gate->in1],
+                                                          (SignalState)state[gate->in2], (SignalState)state[gate->out]);
+                evaluations++;
+                if (state[gate->out] != result)
+                {
+                    state[gate->out] = result;
+                    changed = 1;
+                }
+                continue;
+            }
+
+            // Nested cell: copy its inputs in, settle it if they changed, copy its outputs out
+            const struct ComponentCell *cell = &component->subcomponents[k - (uint32_t)component->num_gates];
+            const struct Component *definition = cell->definition;
+            uint8_t *cell_state = state + cell->state_offset;
+            uint8_t *settled = &cell_state[definition->num_wires];
+            for (int p = 0; p < definition->num_inputs; ++p)
+            {
+                uint8_t value = state[cell->pins[p]];
+                uint8_t *input = &cell_state[component_input_net(definition, p)];
+                if (*input != value)
+                {
+                    *input = value;
+                    *settled = 0;
+                }
+            }
+            if (!*settled)
+            {
+                evaluations += settle_state(definition, cell_state, max_iterations);
+                *settled = 1;
+            }
+            for (int p = 0; p < definition->num_outputs; ++p)
+            {
+                uint8_t value = cell_state[definition->outputs[p]];
+                uint32_t net = cell->pins[definition->num_inputs + p];
+                if (state[net] != value)
+                {
+                    state[net] = value;
+                    changed = 1;
+                }
+            }
+        }
+        if (!changed)
+            break;
+    }
+    return evaluations;
+}
+
+size_t component_instance_settle(struct ComponentInstance *instance, int max_iterations)
+{
+    const struct Component *definition = instance->definition;
+    if (!definition || instance->state[definition->num_wires])
+        return 0;
+    size_t evaluations = settle_state(definition, instance->state, max_iterations);
+    instance->state[definition->num_wires] = 1;
+    return evaluations;
+}
@@ -0,0 +1,115 @@
+#ifndef COMPONENT_H
+#define COMPONENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "logic.h"
+#include "netlist.h"
+
+// Hierarchical components. A struct Component is a definition (e.g. a full adder):
+// its body of gates and nested instances is stored once, on local net numbers, and
+// compiled into an evaluation order by component_finalize. Instances share the
+// definition and only own the states of its nets, so a design built from thousands
+// of identical cells costs memory proportional to its state, not to its structure.
+//
+// Local nets: COMPONENT_NET_LOW (always LOW), then the inputs 1..num_inputs, then
+// every net created with component_add_net.
+#define COMPONENT_NET_LOW 0
+#define COMPONENT_MAX_NETS UINT32_MAX
+
+struct ComponentGate
+{
+    uint8_t type; // GateType
+    uint32_t in1; // Local nets; COMPONENT_NET_LOW when unconnected
+    uint32_t in2;
+    uint32_t out;
+};
+
+// Nested instance of another definition
+struct ComponentCell
+{
+    const struct Component *definition;
+    uint32_t *pins;      // Local nets: definition inputs first, then its outputs
+    size_t state_offset; // Where the cell's state starts inside this instance's state
+};
+
+struct Component
+{
+    char *name; // Name of the component
+
+    // Body
+    struct ComponentGate *gates;
+    int num_gates;
+    int gate_capacity;
+
+    struct ComponentCell *subcomponents;
+    int num_subcomponents;
+    int subcomponent_capacity;
+
+    uint32_t num_wires; // Local nets, including COMPONENT_NET_LOW and the inputs
+
+    // External connections
+    int num_inputs;    // Local nets 1..num_inputs
+    uint32_t *outputs; // Local net of each output
+    int num_outputs;
+
+    // Filled in by component_finalize
+    uint32_t *order;    // Evaluation order: i < num_gates is gates[i], otherwise subcomponents[i - num_gates]
+    int cyclic;         // Body has feedback: the order is repeated until nothing changes
+    size_t state_size;  // Bytes of state per instance, nested cells included
+    size_t total_gates; // Gates per instance after flattening the hierarchy
+    int finalized;
+};
+
+// A placed copy of a definition: nothing but net states
+struct ComponentInstance
+{
+    const struct Component *definition;
+    uint8_t *state; // SignalState per local net, then a settled flag, then the nested cells
+};
+
+// Definitions. Returns NULL on allocation failure.
+struct Component *component_create(const char *name, int num_inputs, int num_outputs);
+// Does not free nested definitions: they are shared and owned by whoever created them
+void component_destroy(struct Component *component);
+
+// Local net of input i (0-based), COMPONENT_MAX_NETS if out of range
+uint32_t component_input_net(const struct Component *component, int input_index);
+// New internal net; COMPONENT_MAX_NETS when the definition is full or finalized
+uint32_t component_add_net(struct Component *component);
+void component_set_output(struct Component *component, int output_index, uint32_t net);
+
+// Body. Returns 0 on allocation failure, on out-of-range nets, or after finalize.
+int component_add_gate(struct Component *component, GateType type, uint32_t in1, uint32_t in2, uint32_t out);
+// pins: definition->num_inputs nets read by the cell, then definition->num_outputs nets it drives.
+// The nested definition must be finalized.
+int component_add_instance(struct Component *component, const struct Component *definition, const uint32_t *pins);
+
+// Compute the evaluation order and the state layout. The definition cannot be
+// changed afterwards. Returns 0 on allocation failure.
+int component_finalize(struct Component *component);
+
+// Bytes used by the definition itself (body, pins, order), nested definitions excluded
+size_t component_definition_bytes(const struct Component *component);
+
+// Expand the hierarchy into one flat netlist (see netlist_compile: gates sorted by
+// rank, nets renumbered so fanout neighbours are adjacent). input_nets and
+// output_nets receive the net of every input and output of top. The netlist has no
+// editor wires behind it: net_wire is NULL throughout and netlist_net_of finds nothing.
+// Returns 0 on allocation failure or if top is not finalized.
+int component_flatten(const struct Component *top, struct Netlist *nl, uint32_t *input_nets, uint32_t *output_nets);
+
+// Instances. Nets start UNKNOWN (inputs LOW). Returns 0 on allocation failure.
+int component_instance_init(struct ComponentInstance *instance, const struct Component *definition);
+void component_instance_free(struct ComponentInstance *instance);
+
+void component_instance_set_input(struct ComponentInstance *instance, int input_index, SignalState state);
+SignalState component_instance_get_output(const struct ComponentInstance *instance, int output_index);
+
+// Evaluate the instance from its shared body. Nested cells whose inputs did not change
+// since their last evaluation are skipped; bodies with feedback repeat up to
+// max_iterations times. CLOCK and DFF gates hold their state here; flatten the
+// component to clock it (netlist_clock_edge). Returns the number of gate evaluations.
+size_t component_instance_settle(struct ComponentInstance *instance, int max_iterations);
+
+#endif // COMPONENT_H
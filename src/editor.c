@@ -1,8 +1,19 @@
 #include "editor.h"
 #include "camera.h"
 #include "render_utils.h"
+#include "thread_pool.h"
+#include "spatial_hash.h"
+#include "render_batch.h"
+#include "vlg_file.h"
+#include "netlist_opt.h"
+#include "netlist_timing.h"
+#include "waveform.h"
+#include "pool.h"
+#include "slot_map.h"
 #include <SDL3/SDL.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <stdbool.h>
 #include <math.h>
 
@@ -12,14 +23,20 @@ typedef struct EditorWire EditorWire;
 static void ensure_gates_capacity(void);
 static int find_nearest_gate_pin(float world_x, float world_y, float max_distance, int *out_gate_index, GatePinType *out_pin);
 static int hit_test_gate(float world_x, float world_y);
-static void detach_gates_from_wire(struct Wire *logic_wire);
 static void gate_pin_world(const EditorGate *eg, GatePinType pin, float *out_x, float *out_y);
-static void reassign_logic_wire(struct Wire *from, struct Wire *to);
+static bool split_net_after_delete(size_t deleted_index);
 static struct Wire *attach_wire_endpoint_to_existing(EditorWire *new_wire, size_t point_index);
 static void align_wire_endpoint_to_gate(EditorWire *w, size_t point_index, int gate_index, GatePinType pin);
 static int snap_point_to_existing_endpoint(float *x, float *y);
 static void update_gate_output_for_type(struct Gate *gate);
 static const char *gate_type_label(GateType type);
+static void editor_sync_lamps(void);
+static void invalidate_levels(void);
+static void ensure_levels(void);
+static void free_sim_netlist(void);
+static void free_timing(void);
+static void record_timed_change(size_t wire_index, SignalState state);
+static void wave_record_step(void);
 
 // Global camera instance for the editor
 static Camera editor_camera;
@@ -35,17 +52,22 @@ static WirePoint *wire_points = NULL;
 static size_t wire_point_count = 0;
 static size_t wire_point_capacity = 0;
 
+// Gates, wires, lamps and the point arrays of stored wires come from pools: creating
+// them never calls malloc for a single object, and clearing the design releases slabs
+static struct LogicPool logic_pool;
+static struct ArrayPool point_pool;
+
 // Editor-level wire that also can hold a pointer to the logic-level struct Wire
 struct EditorWire
 {
-    WirePoint *points; // dynamic array of points for this wire
+    WirePoint *points; // points of this wire, from point_pool
     size_t count;
-    size_t capacity;
-    struct Wire *logic_wire; // pointer to logic model Wire (allocated when finished)
-    // connection info: -1 = none, otherwise gate index and pin
-    int start_gate_index;
+    size_t capacity; // size class of points (array_pool_release)
+    struct Wire *logic_wire; // net node owned by this segment (joined to connected segments via wire_union)
+    // connection info: SLOT_NONE = none, otherwise the gate's handle and pin
+    SlotHandle start_gate;
     GatePinType start_pin;
-    int end_gate_index;
+    SlotHandle end_gate;
     GatePinType end_pin;
 };
 
@@ -53,6 +75,30 @@ static EditorWire *wires = NULL;
 static size_t wire_count = 0;
 static size_t wire_capacity = 0;
 
+// Segment owning each net node, by the node's state slot (register_wire_node), so the
+// ring of nodes of a net leads back to its segments
+static SlotHandle *node_owner = NULL;
+static size_t node_owner_capacity = 0;
+
+// Scratch space of split_net_after_delete, grown on demand and kept between deletes
+static size_t *split_members = NULL;
+static size_t split_member_capacity = 0;
+static struct Gate **split_readers = NULL;
+static size_t split_reader_capacity = 0;
+static struct Gate **split_drivers = NULL;
+static size_t split_driver_capacity = 0;
+static uint64_t *split_table_keys = NULL;
+static size_t split_table_key_capacity = 0;
+static struct Wire **split_table_nodes = NULL;
+static size_t split_table_node_capacity = 0;
+
+// Handles of the gates, wires and lamps. The arrays stay dense: deleting swaps the
+// last object into the hole (remove_gate_at and friends), so anything kept across
+// edits (selection, wire-to-gate links) holds a handle rather than an index.
+static struct SlotMap gate_slots;
+static struct SlotMap wire_slots;
+static struct SlotMap lamp_slots;
+
 // Lamps
 typedef struct
 {
@@ -74,17 +120,111 @@ static const float GATE_PIN_SNAP_RADIUS = 16.0f;
 static const float WIRE_ENDPOINT_MERGE_RADIUS = 3.5f;
 static TTF_Font *gate_label_font = NULL;
 
+// Event-driven simulation: gates whose inputs changed wait here until the next sim_run
+static struct SimQueue sim_queue;
+// Upper bound of evaluations per gate and settle pass (keeps oscillating loops from hanging)
+static const size_t SIM_MAX_EVALS_PER_GATE = 64;
+// Cached topological order of the gates; rebuilt lazily after wiring edits
+static struct Levelization sim_levels;
+// Incremental re-simulation: an edit marks the nets whose value, drivers or readers it
+// changed and the gates whose function it changed, and resimulate_dirty re-evaluates
+// the fanout cone of those on the event queue, nothing else. The queue orders gates by
+// the last levelization, so edits never wait for a new one; gates it does not know
+// share the last rank, which can only cost a repeated evaluation.
+static struct Wire **dirty_nets = NULL;
+static size_t dirty_net_count = 0;
+static size_t dirty_net_capacity = 0;
+static struct Gate **dirty_gates = NULL;
+static size_t dirty_gate_count = 0;
+static size_t dirty_gate_capacity = 0;
+static bool dirty_overflow = false; // A mark did not fit: settle the whole design
+static size_t edit_evaluations = 0; // Gates evaluated for the last edit or full settle
+// Large designs settle on the compiled netlist, simplified first and spread over a
+// thread pool. Every net with a wire is kept, so the drawing still shows every value.
+// The compiled netlist is two-valued: designs with buses (nets with several drivers,
+// tri-state buffers) or with X or Z sources settle on the gates instead, which resolve
+// and count contention and propagate X like any smaller design.
+static const size_t PARALLEL_SETTLE_MIN_GATES = 50000;
+static struct Netlist sim_netlist;
+static struct Netlist sim_optimized;
+static uint32_t *sim_net_map = NULL; // sim_netlist net -> sim_optimized net
+static bool sim_netlist_valid = false;
+static bool sim_netlist_has_bus = false;
+static PatternWord *sim_net_words = NULL;
+static ThreadPool *sim_pool = NULL;
+
+// Clocked simulation (sim_clock_edge on the levelized gate order). While the clock
+// runs freely, every frame spends up to CLOCK_FRAME_BUDGET_NS on cycles; the rate
+// shown is measured over about one second.
+static bool clock_running = false;
+static uint64_t clock_cycles = 0;
+static uint64_t clock_rate_cycles = 0; // Cycles since clock_rate_start
+static Uint64 clock_rate_start = 0;
+static double clock_rate = 0.0;
+static const Uint64 CLOCK_FRAME_BUDGET_NS = 8000000;
+
+// Status overlay text of the counters that can change every frame, refreshed at 4 Hz
+static const Uint64 STATUS_REFRESH_NS = 250000000;
+static Uint64 status_refresh_time = 0;
+static char clock_status[64];
+static char wave_status[64];
+
+// Timing view: gates and wires on the critical path (netlist_timing_analyze), and the
+// wires that glitched when an input was last changed with the view on (netlist_wheel).
+// Rebuilt lazily, like the levelization, after edits.
+enum
+{
+    TIMING_CRITICAL = 1,
+    TIMING_GLITCH = 2
+};
+static bool timing_view = false;
+static bool timing_valid = false;
+static struct TimingModel timing_model;
+static struct Netlist timing_netlist;
+static struct EditorNetlistIds timing_ids;
+static uint32_t timing_critical_delay = 0;
+static size_t timing_path_length = 0;
+static uint8_t *timing_gate_flags = NULL; // Per editor gate (timing_ids.gate_count)
+static uint8_t *timing_wire_flags = NULL; // Per editor wire (timing_ids.wire_count)
+static bool timing_change_shown = false;  // A timed input change has been recorded
+static size_t timing_glitches = 0;
+static uint64_t timing_settle = 0;
+
+// Waveform recording (editor_waveform_start): every net with a wire, named after its
+// first wire, sampled once per simulation step and per clock edge. Wiring edits stop
+// it, since the nets it follows may be gone.
+static bool wave_recording = false;
+static struct WaveformRecorder wave_rec;
+static struct Wire **wave_wires = NULL; // Wire each signal reads
+static uint64_t wave_time = 0;
+
+// Spatial indexes for hit testing and snapping, keyed by array index. Cells span
+// SPATIAL_CELL_GRID_UNITS grid rectangles; wires are registered per segment.
+static const int SPATIAL_CELL_GRID_UNITS = 8;
+static struct SpatialHash gate_grid;
+static struct SpatialHash wire_grid;
+static struct SpatialHash lamp_grid;
+// editor_render only draws what the indexes report inside the viewport, widened by
+// this many screen pixels for pin markers, lamp squares and gate labels
+static const float RENDER_CULL_MARGIN_PX = 48.0f;
+static uint32_t *visible_ids = NULL;
+static size_t visible_capacity = 0;
+// Sorted results of collect_near, kept between calls (pin lookups run on every mouse move)
+static uint32_t *near_ids = NULL;
+static size_t near_capacity = 0;
+// Shapes of the current render layer, submitted with one SDL_RenderGeometry call
+static RenderBatch editor_batch;
+
 // Selection
 typedef enum
 {
     SELECT_NONE = 0,
     SELECT_WIRE = 1,
-    SELECT_LAMP = 2
+    SELECT_LAMP = 2,
+    SELECT_GATE = 3
 } SelectionType;
 static SelectionType selected_type = SELECT_NONE;
-static int selected_index = -1;
-// Extend enum to include gates
-// (keep backward compatibility by reusing same values)
+static SlotHandle selected_handle = SLOT_NONE;
 
 // Wire placement state
 static bool wire_active = false;     // Whether a wire is currently being placed
@@ -99,6 +239,19 @@ int rectangle_h = 10; // Height of grid rectangles in pixels (world space)
 void editor_init(void)
 {
     camera_init(&editor_camera);
+    sim_queue_init(&sim_queue);
+    float cell_w = (float)(rectangle_w * SPATIAL_CELL_GRID_UNITS);
+    float cell_h = (float)(rectangle_h * SPATIAL_CELL_GRID_UNITS);
+    spatial_hash_init(&gate_grid, cell_w, cell_h);
+    spatial_hash_init(&wire_grid, cell_w, cell_h);
+    spatial_hash_init(&lamp_grid, cell_w, cell_h);
+    render_batch_init(&editor_batch);
+    timing_model_default(&timing_model);
+    logic_pool_init(&logic_pool);
+    array_pool_init(&point_pool, sizeof(WirePoint));
+    slot_map_init(&gate_slots);
+    slot_map_init(&wire_slots);
+    slot_map_init(&lamp_slots);
 }
 
 Camera *editor_get_camera(void)
@@ -121,6 +274,43 @@ static void ensure_wire_capacity(void)
     }
 }
 
+// Grow *array to at least needed elements of elem_size bytes. It never shrinks, so
+// buffers used on every edit stop allocating once they are large enough.
+static bool reserve_array(void **array, size_t *capacity, size_t needed, size_t elem_size)
+{
+    if (needed <= *capacity)
+        return true;
+    size_t grown_capacity = (*capacity < 16) ? 16 : *capacity;
+    while (grown_capacity < needed)
+        grown_capacity *= 2;
+    void *grown = realloc(*array, grown_capacity * elem_size);
+    if (!grown)
+        return false;
+    *array = grown;
+    *capacity = grown_capacity;
+    return true;
+}
+
+// Record wires[i] as the owner of its net node. Returns false on allocation failure.
+static bool register_wire_node(size_t i)
+{
+    struct Wire *node = wires[i].logic_wire;
+    if (!node)
+        return true;
+    if (!reserve_array((void **)&node_owner, &node_owner_capacity, (size_t)node->state_slot + 1, sizeof(SlotHandle)))
+        return false;
+    node_owner[node->state_slot] = slot_map_handle(&wire_slots, i);
+    return true;
+}
+
+// Index of the segment owning a net node, SLOT_MAP_NO_INDEX if none
+static size_t node_owner_index(const struct Wire *node)
+{
+    if (node->state_slot >= node_owner_capacity)
+        return SLOT_MAP_NO_INDEX;
+    return slot_map_index(&wire_slots, node_owner[node->state_slot]);
+}
+
 static void ensure_wires_capacity(void)
 {
     if (wire_count >= wire_capacity)
@@ -130,6 +320,67 @@ static void ensure_wires_capacity(void)
     }
 }
 
+static void mark_net_dirty(struct Wire *wire)
+{
+    if (!wire)
+        return;
+    if (dirty_net_count == dirty_net_capacity)
+    {
+        size_t new_capacity = dirty_net_capacity == 0 ? 16 : dirty_net_capacity * 2;
+        struct Wire **grown = realloc(dirty_nets, new_capacity * sizeof(struct Wire *));
+        if (!grown)
+        {
+            dirty_overflow = true;
+            return;
+        }
+        dirty_nets = grown;
+        dirty_net_capacity = new_capacity;
+    }
+    dirty_nets[dirty_net_count++] = wire;
+}
+
+static void mark_gate_dirty(struct Gate *gate)
+{
+    if (!gate)
+        return;
+    if (dirty_gate_count == dirty_gate_capacity)
+    {
+        size_t new_capacity = dirty_gate_capacity == 0 ? 16 : dirty_gate_capacity * 2;
+        struct Gate **grown = realloc(dirty_gates, new_capacity * sizeof(struct Gate *));
+        if (!grown)
+        {
+            dirty_overflow = true;
+            return;
+        }
+        dirty_gates = grown;
+        dirty_gate_capacity = new_capacity;
+    }
+    dirty_gates[dirty_gate_count++] = gate;
+}
+
+// Re-evaluate the dirty gates and the readers of the dirty nets, then whatever their
+// changes reach. Nets are marked by wire and looked up here, so merges and splits
+// after marking do not matter.
+static void resimulate_dirty(void)
+{
+    if (dirty_overflow)
+    {
+        dirty_net_count = 0;
+        dirty_gate_count = 0;
+        dirty_overflow = false;
+        editor_propagate_signals();
+        return;
+    }
+    for (size_t i = 0; i < dirty_gate_count; ++i)
+        sim_schedule_gate(&sim_queue, dirty_gates[i]);
+    for (size_t i = 0; i < dirty_net_count; ++i)
+        sim_schedule_fanout(&sim_queue, dirty_nets[i]);
+    dirty_gate_count = 0;
+    dirty_net_count = 0;
+    edit_evaluations = sim_run(&sim_queue, (gate_count + 1) * SIM_MAX_EVALS_PER_GATE);
+    editor_sync_lamps();
+}
+
 static void ensure_lamps_capacity(void)
 {
     if (lamp_count >= lamp_capacity)
@@ -146,37 +397,171 @@ static float distance_sq(float ax, float ay, float bx, float by)
     return dx * dx + dy * dy;
 }
 
+// Spatial index maintenance: call index_* once an object's geometry is final,
+// unindex_* before it changes or the object is removed, and relocate_* once the
+// object has moved from index from to index i of its array
+typedef enum
+{
+    SPATIAL_INSERT,
+    SPATIAL_REMOVE,
+    SPATIAL_RELOCATE
+} SpatialOp;
+
+static void index_gate(size_t i)
+{
+    const EditorGate *g = &gates[i];
+    spatial_hash_insert(&gate_grid, (uint32_t)i, g->x, g->y, g->x + g->width, g->y + g->height);
+}
+
+static void unindex_gate(size_t i)
+{
+    const EditorGate *g = &gates[i];
+    spatial_hash_remove(&gate_grid, (uint32_t)i, g->x, g->y, g->x + g->width, g->y + g->height);
+}
+
+static void relocate_gate(size_t from, size_t i)
+{
+    const EditorGate *g = &gates[i];
+    spatial_hash_relocate(&gate_grid, (uint32_t)from, (uint32_t)i, g->x, g->y, g->x + g->width, g->y + g->height);
+}
+
+static void wire_segment_apply(size_t i, SpatialOp op, size_t from)
+{
+    const EditorWire *w = &wires[i];
+    for (size_t s = 0; s < w->count; ++s)
+    {
+        // Single-point wires still get one box so their endpoint can be found
+        if (s + 1 == w->count && w->count > 1)
+            break;
+        const WirePoint *a = &w->points[s];
+        const WirePoint *b = (s + 1 < w->count) ? &w->points[s + 1] : a;
+        float x0 = fminf(a->x, b->x), x1 = fmaxf(a->x, b->x);
+        float y0 = fminf(a->y, b->y), y1 = fmaxf(a->y, b->y);
+        if (op == SPATIAL_INSERT)
+            spatial_hash_insert(&wire_grid, (uint32_t)i, x0, y0, x1, y1);
+        else if (op == SPATIAL_REMOVE)
+            spatial_hash_remove(&wire_grid, (uint32_t)i, x0, y0, x1, y1);
+        else
+            spatial_hash_relocate(&wire_grid, (uint32_t)from, (uint32_t)i, x0, y0, x1, y1);
+    }
+}
+
+static void index_wire(size_t i)
+{
+    wire_segment_apply(i, SPATIAL_INSERT, i);
+}
+
+static void unindex_wire(size_t i)
+{
+    wire_segment_apply(i, SPATIAL_REMOVE, i);
+}
+
+static void relocate_wire(size_t from, size_t i)
+{
+    wire_segment_apply(i, SPATIAL_RELOCATE, from);
+}
+
+static void index_lamp(size_t i)
+{
+    const EditorLamp *l = &lamps[i];
+    spatial_hash_insert(&lamp_grid, (uint32_t)i, l->x - l->radius, l->y - l->radius, l->x + l->radius, l->y + l->radius);
+}
+
+static void unindex_lamp(size_t i)
+{
+    const EditorLamp *l = &lamps[i];
+    spatial_hash_remove(&lamp_grid, (uint32_t)i, l->x - l->radius, l->y - l->radius, l->x + l->radius, l->y + l->radius);
+}
+
+static void relocate_lamp(size_t from, size_t i)
+{
+    const EditorLamp *l = &lamps[i];
+    spatial_hash_relocate(&lamp_grid, (uint32_t)from, (uint32_t)i, l->x - l->radius, l->y - l->radius,
+                          l->x + l->radius, l->y + l->radius);
+}
+
+// Candidates whose cells overlap the square of half-size radius around (x, y)
+static size_t query_near(struct SpatialHash *grid, float x, float y, float radius, const uint32_t **out_ids)
+{
+    return spatial_hash_query(grid, x - radius, y - radius, x + radius, y + radius, out_ids);
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Indexed objects whose cells overlap the square of half-size radius around (x, y),
+// sorted by index so ties resolve as a scan over the array would. Results live in
+// near_ids until the next call.
+static size_t collect_near(struct SpatialHash *grid, float x, float y, float radius)
+{
+    const uint32_t *ids;
+    size_t n = query_near(grid, x, y, radius, &ids);
+    if (!reserve_array((void **)&near_ids, &near_capacity, n, sizeof(uint32_t)))
+        return 0;
+    memcpy(near_ids, ids, n * sizeof(uint32_t));
+    qsort(near_ids, n, sizeof(uint32_t), compare_u32);
+    return n;
+}
+
+// Indexed objects overlapping the world box, sorted so the draw order matches the arrays.
+// Results live in visible_ids until the next call.
+static size_t collect_visible(struct SpatialHash *grid, float left, float top, float right, float bottom)
+{
+    const uint32_t *ids;
+    size_t n = spatial_hash_query(grid, left, top, right, bottom, &ids);
+    if (n > visible_capacity)
+    {
+        uint32_t *grown = realloc(visible_ids, n * sizeof(uint32_t));
+        if (!grown)
+            return 0;
+        visible_ids = grown;
+        visible_capacity = n;
+    }
+    memcpy(visible_ids, ids, n * sizeof(uint32_t));
+    qsort(visible_ids, n, sizeof(uint32_t), compare_u32);
+    return n;
+}
+
+// Lowest-index lamp within max_distance of the point
 static EditorLamp *find_lamp_near_point(float world_x, float world_y, float max_distance)
 {
     float max_sq = max_distance * max_distance;
-    for (size_t i = 0; i < lamp_count; ++i)
+    const uint32_t *ids;
+    size_t n = query_near(&lamp_grid, world_x, world_y, max_distance, &ids);
+    size_t best = lamp_count;
+    for (size_t k = 0; k < n; ++k)
     {
-        if (distance_sq(world_x, world_y, lamps[i].x, lamps[i].y) <= max_sq)
-        {
-            return &lamps[i];
-        }
+        size_t i = ids[k];
+        if (i < best && distance_sq(world_x, world_y, lamps[i].x, lamps[i].y) <= max_sq)
+            best = i;
     }
-    return NULL;
+    return best < lamp_count ? &lamps[best] : NULL;
 }
 
+// Lowest-index wire with an endpoint within max_distance of the point
 static EditorWire *find_wire_endpoint_near(float world_x, float world_y, float max_distance)
 {
     float max_sq = max_distance * max_distance;
-    for (size_t i = 0; i < wire_count; ++i)
+    const uint32_t *ids;
+    size_t n = query_near(&wire_grid, world_x, world_y, max_distance, &ids);
+    size_t best = wire_count;
+    for (size_t k = 0; k < n; ++k)
     {
+        size_t i = ids[k];
         EditorWire *w = &wires[i];
-        if (w->count == 0)
+        if (i >= best || w->count == 0)
             continue;
-        if (distance_sq(world_x, world_y, w->points[0].x, w->points[0].y) <= max_sq)
-        {
-            return w;
-        }
-        if (w->count > 1 && distance_sq(world_x, world_y, w->points[w->count - 1].x, w->points[w->count - 1].y) <= max_sq)
+        if (distance_sq(world_x, world_y, w->points[0].x, w->points[0].y) <= max_sq ||
+            (w->count > 1 && distance_sq(world_x, world_y, w->points[w->count - 1].x, w->points[w->count - 1].y) <= max_sq))
         {
-            return w;
+            best = i;
         }
     }
-    return NULL;
+    return best < wire_count ? &wires[best] : NULL;
 }
 
 static void connect_lamp_to_wire(EditorLamp *lamp, EditorWire *wire)
@@ -184,7 +569,7 @@ static void connect_lamp_to_wire(EditorLamp *lamp, EditorWire *wire)
     if (!lamp || !lamp->logic_lamp || !wire || !wire->logic_wire)
         return;
     lamp->logic_lamp->input = wire->logic_wire;
-    lamp->logic_lamp->state = wire->logic_wire->state;
+    lamp->logic_lamp->state = wire_state(wire_find(wire->logic_wire));
 }
 
 static void connect_wire_endpoints_to_lamps(EditorWire *wire)
@@ -222,37 +607,22 @@ static void connect_lamp_to_nearby_wire(EditorLamp *lamp)
     }
 }
 
-static void detach_lamps_from_wire(struct Wire *logic_wire)
-{
-    if (!logic_wire)
-        return;
-    for (size_t i = 0; i < lamp_count; ++i)
-    {
-        if (!lamps[i].logic_lamp)
-            continue;
-        if (lamps[i].logic_lamp->input == logic_wire)
-        {
-            lamps[i].logic_lamp->input = NULL;
-            lamps[i].logic_lamp->state = UNKNOWN;
-        }
-    }
-}
-
 static void update_gate_output_for_type(struct Gate *gate)
 {
     if (!gate || !gate->output)
         return;
     if (gate->type == CONSTANT_HIGH)
     {
-        gate->output->state = HIGH;
+        gate_drive(gate, HIGH);
     }
-    else if (gate->type == CONSTANT_LOW)
+    else if (gate->type == CONSTANT_LOW || gate_is_clocked(gate->type))
     {
-        gate->output->state = LOW;
+        // Clocks and flip-flops start LOW and only change on clock edges
+        gate_drive(gate, LOW);
     }
     else
     {
-        gate->output->state = UNKNOWN;
+        gate_drive(gate, UNKNOWN);
     }
 }
 
@@ -278,6 +648,14 @@ static const char *gate_type_label(GateType type)
         return "XOR";
     case XNOR:
         return "XNOR";
+    case CLOCK:
+        return "CLK";
+    case DFF:
+        return "DFF";
+    case LATCH:
+        return "LATCH";
+    case TRISTATE:
+        return "TRI";
     default:
         return "?";
     }
@@ -328,46 +706,6 @@ static void align_wire_endpoint_to_gate(EditorWire *w, size_t point_index, int g
     w->points[point_index].y = py;
 }
 
-static void reassign_logic_wire(struct Wire *from, struct Wire *to)
-{
-    if (!from || !to || from == to)
-        return;
-
-    if (to->state == UNKNOWN && from->state != UNKNOWN)
-    {
-        to->state = from->state;
-    }
-    else if (to->state != UNKNOWN && from->state != UNKNOWN && to->state != from->state)
-    {
-        to->state = UNKNOWN;
-    }
-
-    for (size_t i = 0; i < wire_count; ++i)
-    {
-        if (wires[i].logic_wire == from)
-            wires[i].logic_wire = to;
-    }
-    for (size_t i = 0; i < lamp_count; ++i)
-    {
-        if (lamps[i].logic_lamp && lamps[i].logic_lamp->input == from)
-            lamps[i].logic_lamp->input = to;
-    }
-    for (size_t i = 0; i < gate_count; ++i)
-    {
-        struct Gate *gate = gates[i].gate;
-        if (!gate)
-            continue;
-        if (gate->input1 == from)
-            gate->input1 = to;
-        if (gate->input2 == from)
-            gate->input2 = to;
-        if (gate->output == from)
-            gate->output = to;
-    }
-
-    free(from);
-}
-
 static struct Wire *attach_wire_endpoint_to_existing(EditorWire *new_wire, size_t point_index)
 {
     if (!new_wire || point_index >= new_wire->count)
@@ -450,6 +788,8 @@ int editor_is_gate_placement_active(void)
 void editor_create_gate(float world_x, float world_y)
 {
     ensure_gates_capacity();
+    if (slot_map_insert(&gate_slots) == SLOT_NONE)
+        return;
     int sx, sy;
     snap_to_grid(world_x, world_y, &sx, &sy);
     EditorGate *g = &gates[gate_count++];
@@ -457,19 +797,16 @@ void editor_create_gate(float world_x, float world_y)
     g->y = (float)sy;
     g->width = 20.0f;
     g->height = 14.0f;
-    g->gate = malloc(sizeof(struct Gate));
-    if (g->gate)
-    {
-        g->gate->type = CONSTANT_LOW; // default off
-        g->gate->input1 = NULL;
-        g->gate->input2 = NULL;
-        g->gate->output = NULL;
-    }
+    g->gate = logic_pool_new_gate(&logic_pool, CONSTANT_LOW); // default off
+    index_gate(gate_count - 1);
+    invalidate_levels();
     // try to connect to nearby wires (attach any nearby wire endpoints to this gate pins)
-    // check nearby wire endpoints and connect if within connection radius
-    for (size_t i = 0; i < wire_count; ++i)
+    // check nearby wire endpoints and connect if within connection radius, in wire order
+    size_t candidate_count = collect_near(&wire_grid, (float)sx, (float)sy, GATE_PIN_SNAP_RADIUS);
+    const uint32_t *candidates = near_ids;
+    for (size_t k = 0; k < candidate_count && g->gate; ++k)
     {
-        EditorWire *w = &wires[i];
+        EditorWire *w = &wires[candidates[k]];
         if (!w || w->count == 0) continue;
         // check start
         float sxw = w->points[0].x;
@@ -478,9 +815,9 @@ void editor_create_gate(float world_x, float world_y)
         {
             // attach as input1 if free, else input2
             if (g->gate->input1 == NULL)
-                g->gate->input1 = w->logic_wire;
+                gate_set_input(g->gate, PIN_INPUT1, w->logic_wire);
             else if (g->gate->input2 == NULL)
-                g->gate->input2 = w->logic_wire;
+                gate_set_input(g->gate, PIN_INPUT2, w->logic_wire);
         }
         // check end
         if (w->count > 1)
@@ -490,13 +827,15 @@ void editor_create_gate(float world_x, float world_y)
             if (distance_sq((float)sx, (float)sy, exw, eyw) <= GATE_PIN_SNAP_RADIUS * GATE_PIN_SNAP_RADIUS)
             {
                 if (g->gate->input1 == NULL)
-                    g->gate->input1 = w->logic_wire;
+                    gate_set_input(g->gate, PIN_INPUT1, w->logic_wire);
                 else if (g->gate->input2 == NULL)
-                    g->gate->input2 = w->logic_wire;
+                    gate_set_input(g->gate, PIN_INPUT2, w->logic_wire);
             }
         }
     }
     switch_placement_active = false;
+    mark_gate_dirty(g->gate);
+    resimulate_dirty();
 }
 
 // Start a new wire
@@ -548,65 +887,36 @@ void wire_placement_finish(void)
         return;
     wire_active = false;
     // Convert current wire_points array into a Wire and store it
-    if (wire_point_count > 0)
+    if (wire_point_count > 0 && slot_map_insert(&wire_slots) != SLOT_NONE)
     {
         ensure_wires_capacity();
         EditorWire *w = &wires[wire_count];
         w->count = wire_point_count;
-        w->capacity = wire_point_count;
-        w->points = malloc(sizeof(WirePoint) * w->capacity);
+        w->points = array_pool_alloc(&point_pool, wire_point_count, &w->capacity);
         for (size_t i = 0; i < wire_point_count; ++i)
         {
             w->points[i] = wire_points[i];
         }
-        // allocate logic-level wire and default state
-        w->logic_wire = malloc(sizeof(struct Wire));
-        if (w->logic_wire)
+        // allocate logic-level wire and default state; every segment owns its own
+        // net node and is joined to whatever it touches with wire_union
+        w->logic_wire = logic_pool_new_wire(&logic_pool, HIGH_Z);
+        if (!register_wire_node(wire_count))
         {
-            w->logic_wire->state = UNKNOWN;
+            logic_pool_delete_wire(&logic_pool, w->logic_wire);
+            w->logic_wire = NULL;
         }
-        w->start_gate_index = -1;
-        w->end_gate_index = -1;
+        w->start_gate = SLOT_NONE;
+        w->end_gate = SLOT_NONE;
         w->start_pin = PIN_OUTPUT;
         w->end_pin = PIN_OUTPUT;
 
-        struct Wire *base_logic = w->logic_wire;
         struct Wire *start_logic = attach_wire_endpoint_to_existing(w, 0);
         if (start_logic)
-        {
-            if (base_logic && base_logic != start_logic)
-            {
-                free(base_logic);
-                base_logic = start_logic;
-            }
-            w->logic_wire = start_logic;
-            base_logic = start_logic;
-        }
+            wire_union(w->logic_wire, start_logic);
 
         struct Wire *end_logic = attach_wire_endpoint_to_existing(w, w->count > 0 ? w->count - 1 : 0);
         if (end_logic)
-        {
-            if (!base_logic)
-            {
-                base_logic = end_logic;
-                w->logic_wire = end_logic;
-            }
-            else if (end_logic != base_logic)
-            {
-                reassign_logic_wire(end_logic, base_logic);
-            }
-            base_logic = w->logic_wire;
-        }
-
-        if (!w->logic_wire)
-        {
-            w->logic_wire = malloc(sizeof(struct Wire));
-            if (w->logic_wire)
-            {
-                w->logic_wire->state = UNKNOWN;
-                base_logic = w->logic_wire;
-            }
-        }
+            wire_union(w->logic_wire, end_logic);
 
     // Also try to connect to nearby gates (endpoints)
         // find gates near start/end and attach as inputs/outputs using simple heuristics
@@ -622,79 +932,54 @@ void wire_placement_finish(void)
             if (find_nearest_gate_pin(sx, sy, GATE_PIN_SNAP_RADIUS, &gate_idx, &pin))
             {
                 // attach this wire to that gate pin
-                if (pin == PIN_INPUT1)
-                {
-                    gates[gate_idx].gate->input1 = w->logic_wire;
-                }
-                else if (pin == PIN_INPUT2)
+                if (pin == PIN_INPUT1 || pin == PIN_INPUT2)
                 {
-                    gates[gate_idx].gate->input2 = w->logic_wire;
+                    gate_set_input(gates[gate_idx].gate, pin, w->logic_wire);
                 }
                 else if (pin == PIN_OUTPUT)
                 {
                     struct Wire *existing_output = gates[gate_idx].gate->output;
-                    if (existing_output && existing_output != w->logic_wire)
-                    {
-                        struct Wire *target = w->logic_wire ? w->logic_wire : existing_output;
-                        if (w->logic_wire && existing_output)
-                        {
-                            reassign_logic_wire(w->logic_wire, existing_output);
-                            target = existing_output;
-                        }
-                        w->logic_wire = target;
-                        base_logic = w->logic_wire;
-                    }
-                    gates[gate_idx].gate->output = w->logic_wire;
+                    if (existing_output)
+                        wire_union(w->logic_wire, existing_output);
+                    else
+                        gate_set_output(gates[gate_idx].gate, w->logic_wire);
                     update_gate_output_for_type(gates[gate_idx].gate);
+                    mark_gate_dirty(gates[gate_idx].gate);
                 }
                 align_wire_endpoint_to_gate(w, 0, gate_idx, pin);
-                w->start_gate_index = gate_idx;
+                w->start_gate = slot_map_handle(&gate_slots, (size_t)gate_idx);
                 w->start_pin = pin;
             }
-            else
-            {
-                w->start_gate_index = -1;
-            }
 
             if (find_nearest_gate_pin(ex, ey, GATE_PIN_SNAP_RADIUS, &gate_idx, &pin))
             {
-                if (pin == PIN_INPUT1)
+                if (pin == PIN_INPUT1 || pin == PIN_INPUT2)
                 {
-                    gates[gate_idx].gate->input1 = w->logic_wire;
-                }
-                else if (pin == PIN_INPUT2)
-                {
-                    gates[gate_idx].gate->input2 = w->logic_wire;
+                    gate_set_input(gates[gate_idx].gate, pin, w->logic_wire);
                 }
                 else if (pin == PIN_OUTPUT)
                 {
                     struct Wire *existing_output = gates[gate_idx].gate->output;
-                    if (existing_output && existing_output != w->logic_wire)
-                    {
-                        struct Wire *target = w->logic_wire ? w->logic_wire : existing_output;
-                        if (w->logic_wire && existing_output)
-                        {
-                            reassign_logic_wire(w->logic_wire, existing_output);
-                            target = existing_output;
-                        }
-                        w->logic_wire = target;
-                        base_logic = w->logic_wire;
-                    }
-                    gates[gate_idx].gate->output = w->logic_wire;
+                    if (existing_output)
+                        wire_union(w->logic_wire, existing_output);
+                    else
+                        gate_set_output(gates[gate_idx].gate, w->logic_wire);
                     update_gate_output_for_type(gates[gate_idx].gate);
+                    mark_gate_dirty(gates[gate_idx].gate);
                 }
                 align_wire_endpoint_to_gate(w, w->count - 1, gate_idx, pin);
-                w->end_gate_index = gate_idx;
+                w->end_gate = slot_map_handle(&gate_slots, (size_t)gate_idx);
                 w->end_pin = pin;
             }
-            else
-            {
-                w->end_gate_index = -1;
-            }
         }
 
         connect_wire_endpoints_to_lamps(w);
         wire_count++;
+        index_wire(wire_count - 1);
+        invalidate_levels();
+        // The joined net may have new drivers and readers
+        mark_net_dirty(w->logic_wire);
+        resimulate_dirty();
     }
     // clear temporary placement buffer but keep stored wires
     if (wire_points)
@@ -728,7 +1013,7 @@ int wire_placement_is_active(void)
 void wire_placement_render(SDL_Renderer *renderer, const Camera *camera)
 {
     // Render all stored wire points and preview segments
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    const SDL_Color point_color = {255, 255, 255, 255};
 
     // Draw points (small squares) and connecting lines
     for (size_t i = 0; i < wire_point_count; i++)
@@ -736,14 +1021,14 @@ void wire_placement_render(SDL_Renderer *renderer, const Camera *camera)
         float sx, sy;
         camera_world_to_screen(camera, wire_points[i].x, wire_points[i].y, &sx, &sy);
         // Draw small 3x3 square for visibility
-        SDL_RenderFillRect(renderer, &(SDL_FRect){sx - 1.5f, sy - 1.5f, 3.0f, 3.0f});
+        render_batch_fill_rect(&editor_batch, &(SDL_FRect){sx - 1.5f, sy - 1.5f, 3.0f, 3.0f}, point_color);
 
         // Draw line to next point
         if (i + 1 < wire_point_count)
         {
             float nx, ny;
             camera_world_to_screen(camera, wire_points[i + 1].x, wire_points[i + 1].y, &nx, &ny);
-            SDL_RenderLine(renderer, sx, sy, nx, ny);
+            render_batch_line(&editor_batch, sx, sy, nx, ny, 1.0f, point_color);
         }
     }
 
@@ -760,13 +1045,12 @@ void wire_placement_render(SDL_Renderer *renderer, const Camera *camera)
         camera_world_to_screen(camera, (float)snap_x, (float)snap_y, &px, &py);
 
         // dashed line could be implemented later - for now a simple line
-        SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255);
-        SDL_RenderLine(renderer, sx, sy, px, py);
+        const SDL_Color preview_color = {200, 200, 200, 255};
+        render_batch_line(&editor_batch, sx, sy, px, py, 1.0f, preview_color);
         // draw preview point
-        SDL_RenderFillRect(renderer, &(SDL_FRect){px - 1.5f, py - 1.5f, 3.0f, 3.0f});
-        // reset color
-        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+        render_batch_fill_rect(&editor_batch, &(SDL_FRect){px - 1.5f, py - 1.5f, 3.0f, 3.0f}, preview_color);
     }
+    render_batch_flush(&editor_batch, renderer);
 }
 
 void wire_placement_clear(void)
@@ -784,34 +1068,51 @@ void wire_placement_clear(void)
 // Helper: free all stored wires
 static void free_all_wires(void)
 {
-    for (size_t i = 0; i < wire_count; ++i)
+    for (size_t i = 0; i < lamp_count; ++i)
     {
-        free(wires[i].points);
-        if (wires[i].logic_wire)
+        if (lamps[i].logic_lamp)
         {
-            detach_lamps_from_wire(wires[i].logic_wire);
-            free(wires[i].logic_wire);
+            lamps[i].logic_lamp->input = NULL;
+            lamps[i].logic_lamp->state = UNKNOWN;
         }
     }
+    // Each segment owns exactly one net node; the nodes and points go with their pools
+    for (size_t i = 0; i < wire_count; ++i)
+    {
+        if (wires[i].logic_wire)
+            wire_release(wires[i].logic_wire);
+    }
+    pool_free(&logic_pool.wires);
+    array_pool_free(&point_pool);
     free(wires);
     wires = NULL;
     wire_count = 0;
     wire_capacity = 0;
-    selected_type = SELECT_NONE;
-    selected_index = -1;
+    slot_map_clear(&wire_slots);
+    spatial_hash_clear(&wire_grid);
 }
 
 static void free_all_lamps(void)
 {
-    for (size_t i = 0; i < lamp_count; ++i)
-    {
-        if (lamps[i].logic_lamp)
-            free(lamps[i].logic_lamp);
-    }
+    pool_free(&logic_pool.lamps);
     free(lamps);
     lamps = NULL;
     lamp_count = 0;
     lamp_capacity = 0;
+    slot_map_clear(&lamp_slots);
+    spatial_hash_clear(&lamp_grid);
+}
+
+static void free_all_gates(void)
+{
+    pool_free(&logic_pool.gates);
+    free(gates);
+    gates = NULL;
+    gate_count = 0;
+    gate_capacity = 0;
+    slot_map_clear(&gate_slots);
+    spatial_hash_clear(&gate_grid);
+    invalidate_levels();
 }
 
 void editor_shutdown(void)
@@ -820,16 +1121,54 @@ void editor_shutdown(void)
     free_all_wires();
     free_all_lamps();
     lamp_placement_active = false;
-    // free gates
-    for (size_t i = 0; i < gate_count; ++i)
-    {
-        if (gates[i].gate)
-            free(gates[i].gate);
-    }
-    free(gates);
-    gates = NULL;
-    gate_count = 0;
-    gate_capacity = 0;
+    free_all_gates();
+    spatial_hash_free(&gate_grid);
+    spatial_hash_free(&wire_grid);
+    spatial_hash_free(&lamp_grid);
+    slot_map_free(&gate_slots);
+    slot_map_free(&wire_slots);
+    slot_map_free(&lamp_slots);
+    free(visible_ids);
+    visible_ids = NULL;
+    visible_capacity = 0;
+    free(near_ids);
+    near_ids = NULL;
+    near_capacity = 0;
+    free(node_owner);
+    free(split_members);
+    free(split_readers);
+    free(split_drivers);
+    free(split_table_keys);
+    free(split_table_nodes);
+    node_owner = NULL;
+    split_members = NULL;
+    split_readers = NULL;
+    split_drivers = NULL;
+    split_table_keys = NULL;
+    split_table_nodes = NULL;
+    node_owner_capacity = 0;
+    split_member_capacity = 0;
+    split_reader_capacity = 0;
+    split_driver_capacity = 0;
+    split_table_key_capacity = 0;
+    split_table_node_capacity = 0;
+    render_batch_free(&editor_batch);
+    levelization_free(&sim_levels);
+    sim_queue_free(&sim_queue);
+    free(dirty_nets);
+    free(dirty_gates);
+    dirty_nets = NULL;
+    dirty_gates = NULL;
+    dirty_net_count = 0;
+    dirty_net_capacity = 0;
+    dirty_gate_count = 0;
+    dirty_gate_capacity = 0;
+    edit_evaluations = 0;
+    free_sim_netlist();
+    free_timing();
+    editor_waveform_stop();
+    thread_pool_destroy(sim_pool);
+    sim_pool = NULL;
 }
 
 // Compute squared distance from point to segment (ax,ay)-(bx,by)
@@ -862,34 +1201,65 @@ static int hit_test_wire(float world_x, float world_y)
 {
     const float pick_radius = 8.0f; // world-space tolerance
     float pick_sq = pick_radius * pick_radius;
-    for (size_t i = 0; i < wire_count; ++i)
+    const uint32_t *ids;
+    size_t n = query_near(&wire_grid, world_x, world_y, pick_radius, &ids);
+    int best = -1;
+    for (size_t k = 0; k < n; ++k)
     {
-        EditorWire *w = &wires[i];
-        if (w->count < 2)
+        EditorWire *w = &wires[ids[k]];
+        if (w->count < 2 || (best >= 0 && (int)ids[k] >= best))
             continue;
         for (size_t s = 0; s + 1 < w->count; ++s)
         {
             if (point_segment_distance_sq(world_x, world_y, w->points[s].x, w->points[s].y, w->points[s + 1].x, w->points[s + 1].y) <= pick_sq)
             {
-                return (int)i;
+                best = (int)ids[k];
+                break;
             }
         }
     }
-    return -1;
+    return best;
 }
 
 // Hit-test lamps: returns lamp index or -1
 static int hit_test_lamp(float world_x, float world_y)
 {
-    for (size_t i = 0; i < lamp_count; ++i)
+    const uint32_t *ids;
+    size_t n = spatial_hash_query(&lamp_grid, world_x, world_y, world_x, world_y, &ids);
+    int best = -1;
+    for (size_t k = 0; k < n; ++k)
     {
+        size_t i = ids[k];
         float dx = world_x - lamps[i].x;
         float dy = world_y - lamps[i].y;
         float r = lamps[i].radius;
-        if (dx * dx + dy * dy <= r * r)
-            return (int)i;
+        if (dx * dx + dy * dy <= r * r && (best < 0 || (int)i < best))
+            best = (int)i;
     }
-    return -1;
+    return best;
+}
+
+// Dense index of the selected object if it is of the given type and still exists, else -1
+static int selected_index_of(SelectionType type)
+{
+    if (selected_type != type)
+        return -1;
+    const struct SlotMap *map = type == SELECT_GATE ? &gate_slots : type == SELECT_WIRE ? &wire_slots : &lamp_slots;
+    size_t index = slot_map_index(map, selected_handle);
+    return index == SLOT_MAP_NO_INDEX ? -1 : (int)index;
+}
+
+static void select_object(SelectionType type, int index)
+{
+    selected_type = type;
+    if (type == SELECT_GATE)
+        selected_handle = slot_map_handle(&gate_slots, (size_t)index);
+    else if (type == SELECT_WIRE)
+        selected_handle = slot_map_handle(&wire_slots, (size_t)index);
+    else if (type == SELECT_LAMP)
+        selected_handle = slot_map_handle(&lamp_slots, (size_t)index);
+    else
+        selected_handle = SLOT_NONE;
 }
 
 int editor_select_at(float world_x, float world_y, const Camera *camera)
@@ -899,175 +1269,948 @@ int editor_select_at(float world_x, float world_y, const Camera *camera)
     int li = hit_test_lamp(world_x, world_y);
     if (li >= 0)
     {
-        selected_type = SELECT_LAMP;
-        selected_index = li;
+        select_object(SELECT_LAMP, li);
         return 1;
     }
     // gates
     int gi = hit_test_gate(world_x, world_y);
     if (gi >= 0)
     {
-        selected_type = SELECT_WIRE + 1; // SELECT_LAMP=2; set 3 for gate
-        selected_index = gi;
+        select_object(SELECT_GATE, gi);
         return 1;
     }
     int wi = hit_test_wire(world_x, world_y);
     if (wi >= 0)
     {
-        selected_type = SELECT_WIRE;
-        selected_index = wi;
+        select_object(SELECT_WIRE, wi);
         return 1;
     }
-    selected_type = SELECT_NONE;
-    selected_index = -1;
+    select_object(SELECT_NONE, -1);
     return 0;
 }
 
+// Swap-removal: the last object of the array moves into index i, keeping its handle
+// and its spatial index entries. The logic objects must already be released.
+static void remove_wire_at(size_t i)
+{
+    unindex_wire(i);
+    array_pool_release(&point_pool, wires[i].points, wires[i].capacity);
+    size_t moved = slot_map_remove(&wire_slots, i);
+    wire_count--;
+    if (moved != i)
+    {
+        wires[i] = wires[moved];
+        relocate_wire(moved, i);
+    }
+}
+
+static void remove_lamp_at(size_t i)
+{
+    unindex_lamp(i);
+    size_t moved = slot_map_remove(&lamp_slots, i);
+    lamp_count--;
+    if (moved != i)
+    {
+        lamps[i] = lamps[moved];
+        relocate_lamp(moved, i);
+    }
+}
+
+// Wires attached to the gate lose the link on their own: its handle stops resolving
+static void remove_gate_at(size_t i)
+{
+    unindex_gate(i);
+    size_t moved = slot_map_remove(&gate_slots, i);
+    gate_count--;
+    if (moved != i)
+    {
+        gates[i] = gates[moved];
+        relocate_gate(moved, i);
+    }
+}
+
 void editor_delete_selected(void)
 {
-    if (selected_type == SELECT_WIRE)
+    int wi = selected_index_of(SELECT_WIRE);
+    int li = selected_index_of(SELECT_LAMP);
+    int gi = selected_index_of(SELECT_GATE);
+    if (wi >= 0)
     {
-        if (selected_index < 0 || (size_t)selected_index >= wire_count)
+        // the rest of the net may fall apart into several nets without this segment
+        if (!split_net_after_delete((size_t)wi))
             return;
-        // free logic and points
-        if (wires[selected_index].logic_wire)
-        {
-            detach_lamps_from_wire(wires[selected_index].logic_wire);
-            free(wires[selected_index].logic_wire);
-        }
-        free(wires[selected_index].points);
-        for (size_t i = selected_index; i + 1 < wire_count; ++i)
-            wires[i] = wires[i + 1];
-        wire_count--;
-        selected_type = SELECT_NONE;
-        selected_index = -1;
-        return;
+        remove_wire_at((size_t)wi);
+        invalidate_levels();
     }
-    else if (selected_type == SELECT_LAMP)
+    else if (li >= 0)
     {
-        if (selected_index < 0 || (size_t)selected_index >= lamp_count)
-            return;
-        if (lamps[selected_index].logic_lamp)
-            free(lamps[selected_index].logic_lamp);
-        // remove lamp
-        for (size_t i = selected_index; i + 1 < lamp_count; ++i)
-            lamps[i] = lamps[i + 1];
-        lamp_count--;
-        selected_type = SELECT_NONE;
-        selected_index = -1;
-        return;
+        logic_pool_delete_lamp(&logic_pool, lamps[li].logic_lamp);
+        remove_lamp_at((size_t)li);
     }
-    else if (selected_type == SELECT_WIRE + 1)
+    else if (gi >= 0)
+    {
+        // also removes the gate from the fanout of the wires it reads and takes its
+        // drive off its output net, whose readers then see the other drivers
+        struct Wire *output = gates[gi].gate ? gates[gi].gate->output : NULL;
+        logic_pool_delete_gate(&logic_pool, gates[gi].gate);
+        remove_gate_at((size_t)gi);
+        invalidate_levels();
+        mark_net_dirty(output);
+    }
+    else
     {
-        // gate
-        if (selected_index < 0 || (size_t)selected_index >= gate_count)
-            return;
-        if (gates[selected_index].gate)
-        {
-            // detach any wires that reference this gate
-            for (size_t i = 0; i < wire_count; ++i)
-            {
-                EditorWire *w = &wires[i];
-                if (w->logic_wire)
-                {
-                    detach_gates_from_wire(w->logic_wire);
-                }
-            }
-            free(gates[selected_index].gate);
-        }
-        for (size_t i = selected_index; i + 1 < gate_count; ++i)
-            gates[i] = gates[i + 1];
-        gate_count--;
-        selected_type = SELECT_NONE;
-        selected_index = -1;
         return;
     }
+    select_object(SELECT_NONE, -1);
+    resimulate_dirty();
 }
 
 void editor_toggle_selected_switch(void)
 {
-    if (selected_type != SELECT_WIRE + 1)
-        return;
-    if (selected_index < 0 || (size_t)selected_index >= gate_count)
+    int gi = selected_index_of(SELECT_GATE);
+    if (gi < 0)
         return;
-    EditorGate *g = &gates[selected_index];
+    EditorGate *g = &gates[gi];
     if (!g->gate)
         return;
-    GateType next = (g->gate->type < XNOR) ? (GateType)((int)g->gate->type + 1) : CONSTANT_LOW;
+    GateType next = (g->gate->type < TRISTATE) ? (GateType)((int)g->gate->type + 1) : CONSTANT_LOW;
     editor_set_selected_gate_type(next);
 }
 
 void editor_set_selected_gate_type(GateType type)
 {
-    if (selected_type != SELECT_WIRE + 1)
+    int gi = selected_index_of(SELECT_GATE);
+    if (gi < 0)
         return;
-    if (selected_index < 0 || (size_t)selected_index >= gate_count)
-        return;
-    EditorGate *g = &gates[selected_index];
+    EditorGate *g = &gates[gi];
     if (!g->gate)
         return;
+    // Clocked gates break loops, so turning a gate into one (or back) changes the ranks
+    if (gate_is_clocked(g->gate->type) != gate_is_clocked(type))
+        invalidate_levels();
     g->gate->type = type;
+    sim_netlist_valid = false;
+    timing_valid = false;
     update_gate_output_for_type(g->gate);
-    editor_propagate_signals();
+    // Only the changed gate and whatever its output reaches needs re-evaluation. The
+    // output may already carry the new value, so wake its readers explicitly.
+    mark_gate_dirty(g->gate);
+    mark_net_dirty(g->gate->output);
+    resimulate_dirty();
 }
 
 void editor_set_selected_wire_state(SignalState state)
 {
-    if (selected_type != SELECT_WIRE)
+    int wi = selected_index_of(SELECT_WIRE);
+    if (wi < 0)
         return;
-    if (selected_index < 0 || (size_t)selected_index >= wire_count)
+    EditorWire *w = &wires[wi];
+    struct Wire *net = wire_find(w->logic_wire);
+    if (!net)
         return;
-    EditorWire *w = &wires[selected_index];
-    if (!w->logic_wire)
+    // A driven net follows its drivers; forcing it would leave the state out of step
+    // with the driver counts
+    if (wire_state(net) == state || wire_driven(net))
         return;
-    w->logic_wire->state = state;
-    editor_propagate_signals();
+    if (timing_view)
+        record_timed_change((size_t)wi, state);
+    wire_set_state(net, state);
+    // Wake up the gates reading this net; the event queue follows the changes downstream
+    mark_net_dirty(net);
+    resimulate_dirty();
 }
 
-void editor_propagate_signals(void)
+static void invalidate_levels(void)
 {
-    // Iteratively update gates until stable or max iterations reached
-    const int MAX_ITER = 64;
-    int iter = 0;
-    int changed = 0;
-    do
-    {
-        changed = 0;
-        for (size_t i = 0; i < gate_count; ++i)
-        {
-            if (!gates[i].gate)
-                continue;
-            // capture previous outputs for comparison
-            SignalState prev_out = gates[i].gate->output ? gates[i].gate->output->state : UNKNOWN;
-            update_gate(gates[i].gate);
-            SignalState new_out = gates[i].gate->output ? gates[i].gate->output->state : UNKNOWN;
-            if (prev_out != new_out)
-                changed = 1;
-        }
-        iter++;
-    } while (changed && iter < MAX_ITER);
+    sim_levels.valid = 0;
+    sim_netlist_valid = false;
+    timing_valid = false;
+    editor_waveform_stop();
+}
 
-    // After convergence, sync lamp states
-    for (size_t i = 0; i < lamp_count; ++i)
+static void ensure_levels(void)
+{
+    if (sim_levels.valid)
+        return;
+    struct Gate **logic_gates = malloc((gate_count + 1) * sizeof(struct Gate *));
+    if (!logic_gates)
+        return;
+    for (size_t i = 0; i < gate_count; ++i)
+        logic_gates[i] = gates[i].gate;
+    if (levelize_gates(&sim_levels, logic_gates, gate_count))
     {
-        if (lamps[i].logic_lamp && lamps[i].logic_lamp->input)
-        {
-            lamps[i].logic_lamp->state = lamps[i].logic_lamp->input->state;
-        }
-        else if (lamps[i].logic_lamp)
-        {
-            lamps[i].logic_lamp->state = UNKNOWN;
-        }
+        sim_queue_set_levels(&sim_queue, sim_levels.depth);
+        // Wiring changed: flip-flops only fire on edges from here on
+        sim_clock_reset(sim_levels.order, sim_levels.count);
     }
+    free(logic_gates);
 }
 
-// Main editor rendering function
-void editor_render(SDL_Renderer *renderer)
+static void clock_cycle(void)
+{
+    size_t max_evaluations = (gate_count + 1) * SIM_MAX_EVALS_PER_GATE;
+    sim_clock_edge(&sim_queue, sim_levels.order, sim_levels.count, HIGH, max_evaluations);
+    wave_record_step();
+    sim_clock_edge(&sim_queue, sim_levels.order, sim_levels.count, LOW, max_evaluations);
+    wave_record_step();
+    clock_cycles++;
+}
+
+void editor_clock_step(void)
+{
+    ensure_levels();
+    if (!sim_levels.valid)
+        return;
+    clock_cycle();
+    editor_sync_lamps();
+}
+
+void editor_clock_toggle_running(void)
+{
+    clock_running = !clock_running;
+    clock_rate_cycles = 0;
+    clock_rate_start = SDL_GetTicksNS();
+    clock_rate = 0.0;
+}
+
+void editor_clock_update(void)
+{
+    if (!clock_running)
+        return;
+    ensure_levels();
+    if (!sim_levels.valid)
+        return;
+    Uint64 start = SDL_GetTicksNS();
+    Uint64 now;
+    do
+    {
+        clock_cycle();
+        clock_rate_cycles++;
+        now = SDL_GetTicksNS();
+    } while (now - start < CLOCK_FRAME_BUDGET_NS);
+    editor_sync_lamps();
+
+    if (now - clock_rate_start >= 1000000000u)
+    {
+        clock_rate = (double)clock_rate_cycles * 1e9 / (double)(now - clock_rate_start);
+        clock_rate_cycles = 0;
+        clock_rate_start = now;
+    }
+}
+
+int editor_get_combinational_depth(void)
+{
+    ensure_levels();
+    return sim_levels.depth;
+}
+
+int editor_compile_netlist(struct Netlist *nl, struct EditorNetlistIds *ids)
+{
+    struct Gate **logic_gates = malloc((gate_count + 1) * sizeof(struct Gate *));
+    uint32_t *logic_gate_editor = malloc((gate_count + 1) * sizeof(uint32_t));
+    struct Wire **logic_wires = malloc((wire_count + lamp_count + 1) * sizeof(struct Wire *));
+    if (!logic_gates || !logic_gate_editor || !logic_wires)
+    {
+        free(logic_gates);
+        free(logic_gate_editor);
+        free(logic_wires);
+        return 0;
+    }
+    size_t gate_total = 0;
+    for (size_t i = 0; i < gate_count; ++i)
+    {
+        if (gates[i].gate)
+        {
+            logic_gate_editor[gate_total] = (uint32_t)i;
+            logic_gates[gate_total++] = gates[i].gate;
+        }
+    }
+    size_t wire_total = 0;
+    for (size_t i = 0; i < wire_count; ++i)
+    {
+        if (wires[i].logic_wire)
+            logic_wires[wire_total++] = wires[i].logic_wire;
+    }
+    for (size_t i = 0; i < lamp_count; ++i)
+    {
+        if (lamps[i].logic_lamp && lamps[i].logic_lamp->input)
+            logic_wires[wire_total++] = lamps[i].logic_lamp->input;
+    }
+    int ok = netlist_compile(nl, logic_gates, gate_total, logic_wires, wire_total);
+    free(logic_gates);
+    free(logic_wires);
+    // netlist_compile levelizes the gates itself, the cached order stays usable
+
+    if (ok && ids)
+    {
+        ids->gate = malloc((gate_count + 1) * sizeof(uint32_t));
+        ids->gate_editor = malloc((nl->gate_count + 1) * sizeof(uint32_t));
+        ids->wire_net = malloc((wire_count + 1) * sizeof(uint32_t));
+        ids->lamp_net = malloc((lamp_count + 1) * sizeof(uint32_t));
+        ids->gate_count = gate_count;
+        ids->wire_count = wire_count;
+        ids->lamp_count = lamp_count;
+        if (!ids->gate || !ids->gate_editor || !ids->wire_net || !ids->lamp_net)
+        {
+            editor_netlist_ids_free(ids);
+            netlist_free(nl);
+            ok = 0;
+        }
+    }
+    if (ok && ids)
+    {
+        for (size_t i = 0; i < gate_count; ++i)
+            ids->gate[i] = NETLIST_NO_NET;
+        for (size_t g = 0; g < nl->gate_count; ++g)
+        {
+            uint32_t editor_index = logic_gate_editor[nl->gate_source[g]];
+            ids->gate_editor[g] = editor_index;
+            ids->gate[editor_index] = (uint32_t)g;
+        }
+        // One hash lookup per object here; everything after indexes the tables
+        for (size_t i = 0; i < wire_count; ++i)
+            ids->wire_net[i] = netlist_net_of(nl, wires[i].logic_wire);
+        for (size_t i = 0; i < lamp_count; ++i)
+        {
+            struct Wire *input = lamps[i].logic_lamp ? lamps[i].logic_lamp->input : NULL;
+            ids->lamp_net[i] = netlist_net_of(nl, input);
+        }
+    }
+    free(logic_gate_editor);
+    return ok;
+}
+
+void editor_netlist_ids_free(struct EditorNetlistIds *ids)
+{
+    free(ids->gate);
+    free(ids->gate_editor);
+    free(ids->wire_net);
+    free(ids->lamp_net);
+    memset(ids, 0, sizeof(*ids));
+}
+
+size_t editor_get_input_nets(const struct Netlist *nl, const struct EditorNetlistIds *ids,
+                             uint32_t *out_nets, size_t max_nets)
+{
+    unsigned char *seen = calloc(nl->net_count + 1, 1);
+    if (!seen)
+        return 0;
+    size_t found = 0;
+    for (size_t i = 0; i < ids->wire_count; ++i)
+    {
+        uint32_t net = ids->wire_net[i];
+        if (net == NETLIST_NO_NET || seen[net] || nl->net_driver[net] != NETLIST_NO_NET)
+            continue;
+        seen[net] = 1;
+        if (found < max_nets)
+            out_nets[found] = net;
+        found++;
+    }
+    free(seen);
+    return found;
+}
+
+size_t editor_get_lamp_nets(const struct EditorNetlistIds *ids, uint32_t *out_nets, size_t max_nets)
+{
+    for (size_t i = 0; i < ids->lamp_count && i < max_nets; ++i)
+        out_nets[i] = ids->lamp_net[i];
+    return ids->lamp_count;
+}
+
+// Editor wire index of each net node, sorted by node address for lookup
+struct WireNodeIndex
+{
+    const struct Wire *node;
+    uint32_t wire;
+};
+
+static int compare_wire_nodes(const void *a, const void *b)
+{
+    uintptr_t x = (uintptr_t)((const struct WireNodeIndex *)a)->node;
+    uintptr_t y = (uintptr_t)((const struct WireNodeIndex *)b)->node;
+    return (x > y) - (x < y);
+}
+
+static uint32_t wire_index_of_node(const struct WireNodeIndex *index, size_t count, const struct Wire *node)
+{
+    if (!node)
+        return VLG_NONE;
+    struct WireNodeIndex key = {node, 0};
+    const struct WireNodeIndex *hit = bsearch(&key, index, count, sizeof(key), compare_wire_nodes);
+    return hit ? hit->wire : VLG_NONE;
+}
+
+int editor_save(const char *path)
+{
+    struct Netlist nl;
+    struct EditorNetlistIds ids;
+    if (!editor_compile_netlist(&nl, &ids))
+        return 0;
+
+    size_t point_total = 0;
+    for (size_t i = 0; i < wire_count; ++i)
+        point_total += wires[i].count;
+
+    struct VlgGateRecord *gate_records = malloc((gate_count + 1) * sizeof(struct VlgGateRecord));
+    struct VlgWireRecord *wire_records = calloc(wire_count + 1, sizeof(struct VlgWireRecord));
+    struct VlgPoint *points = malloc((point_total + 1) * sizeof(struct VlgPoint));
+    struct VlgLampRecord *lamp_records = malloc((lamp_count + 1) * sizeof(struct VlgLampRecord));
+    uint8_t *net_state = malloc(nl.net_count + 1);
+    uint32_t *input_nets = malloc((wire_count + 1) * sizeof(uint32_t));
+    uint32_t *output_nets = malloc((lamp_count + 1) * sizeof(uint32_t));
+    struct WireNodeIndex *node_index = malloc((wire_count + 1) * sizeof(struct WireNodeIndex));
+    int ok = gate_records && wire_records && points && lamp_records && net_state && input_nets &&
+             output_nets && node_index;
+    if (ok)
+    {
+        for (size_t i = 0; i < wire_count; ++i)
+        {
+            node_index[i].node = wires[i].logic_wire;
+            node_index[i].wire = (uint32_t)i;
+        }
+        qsort(node_index, wire_count, sizeof(struct WireNodeIndex), compare_wire_nodes);
+
+        for (size_t i = 0; i < gate_count; ++i)
+        {
+            const EditorGate *g = &gates[i];
+            struct VlgGateRecord *r = &gate_records[i];
+            r->x = g->x;
+            r->y = g->y;
+            r->width = g->width;
+            r->height = g->height;
+            r->type = g->gate ? (uint32_t)g->gate->type : (uint32_t)CONSTANT_LOW;
+            r->input1_wire = g->gate ? wire_index_of_node(node_index, wire_count, g->gate->input1) : VLG_NONE;
+            r->input2_wire = g->gate ? wire_index_of_node(node_index, wire_count, g->gate->input2) : VLG_NONE;
+            r->output_wire = g->gate ? wire_index_of_node(node_index, wire_count, g->gate->output) : VLG_NONE;
+        }
+        size_t point_pos = 0;
+        for (size_t i = 0; i < wire_count; ++i)
+        {
+            const EditorWire *w = &wires[i];
+            struct VlgWireRecord *r = &wire_records[i];
+            r->first_point = point_pos;
+            r->point_count = (uint32_t)w->count;
+            r->net = ids.wire_net[i];
+            size_t start_gate = slot_map_index(&gate_slots, w->start_gate);
+            size_t end_gate = slot_map_index(&gate_slots, w->end_gate);
+            r->start_gate_index = start_gate == SLOT_MAP_NO_INDEX ? -1 : (int32_t)start_gate;
+            r->end_gate_index = end_gate == SLOT_MAP_NO_INDEX ? -1 : (int32_t)end_gate;
+            r->start_pin = (uint8_t)w->start_pin;
+            r->end_pin = (uint8_t)w->end_pin;
+            for (size_t p = 0; p < w->count; ++p)
+            {
+                points[point_pos].x = w->points[p].x;
+                points[point_pos].y = w->points[p].y;
+                point_pos++;
+            }
+        }
+        for (size_t i = 0; i < lamp_count; ++i)
+        {
+            struct VlgLampRecord *r = &lamp_records[i];
+            r->x = lamps[i].x;
+            r->y = lamps[i].y;
+            r->radius = lamps[i].radius;
+            r->input_wire = lamps[i].logic_lamp ? wire_index_of_node(node_index, wire_count, lamps[i].logic_lamp->input) : VLG_NONE;
+        }
+        for (size_t net = 0; net < nl.net_count; ++net)
+            net_state[net] = nl.net_wire[net] ? (uint8_t)wire_state(nl.net_wire[net]) : (uint8_t)LOW;
+
+        struct VlgDesign design = {0};
+        design.gates = gate_records;
+        design.gate_count = gate_count;
+        design.wires = wire_records;
+        design.wire_count = wire_count;
+        design.points = points;
+        design.point_count = point_total;
+        design.lamps = lamp_records;
+        design.lamp_count = lamp_count;
+        design.net_state = net_state;
+        design.input_nets = input_nets;
+        design.input_count = editor_get_input_nets(&nl, &ids, input_nets, wire_count);
+        design.output_nets = output_nets;
+        design.output_count = editor_get_lamp_nets(&ids, output_nets, lamp_count);
+        ok = vlg_save(path, &design, &nl);
+    }
+    free(gate_records);
+    free(wire_records);
+    free(points);
+    free(lamp_records);
+    free(net_state);
+    free(input_nets);
+    free(output_nets);
+    free(node_index);
+    editor_netlist_ids_free(&ids);
+    netlist_free(&nl);
+    return ok;
+}
+
+int editor_load(const char *path)
+{
+    struct VlgFile file;
+    if (!vlg_open(&file, path))
+        return 0;
+    const struct VlgDesign *d = &file.design;
+    // First wire seen on each net; later segments of the net are joined to it
+    uint32_t *net_first_wire = malloc((file.netlist.net_count + 1) * sizeof(uint32_t));
+    if (!net_first_wire)
+    {
+        vlg_close(&file);
+        return 0;
+    }
+    for (size_t net = 0; net < file.netlist.net_count; ++net)
+        net_first_wire[net] = VLG_NONE;
+
+    // Replace the current design
+    wire_placement_clear();
+    free_all_wires();
+    free_all_lamps();
+    free_all_gates();
+    lamp_placement_active = false;
+    switch_placement_active = false;
+
+    for (size_t i = 0; i < d->wire_count; ++i)
+    {
+        const struct VlgWireRecord *r = &d->wires[i];
+        ensure_wires_capacity();
+        EditorWire *w = &wires[wire_count];
+        w->count = r->point_count;
+        w->points = array_pool_alloc(&point_pool, r->point_count, &w->capacity);
+        if (!w->points)
+            break;
+        if (slot_map_insert(&wire_slots) == SLOT_NONE)
+        {
+            array_pool_release(&point_pool, w->points, w->capacity);
+            break;
+        }
+        for (size_t p = 0; p < w->count; ++p)
+        {
+            w->points[p].x = d->points[r->first_point + p].x;
+            w->points[p].y = d->points[r->first_point + p].y;
+        }
+        SignalState state = UNKNOWN;
+        if (r->net != VLG_NONE && d->net_state[r->net] <= HIGH_Z)
+            state = (SignalState)d->net_state[r->net];
+        w->logic_wire = logic_pool_new_wire(&logic_pool, state);
+        if (!register_wire_node(wire_count))
+        {
+            logic_pool_delete_wire(&logic_pool, w->logic_wire);
+            w->logic_wire = NULL;
+        }
+        w->start_gate = SLOT_NONE; // Linked once the gates exist
+        w->start_pin = (GatePinType)r->start_pin;
+        w->end_gate = SLOT_NONE;
+        w->end_pin = (GatePinType)r->end_pin;
+        if (r->net != VLG_NONE)
+        {
+            if (net_first_wire[r->net] == VLG_NONE)
+                net_first_wire[r->net] = (uint32_t)wire_count;
+            else
+                wire_union(wires[net_first_wire[r->net]].logic_wire, w->logic_wire);
+        }
+        wire_count++;
+        index_wire(wire_count - 1);
+    }
+
+    for (size_t i = 0; i < d->gate_count; ++i)
+    {
+        const struct VlgGateRecord *r = &d->gates[i];
+        ensure_gates_capacity();
+        if (slot_map_insert(&gate_slots) == SLOT_NONE)
+            break;
+        EditorGate *g = &gates[gate_count];
+        g->x = r->x;
+        g->y = r->y;
+        g->width = r->width;
+        g->height = r->height;
+        g->gate = logic_pool_new_gate(&logic_pool, r->type <= TRISTATE ? (GateType)r->type : CONSTANT_LOW);
+        if (g->gate)
+        {
+            if (r->input1_wire < wire_count)
+                gate_set_input(g->gate, PIN_INPUT1, wires[r->input1_wire].logic_wire);
+            if (r->input2_wire < wire_count)
+                gate_set_input(g->gate, PIN_INPUT2, wires[r->input2_wire].logic_wire);
+            if (r->output_wire < wire_count)
+                gate_set_output(g->gate, wires[r->output_wire].logic_wire);
+        }
+        gate_count++;
+        index_gate(gate_count - 1);
+    }
+    // Gate references of wires must point at gates that were created
+    for (size_t i = 0; i < wire_count; ++i)
+    {
+        const struct VlgWireRecord *r = &d->wires[i];
+        if (r->start_gate_index >= 0 && (size_t)r->start_gate_index < gate_count)
+            wires[i].start_gate = slot_map_handle(&gate_slots, (size_t)r->start_gate_index);
+        if (r->end_gate_index >= 0 && (size_t)r->end_gate_index < gate_count)
+            wires[i].end_gate = slot_map_handle(&gate_slots, (size_t)r->end_gate_index);
+    }
+
+    for (size_t i = 0; i < d->lamp_count; ++i)
+    {
+        const struct VlgLampRecord *r = &d->lamps[i];
+        ensure_lamps_capacity();
+        if (slot_map_insert(&lamp_slots) == SLOT_NONE)
+            break;
+        EditorLamp *l = &lamps[lamp_count];
+        l->x = r->x;
+        l->y = r->y;
+        l->radius = r->radius;
+        l->logic_lamp = logic_pool_new_lamp(&logic_pool, (r->input_wire < wire_count) ? wires[r->input_wire].logic_wire : NULL);
+        lamp_count++;
+        index_lamp(lamp_count - 1);
+    }
+
+    free(net_first_wire);
+    vlg_close(&file);
+    select_object(SELECT_NONE, -1);
+    invalidate_levels();
+    editor_sync_lamps();
+    return 1;
+}
+
+static void free_sim_netlist(void)
+{
+    netlist_free(&sim_optimized);
+    netlist_free(&sim_netlist);
+    free(sim_net_map);
+    free(sim_net_words);
+    sim_net_map = NULL;
+    sim_net_words = NULL;
+    sim_netlist_valid = false;
+}
+
+// Compile and simplify the design, keeping every net that has a wire. Designs with
+// buses are only compiled.
+static bool build_sim_netlist(void)
+{
+    if (!editor_compile_netlist(&sim_netlist, NULL))
+        return false;
+    sim_netlist_has_bus = false;
+    for (size_t i = 0; i < sim_netlist.gate_count && !sim_netlist_has_bus; ++i)
+    {
+        sim_netlist_has_bus = sim_netlist.net_driver[sim_netlist.gate_out[i]] != (uint32_t)i ||
+                              sim_netlist.gate_type[i] == TRISTATE;
+    }
+    // Buses settle on the event queue (settle_compiled_parallel gives up on them), so
+    // the simplified netlist would never be used
+    if (sim_netlist_has_bus)
+        return true;
+    uint32_t *keep = malloc((sim_netlist.net_count + 1) * sizeof(uint32_t));
+    sim_net_map = malloc((sim_netlist.net_count + 1) * sizeof(uint32_t));
+    size_t keep_count = 0;
+    for (size_t net = NETLIST_FIRST_NET; keep && net < sim_netlist.net_count; ++net)
+    {
+        if (sim_netlist.net_wire[net])
+            keep[keep_count++] = (uint32_t)net;
+    }
+    bool ok = keep && sim_net_map &&
+              netlist_optimize(&sim_netlist, keep, keep_count, &sim_optimized, sim_net_map, NULL);
+    free(keep);
+    if (ok)
+    {
+        sim_net_words = malloc((sim_optimized.net_count + 1) * sizeof(PatternWord));
+        if (!sim_net_words)
+            netlist_free(&sim_optimized);
+        ok = sim_net_words != NULL;
+    }
+    if (!ok)
+    {
+        netlist_free(&sim_netlist);
+        free(sim_net_map);
+        sim_net_map = NULL;
+    }
+    return ok;
+}
+
+// True if every value the compiled netlist starts from is LOW or HIGH: the undriven
+// nets, the outputs of gates that hold state and the nets of feedback loops (the
+// netlist reloads those)
+static bool sim_sources_known(void)
+{
+    for (size_t net = NETLIST_FIRST_NET; net < sim_netlist.net_count; ++net)
+    {
+        const struct Wire *wire = sim_netlist.net_wire[net];
+        uint32_t driver = sim_netlist.net_driver[net];
+        if (!wire)
+            continue;
+        if (driver != NETLIST_NO_NET)
+        {
+            GateType type = (GateType)sim_netlist.gate_type[driver];
+            if (!gate_is_clocked(type) && type != LATCH && !sim_netlist.gate_cyclic[driver])
+                continue;
+        }
+        SignalState state = wire_state(wire);
+        if (state != LOW && state != HIGH)
+            return false;
+    }
+    return true;
+}
+
+// Settle the whole design on the compiled netlist using the thread pool.
+// Returns false if the netlist could not be built or the design needs four-valued
+// logic (caller falls back).
+static bool settle_compiled_parallel(void)
+{
+    if (!sim_netlist_valid)
+    {
+        free_sim_netlist();
+        if (!build_sim_netlist())
+            return false;
+        sim_netlist_valid = true;
+    }
+    if (sim_netlist_has_bus || !sim_sources_known())
+        return false;
+    if (!sim_pool)
+        sim_pool = thread_pool_create(0);
+
+    netlist_load_states(&sim_optimized, sim_net_words);
+    edit_evaluations = netlist_eval_parallel(&sim_optimized, sim_net_words, (int)SIM_MAX_EVALS_PER_GATE,
+                                             sim_pool, NETLIST_PARALLEL_MIN_GATES);
+
+    // Write the driven nets back through the net map; every pattern lane holds the same value
+    for (size_t net = NETLIST_FIRST_NET; net < sim_netlist.net_count; ++net)
+    {
+        struct Wire *wire = sim_netlist.net_wire[net];
+        uint32_t optimized = sim_net_map[net];
+        if (wire && sim_netlist.net_driver[net] != NETLIST_NO_NET && optimized != NETLIST_NO_NET)
+            wire_set_state(wire, (sim_net_words[optimized] & 1u) ? HIGH : LOW);
+    }
+    // Every net has one driver here: let each gate drive what its net settled to, so
+    // the gates agree with their nets when the event queue takes over again
+    for (size_t i = 0; i < gate_count; ++i)
+    {
+        if (gates[i].gate && gates[i].gate->output)
+            gate_drive(gates[i].gate, wire_state(wire_find(gates[i].gate->output)));
+    }
+    return true;
+}
+
+static void free_timing(void)
+{
+    netlist_free(&timing_netlist);
+    editor_netlist_ids_free(&timing_ids);
+    free(timing_gate_flags);
+    free(timing_wire_flags);
+    timing_gate_flags = NULL;
+    timing_wire_flags = NULL;
+    timing_critical_delay = 0;
+    timing_path_length = 0;
+    timing_change_shown = false;
+    timing_valid = false;
+}
+
+// Compile the design and mark the critical path. Returns false on allocation failure.
+static bool ensure_timing(void)
+{
+    if (timing_valid)
+        return true;
+    free_timing();
+    if (!editor_compile_netlist(&timing_netlist, &timing_ids))
+        return false;
+    struct NetlistTiming timing;
+    uint8_t *net_critical = calloc(timing_netlist.net_count + 1, 1);
+    timing_gate_flags = calloc(timing_ids.gate_count + 1, 1);
+    timing_wire_flags = calloc(timing_ids.wire_count + 1, 1);
+    if (!net_critical || !timing_gate_flags || !timing_wire_flags ||
+        !netlist_timing_analyze(&timing, &timing_netlist, &timing_model))
+    {
+        free(net_critical);
+        free_timing();
+        return false;
+    }
+    // The path runs over its gates, their output nets and the net feeding the first gate
+    for (size_t k = 0; k < timing.path_length; ++k)
+    {
+        uint32_t g = timing.path[k];
+        timing_gate_flags[timing_ids.gate_editor[g]] = TIMING_CRITICAL;
+        net_critical[timing_netlist.gate_out[g]] = 1;
+        if (k == 0 && timing.late_input[g] != NETLIST_NO_NET)
+            net_critical[timing.late_input[g]] = 1;
+    }
+    for (size_t i = 0; i < timing_ids.wire_count; ++i)
+    {
+        uint32_t net = timing_ids.wire_net[i];
+        if (net != NETLIST_NO_NET && net_critical[net])
+            timing_wire_flags[i] = TIMING_CRITICAL;
+    }
+    timing_critical_delay = timing.critical_delay;
+    timing_path_length = timing.path_length;
+    netlist_timing_free(&timing);
+    free(net_critical);
+    timing_valid = true;
+    return true;
+}
+
+// Replay an input change with gate delays, starting from the current (settled) state,
+// and flag the wires that changed more than once on the way
+static void record_timed_change(size_t wire_index, SignalState state)
+{
+    if (!ensure_timing() || wire_index >= timing_ids.wire_count || timing_ids.wire_net[wire_index] == NETLIST_NO_NET)
+        return;
+    PatternWord *words = malloc((timing_netlist.net_count + 1) * sizeof(PatternWord));
+    struct NetlistWheel wheel;
+    if (!words)
+        return;
+    netlist_load_states(&timing_netlist, words);
+    if (!netlist_wheel_init(&wheel, &timing_netlist, &timing_model, words))
+    {
+        free(words);
+        return;
+    }
+    netlist_wheel_drive(&wheel, timing_ids.wire_net[wire_index], state == HIGH ? ~(PatternWord)0 : 0);
+    // Long enough for every path; oscillating loops just stop there
+    netlist_wheel_run(&wheel, words, ((uint64_t)timing_critical_delay + 1) * SIM_MAX_EVALS_PER_GATE);
+
+    for (size_t i = 0; i < timing_ids.wire_count; ++i)
+    {
+        uint32_t net = timing_ids.wire_net[i];
+        timing_wire_flags[i] &= (uint8_t)~TIMING_GLITCH;
+        if (net != NETLIST_NO_NET && (wheel.glitched[net] & 1))
+            timing_wire_flags[i] |= TIMING_GLITCH;
+    }
+    timing_glitches = netlist_wheel_glitches(&wheel, 1);
+    timing_settle = wheel.last_change;
+    timing_change_shown = true;
+    netlist_wheel_free(&wheel);
+    free(words);
+}
+
+void editor_timing_toggle_view(void)
+{
+    timing_view = !timing_view;
+    timing_change_shown = false;
+    if (timing_view)
+        ensure_timing();
+}
+
+void editor_propagate_signals(void)
+{
+    if (gate_count >= PARALLEL_SETTLE_MIN_GATES && settle_compiled_parallel())
+    {
+        editor_sync_lamps();
+        return;
+    }
+
+    // Full settle: one pass in topological order, only feedback loops iterate
+    ensure_levels();
+    if (sim_levels.valid)
+    {
+        edit_evaluations = levelized_settle(&sim_levels, (int)SIM_MAX_EVALS_PER_GATE);
+    }
+    else
+    {
+        // Out of memory for the levelization: fall back to seeding the event queue
+        for (size_t i = 0; i < gate_count; ++i)
+            sim_schedule_gate(&sim_queue, gates[i].gate);
+        edit_evaluations = sim_run(&sim_queue, (gate_count + 1) * SIM_MAX_EVALS_PER_GATE);
+    }
+    editor_sync_lamps();
+}
+
+size_t editor_get_edit_evaluations(void)
+{
+    return edit_evaluations;
+}
+
+static void wave_record_step(void)
+{
+    if (!wave_recording)
+        return;
+    waveform_step(&wave_rec, ++wave_time);
+    waveform_sample_wires(&wave_rec, wave_wires);
+}
+
+int editor_waveform_start(const char *path)
+{
+    editor_waveform_stop();
+    struct Netlist nl;
+    struct EditorNetlistIds ids;
+    if (!editor_compile_netlist(&nl, &ids))
+        return 0;
+    uint32_t *first_wire = malloc((nl.net_count + 1) * sizeof(uint32_t));
+    wave_wires = malloc((nl.net_count + 1) * sizeof(struct Wire *));
+    bool ok = first_wire && wave_wires && waveform_open(&wave_rec, path, 0, "1 ns");
+    if (ok)
+    {
+        for (size_t net = 0; net < nl.net_count; ++net)
+            first_wire[net] = NETLIST_NO_NET;
+        for (size_t i = wire_count; i-- > 0;)
+        {
+            if (ids.wire_net[i] != NETLIST_NO_NET)
+                first_wire[ids.wire_net[i]] = (uint32_t)i;
+        }
+        size_t signals = 0;
+        char name[32];
+        for (size_t net = NETLIST_FIRST_NET; ok && net < nl.net_count; ++net)
+        {
+            if (first_wire[net] == NETLIST_NO_NET)
+                continue;
+            struct Wire *wire = wires[first_wire[net]].logic_wire;
+            SDL_snprintf(name, sizeof(name), "w%u", first_wire[net]);
+            wave_wires[signals++] = wire;
+            ok = waveform_add_signal(&wave_rec, name, wire_state(wire_find(wire))) != WAVEFORM_NO_SIGNAL;
+        }
+        ok = ok && waveform_start(&wave_rec);
+        if (!ok)
+            waveform_close(&wave_rec);
+    }
+    free(first_wire);
+    editor_netlist_ids_free(&ids);
+    netlist_free(&nl);
+    if (!ok)
+    {
+        free(wave_wires);
+        wave_wires = NULL;
+        return 0;
+    }
+    wave_time = 0;
+    wave_recording = true;
+    wave_status[0] = '\0';
+    return 1;
+}
+
+void editor_waveform_stop(void)
+{
+    if (!wave_recording)
+        return;
+    wave_recording = false;
+    if (!waveform_close(&wave_rec))
+        SDL_Log("Waveform file incomplete: write error");
+    free(wave_wires);
+    wave_wires = NULL;
+}
+
+int editor_waveform_is_recording(void)
+{
+    return wave_recording;
+}
+
+static void editor_sync_lamps(void)
+{
+    for (size_t i = 0; i < lamp_count; ++i)
+    {
+        if (lamps[i].logic_lamp && lamps[i].logic_lamp->input)
+        {
+            lamps[i].logic_lamp->state = wire_state(wire_find(lamps[i].logic_lamp->input));
+        }
+        else if (lamps[i].logic_lamp)
+        {
+            lamps[i].logic_lamp->state = UNKNOWN;
+        }
+    }
+    wave_record_step();
+}
+
+// Main editor rendering function
+void editor_render(SDL_Renderer *renderer)
 {
     // Render the grid with camera transformation
-    SDL_SetRenderDrawColor(renderer, 50, 50, 50, 255);
+    const SDL_Color grid_color = {50, 50, 50, 255};
     int screen_w, screen_h;
     SDL_GetCurrentRenderOutputSize(renderer, &screen_w, &screen_h);
+    bool show_timing = timing_view && ensure_timing();
+    const SDL_Color critical_color = {255, 150, 40, 255};
+    const SDL_Color glitch_color = {235, 80, 235, 255};
 
     // Calculate visible world bounds
     float world_left, world_top, world_right, world_bottom;
@@ -1086,7 +2229,7 @@ void editor_render(SDL_Renderer *renderer)
         float screen_y_start, screen_y_end, screen_x_start, screen_x_end;
         camera_world_to_screen(&editor_camera, world_left, world_y, &screen_x_start, &screen_y_start);
         camera_world_to_screen(&editor_camera, world_right, world_y, &screen_x_end, &screen_y_end);
-        SDL_RenderLine(renderer, screen_x_start, screen_y_start, screen_x_end, screen_y_end);
+        render_batch_line(&editor_batch, screen_x_start, screen_y_start, screen_x_end, screen_y_end, 1.0f, grid_color);
     }
 
     // Render vertical grid lines
@@ -1095,12 +2238,27 @@ void editor_render(SDL_Renderer *renderer)
         float screen_x_start, screen_x_end, screen_y_start, screen_y_end;
         camera_world_to_screen(&editor_camera, world_x, world_top, &screen_x_start, &screen_y_start);
         camera_world_to_screen(&editor_camera, world_x, world_bottom, &screen_x_end, &screen_y_end);
-        SDL_RenderLine(renderer, screen_x_start, screen_y_start, screen_x_end, screen_y_end);
+        render_batch_line(&editor_batch, screen_x_start, screen_y_start, screen_x_end, screen_y_end, 1.0f, grid_color);
     }
-
-    // Render all gates
-    for (size_t i = 0; i < gate_count; ++i)
+    render_batch_flush(&editor_batch, renderer);
+
+    // Only objects near the viewport are drawn
+    float margin = RENDER_CULL_MARGIN_PX / (editor_camera.zoom > 0.0f ? editor_camera.zoom : 1.0f);
+    float cull_left = fminf(world_left, world_right) - margin;
+    float cull_right = fmaxf(world_left, world_right) + margin;
+    float cull_top = fminf(world_top, world_bottom) - margin;
+    float cull_bottom = fmaxf(world_top, world_bottom) + margin;
+
+    int selected_gate = selected_index_of(SELECT_GATE);
+    int selected_wire = selected_index_of(SELECT_WIRE);
+    int selected_lamp = selected_index_of(SELECT_LAMP);
+
+    // Render visible gates: bodies and pins in one batch, labels on top
+    const SDL_Color pin_color = {200, 200, 200, 255};
+    size_t visible_count = collect_visible(&gate_grid, cull_left, cull_top, cull_right, cull_bottom);
+    for (size_t v = 0; v < visible_count; ++v)
     {
+        size_t i = visible_ids[v];
         float gx = gates[i].x;
         float gy = gates[i].y;
         float gw = gates[i].width;
@@ -1113,95 +2271,104 @@ void editor_render(SDL_Renderer *renderer)
         float rect_w = sx2 - sx;
         float rect_h = sy2 - sy;
         SDL_FRect rect = {sx, sy, rect_w, rect_h};
-        bool gate_selected = (selected_type == SELECT_WIRE + 1) && (int)i == selected_index;
+        bool gate_selected = (int)i == selected_gate;
         SDL_Color fill_color = gate_selected ? (SDL_Color){125, 145, 215, 255} : (SDL_Color){100, 100, 160, 255};
         SDL_Color border_color = gate_selected ? (SDL_Color){255, 210, 110, 255} : (SDL_Color){20, 20, 40, 255};
-        SDL_SetRenderDrawColor(renderer, fill_color.r, fill_color.g, fill_color.b, fill_color.a);
-        SDL_RenderFillRect(renderer, &rect);
-        SDL_SetRenderDrawColor(renderer, border_color.r, border_color.g, border_color.b, border_color.a);
-        SDL_RenderRect(renderer, &rect);
+        bool gate_critical = show_timing && i < timing_ids.gate_count && (timing_gate_flags[i] & TIMING_CRITICAL);
+        render_batch_fill_rect(&editor_batch, &rect, fill_color);
+        render_batch_rect(&editor_batch, &rect, gate_critical ? 2.0f : 1.0f, gate_critical ? critical_color : border_color);
         // pin markers
-        float px, py, px2, py2;
-        gate_pin_world(&gates[i], PIN_INPUT1, &px, &py);
-        camera_world_to_screen(&editor_camera, px, py, &px, &py);
-        SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255);
-        SDL_RenderFillRect(renderer, &(SDL_FRect){px - 2.5f, py - 2.5f, 5.0f, 5.0f});
-        gate_pin_world(&gates[i], PIN_INPUT2, &px2, &py2);
-        camera_world_to_screen(&editor_camera, px2, py2, &px2, &py2);
-        SDL_RenderFillRect(renderer, &(SDL_FRect){px2 - 2.5f, py2 - 2.5f, 5.0f, 5.0f});
-        gate_pin_world(&gates[i], PIN_OUTPUT, &px, &py);
-        camera_world_to_screen(&editor_camera, px, py, &px, &py);
-        SDL_RenderFillRect(renderer, &(SDL_FRect){px - 2.5f, py - 2.5f, 5.0f, 5.0f});
-
-        if (gate_label_font && gates[i].gate)
+        for (GatePinType pin = PIN_INPUT1; pin <= PIN_OUTPUT; pin++)
+        {
+            float px, py;
+            gate_pin_world(&gates[i], pin, &px, &py);
+            camera_world_to_screen(&editor_camera, px, py, &px, &py);
+            render_batch_fill_rect(&editor_batch, &(SDL_FRect){px - 2.5f, py - 2.5f, 5.0f, 5.0f}, pin_color);
+        }
+    }
+    render_batch_flush(&editor_batch, renderer);
+
+    if (gate_label_font)
+    {
+        for (size_t v = 0; v < visible_count; ++v)
         {
+            size_t i = visible_ids[v];
+            if (!gates[i].gate)
+                continue;
             const char *label = gate_type_label(gates[i].gate->type);
             if (label && *label)
             {
+                bool gate_selected = (int)i == selected_gate;
                 SDL_Color text_color = gate_selected ? (SDL_Color){255, 255, 255, 255} : (SDL_Color){235, 235, 235, 255};
-                float text_x = rect.x + 4.0f;
-                float text_y = rect.y + 2.0f;
-                render_text(renderer, gate_label_font, label, text_x, text_y, text_color);
+                float sx, sy;
+                camera_world_to_screen(&editor_camera, gates[i].x, gates[i].y, &sx, &sy);
+                render_text(renderer, gate_label_font, label, sx + 4.0f, sy + 2.0f, text_color);
             }
         }
     }
 
-    // Render all wires
-    // Render stored wires
-    for (size_t i = 0; i < wire_count; ++i)
+    // Render stored wires that have a segment in view
+    const SDL_Color connection_color = {100, 255, 100, 255};
+    const SDL_Color contention_color = {255, 70, 220, 255};
+    visible_count = collect_visible(&wire_grid, cull_left, cull_top, cull_right, cull_bottom);
+    for (size_t v = 0; v < visible_count; ++v)
     {
+        size_t i = visible_ids[v];
         EditorWire *w = &wires[i];
         if (w->count < 1)
             continue;
         // pick color: selected wires highlighted
-        if (selected_type == SELECT_WIRE && (int)i == selected_index)
-        {
-            SDL_SetRenderDrawColor(renderer, 255, 130, 130, 255);
-        }
-        else
-        {
-            SDL_SetRenderDrawColor(renderer, 180, 180, 180, 255);
-        }
+        SDL_Color wire_color = ((int)i == selected_wire)
+                                   ? (SDL_Color){255, 130, 130, 255}
+                                   : (SDL_Color){180, 180, 180, 255};
+        uint8_t timing_flags = (show_timing && i < timing_ids.wire_count) ? timing_wire_flags[i] : 0;
+        if ((int)i != selected_wire && timing_flags)
+            wire_color = (timing_flags & TIMING_GLITCH) ? glitch_color : critical_color;
+        // Drivers fighting over the net win over everything but the selection
+        if ((int)i != selected_wire && w->logic_wire && wire_contended(wire_find(w->logic_wire)))
+            wire_color = contention_color;
         for (size_t s = 0; s < w->count; ++s)
         {
             float sx, sy;
             camera_world_to_screen(&editor_camera, w->points[s].x, w->points[s].y, &sx, &sy);
             // draw point marker
-            SDL_RenderFillRect(renderer, &(SDL_FRect){sx - 1.5f, sy - 1.5f, 3.0f, 3.0f});
+            render_batch_fill_rect(&editor_batch, &(SDL_FRect){sx - 1.5f, sy - 1.5f, 3.0f, 3.0f}, wire_color);
             if (s + 1 < w->count)
             {
                 float nx, ny;
                 camera_world_to_screen(&editor_camera, w->points[s + 1].x, w->points[s + 1].y, &nx, &ny);
-                SDL_RenderLine(renderer, sx, sy, nx, ny);
+                render_batch_line(&editor_batch, sx, sy, nx, ny, 1.0f, wire_color);
             }
         }
         // draw endpoint connection indicators if connected to gate pins
-        if (w->start_gate_index >= 0)
+        size_t start_gate = slot_map_index(&gate_slots, w->start_gate);
+        size_t end_gate = slot_map_index(&gate_slots, w->end_gate);
+        if (start_gate != SLOT_MAP_NO_INDEX)
         {
             float px, py;
-            gate_pin_world(&gates[w->start_gate_index], w->start_pin, &px, &py);
+            gate_pin_world(&gates[start_gate], w->start_pin, &px, &py);
             float sxp, syp;
             camera_world_to_screen(&editor_camera, px, py, &sxp, &syp);
-            SDL_SetRenderDrawColor(renderer, 100, 255, 100, 255);
-            SDL_RenderFillRect(renderer, &(SDL_FRect){sxp - 3.0f, syp - 3.0f, 6.0f, 6.0f});
+            render_batch_fill_rect(&editor_batch, &(SDL_FRect){sxp - 3.0f, syp - 3.0f, 6.0f, 6.0f}, connection_color);
         }
-        if (w->end_gate_index >= 0)
+        if (end_gate != SLOT_MAP_NO_INDEX)
         {
             float px, py;
-            gate_pin_world(&gates[w->end_gate_index], w->end_pin, &px, &py);
+            gate_pin_world(&gates[end_gate], w->end_pin, &px, &py);
             float sxp, syp;
             camera_world_to_screen(&editor_camera, px, py, &sxp, &syp);
-            SDL_SetRenderDrawColor(renderer, 100, 255, 100, 255);
-            SDL_RenderFillRect(renderer, &(SDL_FRect){sxp - 3.0f, syp - 3.0f, 6.0f, 6.0f});
+            render_batch_fill_rect(&editor_batch, &(SDL_FRect){sxp - 3.0f, syp - 3.0f, 6.0f, 6.0f}, connection_color);
         }
     }
 
-    // Render wire points being placed
+    // Render wire points being placed (flushes the wire layer together with the preview)
     wire_placement_render(renderer, &editor_camera);
 
-    // Render lamps
-    for (size_t i = 0; i < lamp_count; ++i)
+    // Render visible lamps
+    visible_count = collect_visible(&lamp_grid, cull_left, cull_top, cull_right, cull_bottom);
+    for (size_t v = 0; v < visible_count; ++v)
     {
+        size_t i = visible_ids[v];
         float sx, sy;
         camera_world_to_screen(&editor_camera, lamps[i].x, lamps[i].y, &sx, &sy);
 
@@ -1210,7 +2377,7 @@ void editor_render(SDL_Renderer *renderer)
         {
             if (lamps[i].logic_lamp->input)
             {
-                lamps[i].logic_lamp->state = lamps[i].logic_lamp->input->state;
+                lamps[i].logic_lamp->state = wire_state(wire_find(lamps[i].logic_lamp->input));
             }
             else
             {
@@ -1228,13 +2395,16 @@ void editor_render(SDL_Renderer *renderer)
         case LOW:
             color = (SDL_Color){90, 90, 90, 255};
             break;
+        case HIGH_Z:
+            color = (SDL_Color){60, 70, 110, 255};
+            break;
         case UNKNOWN:
         default:
             color = (SDL_Color){140, 140, 180, 255};
             break;
         }
 
-        bool is_selected = (selected_type == SELECT_LAMP && (int)i == selected_index);
+        bool is_selected = (int)i == selected_lamp;
         if (is_selected)
         {
             color.r = (Uint8)((color.r + 255) / 2);
@@ -1242,10 +2412,9 @@ void editor_render(SDL_Renderer *renderer)
             color.b = (Uint8)((color.b + 160) / 2);
         }
 
-        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-        SDL_RenderFillRect(renderer, &(SDL_FRect){sx - lamps[i].radius, sy - lamps[i].radius, lamps[i].radius * 2.0f, lamps[i].radius * 2.0f});
-        SDL_SetRenderDrawColor(renderer, 40, 40, 40, 255);
-        SDL_RenderRect(renderer, &(SDL_FRect){sx - lamps[i].radius, sy - lamps[i].radius, lamps[i].radius * 2.0f, lamps[i].radius * 2.0f});
+        SDL_FRect lamp_rect = {sx - lamps[i].radius, sy - lamps[i].radius, lamps[i].radius * 2.0f, lamps[i].radius * 2.0f};
+        render_batch_fill_rect(&editor_batch, &lamp_rect, color);
+        render_batch_rect(&editor_batch, &lamp_rect, 1.0f, (SDL_Color){40, 40, 40, 255});
     }
 
     if (lamp_placement_active)
@@ -1254,8 +2423,8 @@ void editor_render(SDL_Renderer *renderer)
         snap_to_grid(pointer_world_x, pointer_world_y, &snap_x, &snap_y);
         float sx, sy;
         camera_world_to_screen(&editor_camera, (float)snap_x, (float)snap_y, &sx, &sy);
-        SDL_SetRenderDrawColor(renderer, 255, 220, 120, 180);
-        SDL_RenderRect(renderer, &(SDL_FRect){sx - LAMP_DEFAULT_RADIUS, sy - LAMP_DEFAULT_RADIUS, LAMP_DEFAULT_RADIUS * 2.0f, LAMP_DEFAULT_RADIUS * 2.0f});
+        render_batch_rect(&editor_batch, &(SDL_FRect){sx - LAMP_DEFAULT_RADIUS, sy - LAMP_DEFAULT_RADIUS, LAMP_DEFAULT_RADIUS * 2.0f, LAMP_DEFAULT_RADIUS * 2.0f},
+                          1.0f, (SDL_Color){255, 220, 120, 180});
     }
     if (switch_placement_active)
     {
@@ -1264,14 +2433,77 @@ void editor_render(SDL_Renderer *renderer)
         float sx, sy;
         camera_world_to_screen(&editor_camera, (float)snap_x, (float)snap_y, &sx, &sy);
         // draw a small rectangle representing the switch
-        SDL_SetRenderDrawColor(renderer, 180, 220, 180, 200);
-        SDL_RenderRect(renderer, &(SDL_FRect){sx - 10.0f, sy - 7.0f, 20.0f, 14.0f});
+        render_batch_rect(&editor_batch, &(SDL_FRect){sx - 10.0f, sy - 7.0f, 20.0f, 14.0f}, 1.0f, (SDL_Color){180, 220, 180, 200});
+    }
+    render_batch_flush(&editor_batch, renderer);
+
+    // The cycle and change counters can move every frame; formatting them at most every
+    // STATUS_REFRESH_NS keeps their text in the cache in between. A stopped clock only
+    // moves on a step, which shows at once.
+    Uint64 now = SDL_GetTicksNS();
+    bool refresh = now - status_refresh_time >= STATUS_REFRESH_NS;
+    if (refresh)
+        status_refresh_time = now;
+    if (refresh || !clock_running)
+    {
+        if (clock_running)
+            SDL_snprintf(clock_status, sizeof(clock_status), "Cycle %llu  (%.0f cycles/s)",
+                         (unsigned long long)clock_cycles, clock_rate);
+        else
+            SDL_snprintf(clock_status, sizeof(clock_status), "Cycle %llu", (unsigned long long)clock_cycles);
+    }
+    if (wave_recording && (refresh || wave_status[0] == '\0'))
+        SDL_snprintf(wave_status, sizeof(wave_status), "REC  %zu signals, %zu changes", wave_rec.signal_count,
+                     wave_rec.changes);
+    // One status line per row; each stays short enough for the text cache
+    float status_y = 10.0f;
+    if (gate_label_font && (clock_cycles > 0 || clock_running))
+    {
+        render_text(renderer, gate_label_font, clock_status, 10.0f, status_y, (SDL_Color){235, 235, 235, 255});
+        status_y += 20.0f;
+    }
+    if (gate_label_font && show_timing)
+    {
+        char status[64];
+        double mhz = timing_critical_delay > 0 ? 1e6 / (double)timing_critical_delay : 0.0;
+        SDL_snprintf(status, sizeof(status), "Critical path %u ps, %zu gates (%.0f MHz)", timing_critical_delay,
+                     timing_path_length, mhz);
+        render_text(renderer, gate_label_font, status, 10.0f, status_y, critical_color);
+        status_y += 20.0f;
+        if (timing_change_shown)
+        {
+            SDL_snprintf(status, sizeof(status), "Last change: %zu glitches, settled at %llu ps", timing_glitches,
+                         (unsigned long long)timing_settle);
+            render_text(renderer, gate_label_font, status, 10.0f, status_y, critical_color);
+            status_y += 20.0f;
+        }
+    }
+    if (gate_label_font && wave_recording)
+    {
+        render_text(renderer, gate_label_font, wave_status, 10.0f, status_y, (SDL_Color){255, 90, 90, 255});
+        status_y += 20.0f;
+    }
+    size_t contended = wire_contention_count();
+    if (gate_label_font && contended > 0)
+    {
+        char status[64];
+        SDL_snprintf(status, sizeof(status), "Bus contention on %zu net%s", contended, contended == 1 ? "" : "s");
+        render_text(renderer, gate_label_font, status, 10.0f, status_y, contention_color);
+        status_y += 20.0f;
+    }
+    if (gate_label_font && edit_evaluations > 0)
+    {
+        char status[64];
+        SDL_snprintf(status, sizeof(status), "Last edit: %zu of %zu gates evaluated", edit_evaluations, gate_count);
+        render_text(renderer, gate_label_font, status, 10.0f, status_y, (SDL_Color){160, 200, 160, 255});
     }
 }
 
 void editor_create_lamp(float world_x, float world_y)
 {
     ensure_lamps_capacity();
+    if (slot_map_insert(&lamp_slots) == SLOT_NONE)
+        return;
     int snap_x, snap_y;
     snap_to_grid(world_x, world_y, &snap_x, &snap_y);
 
@@ -1279,12 +2511,8 @@ void editor_create_lamp(float world_x, float world_y)
     l->x = (float)snap_x;
     l->y = (float)snap_y;
     l->radius = LAMP_DEFAULT_RADIUS;
-    l->logic_lamp = malloc(sizeof(struct Lamp));
-    if (l->logic_lamp)
-    {
-        l->logic_lamp->input = NULL;
-        l->logic_lamp->state = UNKNOWN;
-    }
+    index_lamp(lamp_count - 1);
+    l->logic_lamp = logic_pool_new_lamp(&logic_pool, NULL);
 
     connect_lamp_to_nearby_wire(l);
     lamp_placement_active = false;
@@ -1334,8 +2562,13 @@ static int find_nearest_gate_pin(float world_x, float world_y, float max_distanc
     float best_sq = max_sq;
     int best_gate = -1;
     GatePinType best_pin = PIN_OUTPUT;
-    for (size_t i = 0; i < gate_count; ++i)
+    // Pins lie on the gate outline, so only gates whose box reaches the search square matter.
+    // Visit them in index order so ties resolve exactly as a full scan would.
+    size_t n = collect_near(&gate_grid, world_x, world_y, max_distance);
+    const uint32_t *candidates = near_ids;
+    for (size_t k = 0; k < n; ++k)
     {
+        size_t i = candidates[k];
         EditorGate *eg = &gates[i];
         float input_x = eg->x;
         float output_x = eg->x + eg->width;
@@ -1395,32 +2628,218 @@ static int find_nearest_gate_pin(float world_x, float world_y, float max_distanc
 
 static int hit_test_gate(float world_x, float world_y)
 {
-    for (size_t i = 0; i < gate_count; ++i)
+    const uint32_t *ids;
+    size_t n = spatial_hash_query(&gate_grid, world_x, world_y, world_x, world_y, &ids);
+    int best = -1;
+    for (size_t k = 0; k < n; ++k)
     {
+        size_t i = ids[k];
         float gx = gates[i].x;
         float gy = gates[i].y;
         float w = gates[i].width;
         float h = gates[i].height;
-        if (world_x >= gx && world_x <= gx + w && world_y >= gy && world_y <= gy + h)
-            return (int)i;
+        if (world_x >= gx && world_x <= gx + w && world_y >= gy && world_y <= gy + h && (best < 0 || (int)i < best))
+            best = (int)i;
     }
-    return -1;
+    return best;
 }
 
-static void detach_gates_from_wire(struct Wire *logic_wire)
+// Exact key of a wire endpoint; connected endpoints are snapped to identical coordinates
+static uint64_t wire_point_key(WirePoint p)
 {
-    if (!logic_wire)
-        return;
-    for (size_t i = 0; i < gate_count; ++i)
+    float x = p.x + 0.0f; // folds -0.0 into 0.0
+    float y = p.y + 0.0f;
+    uint32_t kx, ky;
+    memcpy(&kx, &x, sizeof(kx));
+    memcpy(&ky, &y, sizeof(ky));
+    return ((uint64_t)kx << 32) | ky;
+}
+
+// Node of a surviving segment that ends where the deleted segment ended closest to (x, y),
+// i.e. the segment a pin or lamp at (x, y) is still connected through. NULL if none.
+static struct Wire *find_surviving_node(const EditorWire *deleted, const size_t *members, size_t member_count,
+                                        float x, float y)
+{
+    WirePoint end = deleted->points[0];
+    if (deleted->count > 1)
+    {
+        WirePoint last = deleted->points[deleted->count - 1];
+        if (distance_sq(x, y, last.x, last.y) < distance_sq(x, y, end.x, end.y))
+            end = last;
+    }
+    uint64_t key = wire_point_key(end);
+    for (size_t m = 0; m < member_count; ++m)
+    {
+        const EditorWire *w = &wires[members[m]];
+        if (wire_point_key(w->points[0]) == key || wire_point_key(w->points[w->count - 1]) == key)
+            return w->logic_wire;
+    }
+    return NULL;
+}
+
+// Add gate to the drivers of split_net_after_delete unless it is there already
+static void add_split_driver(struct Gate *gate, size_t *driver_count)
+{
+    for (size_t d = 0; d < *driver_count; ++d)
     {
-        struct Gate *g = gates[i].gate;
-        if (!g)
+        if (split_drivers[d] == gate)
+            return;
+    }
+    split_drivers[(*driver_count)++] = gate;
+}
+
+// Gates whose output pin a segment end is attached to drive the segment's net: only
+// wire placement connects gate outputs, and it records the pin at the segment end
+static void collect_split_drivers(const EditorWire *w, const struct Wire *old_net, size_t *driver_count)
+{
+    SlotHandle ends[2] = {w->start_gate, w->end_gate};
+    GatePinType pins[2] = {w->start_pin, w->end_pin};
+    for (int e = 0; e < 2; ++e)
+    {
+        size_t gi = (ends[e] != SLOT_NONE && pins[e] == PIN_OUTPUT) ? slot_map_index(&gate_slots, ends[e])
+                                                                      : SLOT_MAP_NO_INDEX;
+        if (gi >= gate_count)
             continue;
-        if (g->input1 == logic_wire)
-            g->input1 = NULL;
-        if (g->input2 == logic_wire)
-            g->input2 = NULL;
-        if (g->output == logic_wire)
-            g->output = NULL;
+        struct Gate *g = gates[gi].gate;
+        if (g && g->output && wire_find(g->output) == old_net)
+            add_split_driver(g, driver_count);
+    }
+}
+
+// Remove the net node of wires[deleted_index] and split its net into the parts that are
+// still connected. Pins and lamps on the deleted node move to a surviving segment at the
+// same endpoint (or are disconnected), the remaining segments of the net are reset and
+// re-joined through their shared endpoints, and the readers and drivers of the old net
+// are relinked. Fragments left without a driver float (HIGH_Z); a net that never had
+// one (a switch) keeps its state in every fragment.
+// Only the old net is touched: its segments come from its ring of nodes, its readers
+// from its fanout and its drivers from the gate pins recorded at the segment ends, and
+// the pins and lamps on the deleted node are found through the spatial indexes.
+// Returns false (nothing changed) on allocation failure.
+static bool split_net_after_delete(size_t deleted_index)
+{
+    EditorWire *deleted = &wires[deleted_index];
+    struct Wire *node = deleted->logic_wire;
+    if (!node)
+        return true;
+    struct Wire *old_net = wire_find(node);
+    SignalState old_state = wire_state(old_net);
+
+    size_t ring_count = 0;
+    for (struct Wire *m = node->net_next; m != node; m = m->net_next)
+        ring_count++;
+    size_t reader_count = (size_t)old_net->num_fanout;
+    size_t table_size = 16;
+    while (table_size < ring_count * 4)
+        table_size <<= 1;
+    if (!reserve_array((void **)&split_members, &split_member_capacity, ring_count + 1, sizeof(size_t)) ||
+        !reserve_array((void **)&split_readers, &split_reader_capacity, reader_count + 1, sizeof(struct Gate *)) ||
+        !reserve_array((void **)&split_drivers, &split_driver_capacity, 2 * ring_count + 2, sizeof(struct Gate *)) ||
+        !reserve_array((void **)&split_table_keys, &split_table_key_capacity, table_size, sizeof(uint64_t)) ||
+        !reserve_array((void **)&split_table_nodes, &split_table_node_capacity, table_size, sizeof(struct Wire *)))
+        return false;
+    size_t *members = split_members;
+    size_t member_count = 0;
+    for (struct Wire *m = node->net_next; m != node; m = m->net_next)
+    {
+        size_t i = node_owner_index(m);
+        if (i < wire_count)
+            members[member_count++] = i;
+    }
+    if (reader_count > 0)
+        memcpy(split_readers, old_net->fanout, reader_count * sizeof(struct Gate *));
+    size_t driver_count = 0;
+    collect_split_drivers(deleted, old_net, &driver_count);
+    for (size_t m = 0; m < member_count; ++m)
+        collect_split_drivers(&wires[members[m]], old_net, &driver_count);
+
+    // Pins and lamps on the deleted node sit at its ends; fanout lists and drivers are
+    // rebuilt below
+    for (int end = 0; end < 2; ++end)
+    {
+        WirePoint p = (end == 0) ? deleted->points[0] : deleted->points[deleted->count - 1];
+        const uint32_t *ids;
+        size_t n = query_near(&gate_grid, p.x, p.y, GATE_PIN_SNAP_RADIUS, &ids);
+        for (size_t k = 0; k < n; ++k)
+        {
+            EditorGate *eg = &gates[ids[k]];
+            struct Gate *g = eg->gate;
+            if (!g)
+                continue;
+            float px, py;
+            if (g->input1 == node)
+            {
+                gate_pin_world(eg, PIN_INPUT1, &px, &py);
+                g->input1 = find_surviving_node(deleted, members, member_count, px, py);
+            }
+            if (g->input2 == node)
+            {
+                gate_pin_world(eg, PIN_INPUT2, &px, &py);
+                g->input2 = find_surviving_node(deleted, members, member_count, px, py);
+            }
+            if (g->output == node)
+            {
+                gate_pin_world(eg, PIN_OUTPUT, &px, &py);
+                g->output = find_surviving_node(deleted, members, member_count, px, py);
+            }
+        }
+        n = query_near(&lamp_grid, p.x, p.y, LAMP_CONNECTION_RADIUS, &ids);
+        for (size_t k = 0; k < n; ++k)
+        {
+            EditorLamp *l = &lamps[ids[k]];
+            struct Lamp *lamp = l->logic_lamp;
+            if (!lamp || lamp->input != node)
+                continue;
+            lamp->input = find_surviving_node(deleted, members, member_count, l->x, l->y);
+            if (!lamp->input)
+                lamp->state = UNKNOWN;
+        }
+    }
+
+    // Dissolve the old net, then re-join the segments that share an endpoint
+    SignalState fragment_state = (driver_count > 0) ? HIGH_Z : old_state;
+    wire_reset(node);
+    for (size_t m = 0; m < member_count; ++m)
+    {
+        struct Wire *member = wires[members[m]].logic_wire;
+        wire_reset(member);
+        wire_set_state(member, fragment_state);
+    }
+    uint64_t *table_keys = split_table_keys;
+    struct Wire **table_nodes = split_table_nodes;
+    memset(table_nodes, 0, table_size * sizeof(struct Wire *));
+    for (size_t m = 0; m < member_count; ++m)
+    {
+        const EditorWire *w = &wires[members[m]];
+        for (int end = 0; end < 2; ++end)
+        {
+            uint64_t key = wire_point_key(end == 0 ? w->points[0] : w->points[w->count - 1]);
+            size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (table_size - 1);
+            while (table_nodes[slot] && table_keys[slot] != key)
+                slot = (slot + 1) & (table_size - 1);
+            if (table_nodes[slot])
+            {
+                wire_union(table_nodes[slot], w->logic_wire);
+            }
+            else
+            {
+                table_keys[slot] = key;
+                table_nodes[slot] = w->logic_wire;
+            }
+        }
+    }
+    for (size_t r = 0; r < reader_count; ++r)
+    {
+        // Readers that lost the input read LOW now, the others may see fewer drivers
+        gate_relink_inputs(split_readers[r]);
+        mark_gate_dirty(split_readers[r]);
     }
+    for (size_t d = 0; d < driver_count; ++d)
+        gate_relink_output(split_drivers[d]);
+    for (size_t m = 0; m < member_count; ++m)
+        mark_net_dirty(wires[members[m]].logic_wire);
+
+    logic_pool_delete_wire(&logic_pool, node);
+    deleted->logic_wire = NULL;
+    return true;
 }
@@ -2,6 +2,7 @@
 #define EDITOR_H
 
 #include "logic.h"
+#include "netlist.h"
 #include "camera.h"
 #include <stddef.h>
 #include <stdbool.h>
@@ -127,16 +128,75 @@ void editor_cancel_gate_placement(void);
 int editor_is_gate_placement_active(void);
 void editor_create_gate(float world_x, float world_y);
 
-// Force a signal propagation pass (updates gates, wires, lamps)
+// Force a signal propagation pass (updates gates, wires, lamps). Edits do not need it:
+// each one re-simulates only the fanout cone of what it changed.
 void editor_propagate_signals(void);
 
+// Gates evaluated by the last edit (or forced propagation pass)
+size_t editor_get_edit_evaluations(void);
+
+// Clocked simulation: one full cycle of every CLOCK gate (rising, then falling edge;
+// flip-flops take their inputs on the rising edge). editor_clock_toggle_running starts
+// or stops a free-running clock that editor_clock_update advances once per frame.
+void editor_clock_step(void);
+void editor_clock_toggle_running(void);
+void editor_clock_update(void);
+
+// Timing view: highlights the critical path (gate delays from timing_model_default)
+// and shows its delay. While it is on, setting a wire HIGH or LOW also replays the
+// change with gate delays and marks the wires that glitched.
+void editor_timing_toggle_view(void);
+
+// Waveform recording of every net to a VCD file (see waveform.h), one time step per
+// simulation step and clock edge. Changing the wiring stops the recording.
+// editor_waveform_start returns 0 if the file cannot be created.
+int editor_waveform_start(const char *path);
+void editor_waveform_stop(void);
+int editor_waveform_is_recording(void);
+
+// Number of gate ranks on the longest input-to-output path (feedback loops count as one rank)
+int editor_get_combinational_depth(void);
+
+// Where the editor's gates, wires and lamps ended up in a compiled netlist. The netlist
+// reorders gates and renumbers nets for locality; these tables map both ways. Entries
+// are NETLIST_NO_NET for objects without logic (empty gate slots, unconnected lamps).
+struct EditorNetlistIds
+{
+    uint32_t *gate;        // Netlist gate of each editor gate
+    uint32_t *gate_editor; // Editor gate index of each netlist gate
+    uint32_t *wire_net;    // Net of each editor wire
+    uint32_t *lamp_net;    // Net of each lamp's input
+    size_t gate_count;     // Editor object counts when the tables were built
+    size_t wire_count;
+    size_t lamp_count;
+};
+
+// Compile the current design for batch (bit-parallel) simulation; free with netlist_free.
+// ids is optional; when given it is filled in and must be released with editor_netlist_ids_free.
+int editor_compile_netlist(struct Netlist *nl, struct EditorNetlistIds *ids);
+void editor_netlist_ids_free(struct EditorNetlistIds *ids);
+
+// Nets of wires that no gate drives, in wire order without duplicates (the design's inputs).
+// Returns the number of nets found; at most max_nets are written to out_nets.
+size_t editor_get_input_nets(const struct Netlist *nl, const struct EditorNetlistIds *ids,
+                             uint32_t *out_nets, size_t max_nets);
+
+// Net of every lamp in lamp order (NETLIST_NO_NET for unconnected lamps). Returns the lamp count.
+size_t editor_get_lamp_nets(const struct EditorNetlistIds *ids, uint32_t *out_nets, size_t max_nets);
+
+// Save the design (geometry, connectivity, net states and its compiled netlist) as a .vlg
+// file, or replace the current design with one loaded from disk. Return 0 on failure.
+int editor_save(const char *path);
+int editor_load(const char *path);
+
 // Toggle selected switch (if selection is a switch)
 void editor_toggle_selected_switch(void);
 
 // Directly set the selected gate type
 void editor_set_selected_gate_type(GateType type);
 
-// Set the currently selected wire state directly (HIGH/LOW/UNKNOWN)
+// Set the currently selected wire state directly (HIGH/LOW/UNKNOWN). Nets driven by a
+// gate keep their resolved state.
 void editor_set_selected_wire_state(SignalState state);
 
 // Delete the currently selected object (wire/lamp/gate)
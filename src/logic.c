@@ -1,74 +1,254 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include "logic.h"
 
+// Net state table: NET_STATE_BITS per wire, NET_STATES_PER_WORD to a word. Entries of
+// released wires are reused; once every entry is free the table starts over.
+#define NET_STATE_MASK ((1u << NET_STATE_BITS) - 1)
+static uint64_t *state_words = NULL;
+static uint32_t *state_drivers = NULL; // Per entry: driver counts, see DRIVE_COUNT_BITS
+static size_t state_word_capacity = 0;
+static size_t state_slot_count = 0; // Entries handed out, including freed ones
+static uint32_t *state_free = NULL; // Stack of freed entries
+static size_t state_free_count = 0;
+static size_t state_free_capacity = 0;
+
+static SignalState state_get(uint32_t slot)
+{
+    uint64_t word = state_words[slot / NET_STATES_PER_WORD];
+    return (SignalState)((word >> (slot % NET_STATES_PER_WORD * NET_STATE_BITS)) & NET_STATE_MASK);
+}
+
+static void state_put(uint32_t slot, SignalState state)
+{
+    unsigned shift = slot % NET_STATES_PER_WORD * NET_STATE_BITS;
+    uint64_t *word = &state_words[slot / NET_STATES_PER_WORD];
+    *word = (*word & ~((uint64_t)NET_STATE_MASK << shift)) | ((uint64_t)(state & NET_STATE_MASK) << shift);
+}
+
+// New entry, UINT32_MAX when out of memory
+static uint32_t state_slot_alloc(void)
+{
+    if (state_free_count > 0)
+        return state_free[--state_free_count];
+    if (state_slot_count >= UINT32_MAX)
+        return UINT32_MAX;
+    if (state_slot_count == state_word_capacity * NET_STATES_PER_WORD)
+    {
+        size_t new_capacity = state_word_capacity == 0 ? 64 : state_word_capacity * 2;
+        uint64_t *words = realloc(state_words, new_capacity * sizeof(uint64_t));
+        if (!words)
+            return UINT32_MAX;
+        state_words = words;
+        uint32_t *drivers = realloc(state_drivers, new_capacity * NET_STATES_PER_WORD * sizeof(uint32_t));
+        if (!drivers)
+            return UINT32_MAX;
+        state_drivers = drivers;
+        state_word_capacity = new_capacity;
+    }
+    return (uint32_t)state_slot_count++;
+}
+
+static void state_slot_free(uint32_t slot)
+{
+    if (state_free_count + 1 == state_slot_count)
+    {
+        // That was the last entry in use
+        state_slot_count = 0;
+        state_free_count = 0;
+        free(state_free);
+        state_free = NULL;
+        state_free_capacity = 0;
+        return;
+    }
+    if (state_free_count == state_free_capacity)
+    {
+        size_t new_capacity = state_free_capacity == 0 ? 64 : state_free_capacity * 2;
+        uint32_t *grown = realloc(state_free, new_capacity * sizeof(uint32_t));
+        if (!grown)
+            return; // The entry is never reused
+        state_free = grown;
+        state_free_capacity = new_capacity;
+    }
+    state_free[state_free_count++] = slot;
+}
+
+SignalState wire_state(const struct Wire *wire)
+{
+    return state_get(wire->state_slot);
+}
+
+void wire_set_state(struct Wire *wire, SignalState state)
+{
+    state_put(wire->state_slot, state);
+}
+
+size_t wire_state_bytes(void)
+{
+    return state_word_capacity * (sizeof(uint64_t) + NET_STATES_PER_WORD * sizeof(uint32_t)) +
+           state_free_capacity * sizeof(uint32_t);
+}
+
+// Drivers of a net by value, packed into one word: three DRIVE_COUNT_BITS counts for
+// LOW, HIGH and UNKNOWN (HIGH_Z drivers do not count), so a driver change is one add
+// and one subtract of drive_unit. A net takes up to 1023 drivers of each value.
+#define DRIVE_COUNT_BITS 10
+#define DRIVE_COUNT_MASK ((1u << DRIVE_COUNT_BITS) - 1)
+static const uint32_t drive_unit[4] = {1u, 1u << DRIVE_COUNT_BITS, 1u << (2 * DRIVE_COUNT_BITS), 0u};
+
+// Net state by which driver values are present (bit 0 LOW, 1 HIGH, 2 UNKNOWN)
+static const uint8_t drive_resolution[8] = {HIGH_Z, LOW, HIGH, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN};
+
+static size_t contended_nets = 0;
+
+static unsigned drive_presence(uint32_t drivers)
+{
+    return (unsigned)((drivers & DRIVE_COUNT_MASK) != 0) |
+           (unsigned)(((drivers >> DRIVE_COUNT_BITS) & DRIVE_COUNT_MASK) != 0) << 1 |
+           (unsigned)((drivers >> (2 * DRIVE_COUNT_BITS)) != 0) << 2;
+}
+
+static size_t drive_contended(uint32_t drivers)
+{
+    return (drive_presence(drivers) & 3u) == 3u;
+}
+
+// Add and remove drivers (as packed counts) on a net root, keep the contention count
+// in step and resolve the net
+static SignalState net_redrive(struct Wire *net, uint32_t added, uint32_t removed)
+{
+    uint32_t *drivers = &state_drivers[net->state_slot];
+    contended_nets -= drive_contended(*drivers);
+    *drivers += added;
+    *drivers -= removed;
+    contended_nets += drive_contended(*drivers);
+    SignalState state = (SignalState)drive_resolution[drive_presence(*drivers)];
+    state_put(net->state_slot, state);
+    return state;
+}
+
+// gate_drive on the gate's output net root
+static SignalState drive_net(struct Gate *gate, struct Wire *net, SignalState value)
+{
+    uint32_t *drivers = &state_drivers[net->state_slot];
+    uint32_t added = drive_unit[value & NET_STATE_MASK];
+    uint32_t removed = drive_unit[gate->drive & NET_STATE_MASK];
+    gate->drive = value;
+    if (*drivers == removed)
+    {
+        // The only driver that is not HIGH_Z (the common case): the net takes its value
+        *drivers = added;
+        state_put(net->state_slot, value);
+        return value;
+    }
+    return net_redrive(net, added, removed);
+}
+
+int wire_contended(const struct Wire *wire)
+{
+    return (int)drive_contended(state_drivers[wire->state_slot]);
+}
+
+int wire_driven(const struct Wire *wire)
+{
+    return state_drivers[wire->state_slot] != 0;
+}
+
+size_t wire_contention_count(void)
+{
+    return contended_nets;
+}
+
+// Four-valued truth tables, indexed by gate type and in_a << 2 | in_b. Rows are in_a
+// (LOW, HIGH, UNKNOWN, HIGH_Z), columns in_b in the same order.
+#define S0 LOW
+#define S1 HIGH
+#define SX UNKNOWN
+#define SZ HIGH_Z
+#define TABLE_BUFFER S0, S0, S0, S0, S1, S1, S1, S1, SX, SX, SX, SX, SX, SX, SX, SX
+static const uint8_t gate_table[GATE_TYPE_COUNT][16] = {
+    // CONSTANT_LOW
+    {S0, S0, S0, S0, S0, S0, S0, S0, S0, S0, S0, S0, S0, S0, S0, S0},
+    // CONSTANT_HIGH
+    {S1, S1, S1, S1, S1, S1, S1, S1, S1, S1, S1, S1, S1, S1, S1, S1},
+    // AND
+    {S0, S0, S0, S0, S0, S1, SX, SX, S0, SX, SX, SX, S0, SX, SX, SX},
+    // OR
+    {S0, S1, SX, SX, S1, S1, S1, S1, SX, S1, SX, SX, SX, S1, SX, SX},
+    // INVERT
+    {S1, S1, S1, S1, S0, S0, S0, S0, SX, SX, SX, SX, SX, SX, SX, SX},
+    // NAND
+    {S1, S1, S1, S1, S1, S0, SX, SX, S1, SX, SX, SX, S1, SX, SX, SX},
+    // NOR
+    {S1, S0, SX, SX, S0, S0, S0, S0, SX, S0, SX, SX, SX, S0, SX, SX},
+    // XOR
+    {S0, S1, SX, SX, S1, S0, SX, SX, SX, SX, SX, SX, SX, SX, SX, SX},
+    // XNOR
+    {S1, S0, SX, SX, S0, S1, SX, SX, SX, SX, SX, SX, SX, SX, SX, SX},
+    // CLOCK: driven by sim_clock_edge
+    {S0, S0, S0, S0, S0, S0, S0, S0, S0, S0, S0, S0, S0, S0, S0, S0},
+    // DFF
+    {TABLE_BUFFER},
+    // LATCH
+    {TABLE_BUFFER},
+    // TRISTATE
+    {SZ, S0, SX, SX, SZ, S1, SX, SX, SZ, SX, SX, SX, SZ, SX, SX, SX},
+};
+
+static const uint8_t resolve_table[16] = {
+    S0, SX, SX, S0, // LOW with LOW, HIGH, UNKNOWN, HIGH_Z
+    SX, S1, SX, S1, // HIGH
+    SX, SX, SX, SX, // UNKNOWN
+    S0, S1, SX, SZ, // HIGH_Z
+};
+#undef TABLE_BUFFER
+#undef S0
+#undef S1
+#undef SX
+#undef SZ
+
+SignalState signal_resolve(SignalState a, SignalState b)
+{
+    return (SignalState)resolve_table[(a & NET_STATE_MASK) << 2 | (b & NET_STATE_MASK)];
+}
+
+SignalState gate_evaluate(GateType type, SignalState in_a, SignalState in_b)
+{
+    // Unknown types buffer input A
+    if ((unsigned)type >= GATE_TYPE_COUNT)
+        type = DFF;
+    return (SignalState)gate_table[type][(in_a & NET_STATE_MASK) << 2 | (in_b & NET_STATE_MASK)];
+}
+
+int gate_is_clocked(GateType type)
+{
+    return type == CLOCK || type == DFF;
+}
+
+SignalState gate_next_state(GateType type, SignalState in_a, SignalState in_b, SignalState out)
+{
+    if (gate_is_clocked(type))
+        return out;
+    if (type == LATCH && in_b != HIGH)
+    {
+        // Closed, or possibly closed: an unknown enable only keeps a value D agrees with
+        if (in_b == LOW || gate_evaluate(LATCH, in_a, LOW) == out)
+            return out;
+        return UNKNOWN;
+    }
+    return gate_evaluate(type, in_a, in_b);
+}
+
 void update_gate(struct Gate *gate)
 {
     // Read inputs
-    SignalState in_a = (gate->input1 != NULL) ? gate->input1->state : LOW;
-    SignalState in_b = (gate->input2 != NULL) ? gate->input2->state : LOW;
-
-    SignalState result = LOW;
-
-    switch (gate->type)
-    {
-    case CONSTANT_LOW:
-        // Constant LOW gate: always outputs LOW
-        result = LOW;
-        break;
-
-    case CONSTANT_HIGH:
-        // Constant HIGH gate: always outputs HIGH
-        result = HIGH;
-        break;
-
-    case AND:
-        // AND Logic (A * B): Output is HIGH if and only if BOTH inputs are HIGH.
-        result = (in_a == HIGH && in_b == HIGH) ? HIGH : LOW;
-        break;
-
-    case OR:
-        // OR Logic (A + B): Output is HIGH if EITHER input is HIGH.
-        result = (in_a == HIGH || in_b == HIGH) ? HIGH : LOW;
-        break;
-
-    case INVERT:
-        // NOT Logic (~A): Output is the inverse of the single input (in_a).
-        // Note: This gate type ignores in_b.
-        result = (in_a == HIGH) ? LOW : HIGH;
-        break;
-
-    case NAND:
-        // NAND Logic (~(A * B)): Output is LOW only if BOTH inputs are HIGH.
-        // This is the logical inverse of the AND gate.
-        result = !((in_a == HIGH && in_b == HIGH)) ? HIGH : LOW;
-        break;
-
-    case NOR:
-        // NOR Logic (~(A + B)): Output is HIGH only if BOTH inputs are LOW.
-        // This is the logical inverse of the OR gate.
-        result = !((in_a == HIGH || in_b == HIGH)) ? HIGH : LOW;
-        break;
-
-    case XOR:
-        // XOR Logic (A ⊕ B): Output is HIGH if inputs are DIFFERENT (odd parity).
-        result = (in_a != in_b) ? HIGH : LOW;
-        break;
-
-    case XNOR:
-        // XNOR Logic (~(A ⊕ B)): Output is HIGH if inputs are THE SAME (even parity).
-        // This is the logical inverse of the XOR gate.
-        result = (in_a == in_b) ? HIGH : LOW;
-        break;
-
-    default:
-        // Default case acts as a buffer (passes input A through) if the type is unknown.
-        result = in_a;
-        break;
-    }
+    SignalState in_a = (gate->input1 != NULL) ? wire_state(wire_find(gate->input1)) : LOW;
+    SignalState in_b = (gate->input2 != NULL) ? wire_state(wire_find(gate->input2)) : LOW;
 
     if (gate->output != NULL)
     {
-        gate->output->state = result;
+        struct Wire *out = wire_find(gate->output);
+        drive_net(gate, out, gate_next_state(gate->type, in_a, in_b, wire_state(out)));
     }
 }
 
@@ -76,10 +256,734 @@ void print_status(const char *wire_name, struct Wire *wire)
 {
     if (wire != NULL)
     {
-        printf("%s is %s\n", wire_name, (wire->state == HIGH) ? "HIGH (1)" : "LOW (0)");
+        static const char *const state_names[] = {"LOW (0)", "HIGH (1)", "UNKNOWN (X)", "HIGH_Z (Z)"};
+        printf("%s is %s\n", wire_name, state_names[wire_state(wire_find(wire))]);
     }
     else
     {
         printf("%s is uninitialized.\n", wire_name);
     }
 }
+
+int wire_init(struct Wire *wire, SignalState state)
+{
+    wire->fanout = NULL;
+    wire->num_fanout = 0;
+    wire->fanout_capacity = 0;
+    wire->parent = wire;
+    wire->net_rank = 0;
+    wire->net_next = wire;
+    wire->state_slot = state_slot_alloc();
+    if (wire->state_slot == UINT32_MAX)
+        return 0;
+    state_put(wire->state_slot, state);
+    state_drivers[wire->state_slot] = 0;
+    return 1;
+}
+
+void wire_release(struct Wire *wire)
+{
+    free(wire->fanout);
+    wire->fanout = NULL;
+    wire->num_fanout = 0;
+    wire->fanout_capacity = 0;
+    if (wire->state_slot != UINT32_MAX)
+    {
+        contended_nets -= drive_contended(state_drivers[wire->state_slot]);
+        state_slot_free(wire->state_slot);
+    }
+    wire->state_slot = UINT32_MAX;
+}
+
+struct Wire *wire_create(SignalState state)
+{
+    struct Wire *wire = malloc(sizeof(struct Wire));
+    if (wire && !wire_init(wire, state))
+    {
+        free(wire);
+        wire = NULL;
+    }
+    return wire;
+}
+
+void gate_init(struct Gate *gate, GateType type)
+{
+    gate->type = type;
+    gate->input1 = NULL;
+    gate->input2 = NULL;
+    gate->output = NULL;
+    gate->queue_next = NULL;
+    gate->queued = 0;
+    gate->rank = 0;
+    gate->cyclic = 0;
+    gate->clock_seen = LOW;
+    gate->sampled = LOW;
+    gate->drive = HIGH_Z;
+}
+
+SignalState gate_drive(struct Gate *gate, SignalState value)
+{
+    struct Wire *net = wire_find(gate->output);
+    if (!net)
+    {
+        gate->drive = value;
+        return UNKNOWN;
+    }
+    return drive_net(gate, net, value);
+}
+
+void gate_set_output(struct Gate *gate, struct Wire *wire)
+{
+    if (!gate || gate->output == wire)
+        return;
+    struct Wire *old_net = wire_find(gate->output);
+    // A gate driving HIGH_Z leaves both nets as they are
+    uint32_t unit = drive_unit[gate->drive & NET_STATE_MASK];
+    if (old_net && unit)
+        net_redrive(old_net, 0, unit);
+    gate->output = wire;
+    if (wire && unit)
+        net_redrive(wire_find(wire), unit, 0);
+}
+
+void gate_relink_output(struct Gate *gate)
+{
+    uint32_t unit = gate ? drive_unit[gate->drive & NET_STATE_MASK] : 0;
+    if (unit && gate->output)
+        net_redrive(wire_find(gate->output), unit, 0);
+}
+
+struct Wire *wire_find(struct Wire *wire)
+{
+    if (!wire)
+        return NULL;
+    while (wire->parent != wire)
+    {
+        // Path halving: point every other node at its grandparent
+        wire->parent = wire->parent->parent;
+        wire = wire->parent;
+    }
+    return wire;
+}
+
+void wire_destroy(struct Wire *wire)
+{
+    if (!wire)
+        return;
+    wire_release(wire);
+    free(wire);
+}
+
+static void wire_add_fanout(struct Wire *wire, struct Gate *gate)
+{
+    for (int i = 0; i < wire->num_fanout; ++i)
+    {
+        if (wire->fanout[i] == gate)
+            return;
+    }
+    if (wire->num_fanout >= wire->fanout_capacity)
+    {
+        int new_capacity = wire->fanout_capacity == 0 ? 4 : wire->fanout_capacity * 2;
+        struct Gate **grown = realloc(wire->fanout, (size_t)new_capacity * sizeof(struct Gate *));
+        if (!grown)
+            return;
+        wire->fanout = grown;
+        wire->fanout_capacity = new_capacity;
+    }
+    wire->fanout[wire->num_fanout++] = gate;
+}
+
+static void wire_remove_fanout(struct Wire *wire, struct Gate *gate)
+{
+    for (int i = 0; i < wire->num_fanout; ++i)
+    {
+        if (wire->fanout[i] == gate)
+        {
+            // Order does not matter, swap-remove
+            wire->fanout[i] = wire->fanout[--wire->num_fanout];
+            return;
+        }
+    }
+}
+
+struct Wire *wire_union(struct Wire *a, struct Wire *b)
+{
+    struct Wire *root_a = wire_find(a);
+    struct Wire *root_b = wire_find(b);
+    if (!root_a)
+        return root_b;
+    if (!root_b || root_a == root_b)
+        return root_a;
+
+    // Attach the shallower tree below the deeper one
+    if (root_a->net_rank < root_b->net_rank)
+    {
+        struct Wire *tmp = root_a;
+        root_a = root_b;
+        root_b = tmp;
+    }
+    root_b->parent = root_a;
+    if (root_a->net_rank == root_b->net_rank)
+        root_a->net_rank++;
+    // Splice the two rings of wires into one
+    struct Wire *next_a = root_a->net_next;
+    root_a->net_next = root_b->net_next;
+    root_b->net_next = next_a;
+
+    // The driver counts of both nets add up field by field
+    uint32_t drivers_b = state_drivers[root_b->state_slot];
+    state_drivers[root_b->state_slot] = 0;
+    contended_nets -= drive_contended(drivers_b);
+    if (state_drivers[root_a->state_slot] != 0 || drivers_b != 0)
+    {
+        net_redrive(root_a, drivers_b, 0);
+    }
+    else
+    {
+        wire_set_state(root_a, signal_resolve(wire_state(root_a), wire_state(root_b)));
+    }
+
+    for (int i = 0; i < root_b->num_fanout; ++i)
+        wire_add_fanout(root_a, root_b->fanout[i]);
+    free(root_b->fanout);
+    root_b->fanout = NULL;
+    root_b->num_fanout = 0;
+    root_b->fanout_capacity = 0;
+    return root_a;
+}
+
+void wire_reset(struct Wire *wire)
+{
+    if (!wire)
+        return;
+    wire->parent = wire;
+    wire->net_rank = 0;
+    wire->net_next = wire;
+    wire->num_fanout = 0;
+    contended_nets -= drive_contended(state_drivers[wire->state_slot]);
+    state_drivers[wire->state_slot] = 0;
+}
+
+void gate_set_input(struct Gate *gate, int input_index, struct Wire *wire)
+{
+    if (!gate)
+        return;
+    struct Wire **slot = (input_index == 0) ? &gate->input1 : &gate->input2;
+    struct Wire *other = (input_index == 0) ? gate->input2 : gate->input1;
+    struct Wire *old = *slot;
+    if (old == wire)
+        return;
+
+    // The gate stays in the old net's fanout if it still reads it on the other pin
+    struct Wire *old_net = wire_find(old);
+    if (old_net && old_net != wire_find(other))
+        wire_remove_fanout(old_net, gate);
+    *slot = wire;
+    if (wire)
+        wire_add_fanout(wire_find(wire), gate);
+}
+
+void gate_relink_inputs(struct Gate *gate)
+{
+    if (!gate)
+        return;
+    if (gate->input1)
+        wire_add_fanout(wire_find(gate->input1), gate);
+    if (gate->input2)
+        wire_add_fanout(wire_find(gate->input2), gate);
+}
+
+void gate_detach_inputs(struct Gate *gate)
+{
+    if (!gate)
+        return;
+    gate_set_input(gate, 0, NULL);
+    gate_set_input(gate, 1, NULL);
+}
+
+void sim_queue_init(struct SimQueue *queue)
+{
+    queue->bucket_head = NULL;
+    queue->bucket_tail = NULL;
+    queue->bucket_count = 0;
+    queue->cursor = 0;
+    queue->evaluations = 0;
+}
+
+void sim_queue_free(struct SimQueue *queue)
+{
+    sim_queue_clear(queue);
+    free(queue->bucket_head);
+    free(queue->bucket_tail);
+    sim_queue_init(queue);
+}
+
+void sim_queue_clear(struct SimQueue *queue)
+{
+    for (int r = 0; r < queue->bucket_count; ++r)
+    {
+        struct Gate *gate = queue->bucket_head[r];
+        while (gate)
+        {
+            struct Gate *next = gate->queue_next;
+            gate->queue_next = NULL;
+            gate->queued = 0;
+            gate = next;
+        }
+        queue->bucket_head[r] = NULL;
+        queue->bucket_tail[r] = NULL;
+    }
+    queue->cursor = queue->bucket_count;
+}
+
+void sim_queue_set_levels(struct SimQueue *queue, int depth)
+{
+    if (depth < 1)
+        depth = 1;
+    sim_queue_clear(queue);
+    if (depth != queue->bucket_count)
+    {
+        // bucket_count may only cover what both arrays hold: if the second realloc
+        // fails, the first array already has the new size
+        struct Gate **heads = realloc(queue->bucket_head, (size_t)depth * sizeof(struct Gate *));
+        if (heads)
+        {
+            queue->bucket_head = heads;
+            struct Gate **tails = realloc(queue->bucket_tail, (size_t)depth * sizeof(struct Gate *));
+            if (tails)
+            {
+                queue->bucket_tail = tails;
+                queue->bucket_count = depth;
+            }
+            else if (depth < queue->bucket_count)
+            {
+                queue->bucket_count = depth;
+            }
+        }
+    }
+    for (int r = 0; r < queue->bucket_count; ++r)
+    {
+        queue->bucket_head[r] = NULL;
+        queue->bucket_tail[r] = NULL;
+    }
+    queue->cursor = queue->bucket_count;
+}
+
+void sim_schedule_gate(struct SimQueue *queue, struct Gate *gate)
+{
+    if (!gate || gate->queued)
+        return;
+    if (queue->bucket_count == 0)
+    {
+        sim_queue_set_levels(queue, 1);
+        if (queue->bucket_count == 0)
+            return;
+    }
+    // Ranks outside the current levelization (stale or new gates) share the last bucket
+    int rank = gate->rank;
+    if (rank < 0)
+        rank = 0;
+    if (rank >= queue->bucket_count)
+        rank = queue->bucket_count - 1;
+
+    gate->queued = 1;
+    gate->queue_next = NULL;
+    if (queue->bucket_tail[rank])
+        queue->bucket_tail[rank]->queue_next = gate;
+    else
+        queue->bucket_head[rank] = gate;
+    queue->bucket_tail[rank] = gate;
+    if (rank < queue->cursor)
+        queue->cursor = rank;
+}
+
+void sim_schedule_fanout(struct SimQueue *queue, struct Wire *wire)
+{
+    wire = wire_find(wire);
+    if (!wire)
+        return;
+    for (int i = 0; i < wire->num_fanout; ++i)
+    {
+        sim_schedule_gate(queue, wire->fanout[i]);
+    }
+}
+
+static struct Gate *sim_pop(struct SimQueue *queue)
+{
+    while (queue->cursor < queue->bucket_count)
+    {
+        int r = queue->cursor;
+        struct Gate *gate = queue->bucket_head[r];
+        if (gate)
+        {
+            queue->bucket_head[r] = gate->queue_next;
+            if (!queue->bucket_head[r])
+                queue->bucket_tail[r] = NULL;
+            gate->queue_next = NULL;
+            gate->queued = 0;
+            return gate;
+        }
+        queue->cursor++;
+    }
+    return NULL;
+}
+
+size_t sim_run(struct SimQueue *queue, size_t max_evaluations)
+{
+    size_t evaluated = 0;
+    struct Gate *gate;
+    while (evaluated < max_evaluations && (gate = sim_pop(queue)) != NULL)
+    {
+        struct Wire *out = wire_find(gate->output);
+        SignalState prev_out = out ? wire_state(out) : UNKNOWN;
+        update_gate(gate);
+        evaluated++;
+        if (out && wire_state(out) != prev_out)
+        {
+            sim_schedule_fanout(queue, out);
+        }
+    }
+
+    // Budget exhausted (oscillation): drop the remaining events
+    if (queue->cursor < queue->bucket_count)
+        sim_queue_clear(queue);
+
+    queue->evaluations += evaluated;
+    return evaluated;
+}
+
+size_t sim_clock_edge(struct SimQueue *queue, struct Gate *const *gates, size_t count, SignalState level,
+                      size_t max_evaluations)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        struct Wire *out = (gates[i] && gates[i]->type == CLOCK) ? wire_find(gates[i]->output) : NULL;
+        if (out && (wire_state(out) != level || gates[i]->drive != level))
+        {
+            SignalState prev = wire_state(out);
+            if (gate_drive(gates[i], level) != prev)
+                sim_schedule_fanout(queue, out);
+        }
+    }
+    size_t evaluated = sim_run(queue, max_evaluations);
+
+    // Every round clocks the flip-flops whose clock rose in the previous one; a chain
+    // of n flip-flops needs at most n rounds
+    for (size_t round = 0; round <= count; ++round)
+    {
+        int changed = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            struct Gate *gate = gates[i];
+            if (!gate || gate->type != DFF)
+                continue;
+            struct Wire *out = wire_find(gate->output);
+            SignalState clock = gate->input2 ? wire_state(wire_find(gate->input2)) : LOW;
+            gate->sampled = out ? wire_state(out) : UNKNOWN;
+            if (clock == HIGH && gate->clock_seen != HIGH)
+                gate->sampled = gate_evaluate(DFF, gate->input1 ? wire_state(wire_find(gate->input1)) : LOW, LOW);
+            gate->clock_seen = clock;
+            if (out && (gate->sampled != wire_state(out) || gate->sampled != gate->drive))
+                changed = 1;
+        }
+        if (!changed)
+            break;
+        for (size_t i = 0; i < count; ++i)
+        {
+            struct Gate *gate = gates[i];
+            struct Wire *out = (gate && gate->type == DFF) ? wire_find(gate->output) : NULL;
+            if (out && (wire_state(out) != gate->sampled || gate->drive != gate->sampled))
+            {
+                SignalState prev = wire_state(out);
+                if (gate_drive(gate, gate->sampled) != prev)
+                    sim_schedule_fanout(queue, out);
+            }
+        }
+        evaluated += sim_run(queue, max_evaluations);
+    }
+    return evaluated;
+}
+
+void sim_clock_reset(struct Gate *const *gates, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (gates[i] && gates[i]->type == DFF)
+            gates[i]->clock_seen = gates[i]->input2 ? wire_state(wire_find(gates[i]->input2)) : LOW;
+    }
+}
+
+void levelization_free(struct Levelization *levels)
+{
+    free(levels->order);
+    free(levels->order_source);
+    free(levels->level_start);
+    free(levels->level_cyclic);
+    levels->order = NULL;
+    levels->order_source = NULL;
+    levels->level_start = NULL;
+    levels->level_cyclic = NULL;
+    levels->count = 0;
+    levels->depth = 0;
+    levels->cyclic_count = 0;
+    levels->valid = 0;
+}
+
+// Position of a fanout gate inside the gate set being levelized. levelize_gates
+// stores each gate's position in Gate.rank while it runs; the check against the
+// array rejects gates that are not part of the set.
+static int levelize_index_of(struct Gate *const *gates, size_t count, const struct Gate *gate)
+{
+    int idx = gate->rank;
+    if (idx < 0 || (size_t)idx >= count || gates[idx] != gate)
+        return -1;
+    return idx;
+}
+
+int levelize_gates(struct Levelization *levels, struct Gate *const *gates, size_t count)
+{
+    levelization_free(levels);
+
+    size_t n = count;
+    int *index = malloc((n + 1) * sizeof(int));    // Tarjan discovery index, -1 = unvisited
+    int *low = malloc((n + 1) * sizeof(int));      // Tarjan lowlink
+    int *scc = malloc((n + 1) * sizeof(int));      // Component id per gate
+    int *stack = malloc((n + 1) * sizeof(int));    // Tarjan component stack
+    int *call = malloc((n + 1) * sizeof(int));     // Explicit DFS stack (gate)
+    int *call_edge = malloc((n + 1) * sizeof(int)); // Next fanout edge per DFS frame
+    unsigned char *on_stack = calloc(n + 1, 1);
+    levels->order = malloc((n + 1) * sizeof(struct Gate *));
+    levels->order_source = malloc((n + 1) * sizeof(size_t));
+    if (!index || !low || !scc || !stack || !call || !call_edge || !on_stack || !levels->order ||
+        !levels->order_source)
+    {
+        free(index);
+        free(low);
+        free(scc);
+        free(stack);
+        free(call);
+        free(call_edge);
+        free(on_stack);
+        levelization_free(levels);
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        index[i] = -1;
+        if (gates[i])
+            gates[i]->rank = (int)i;
+    }
+
+    // Iterative Tarjan over the gate -> fanout graph. Components are emitted in
+    // reverse topological order, so their ids count down from the sinks.
+    // Edges into clocked gates are left out: their outputs do not follow their inputs.
+    int next_index = 0;
+    int stack_top = 0;
+    int scc_count = 0;
+    for (size_t root = 0; root < n; ++root)
+    {
+        if (!gates[root] || index[root] >= 0)
+            continue;
+        int depth = 0;
+        call[0] = (int)root;
+        call_edge[0] = 0;
+        index[root] = low[root] = next_index++;
+        stack[stack_top++] = (int)root;
+        on_stack[root] = 1;
+
+        while (depth >= 0)
+        {
+            int v = call[depth];
+            const struct Wire *out = wire_find(gates[v]->output);
+            int e = call_edge[depth];
+            if (out && e < out->num_fanout)
+            {
+                call_edge[depth]++;
+                int w = levelize_index_of(gates, n, out->fanout[e]);
+                if (w < 0 || gate_is_clocked(gates[w]->type))
+                    continue;
+                if (index[w] < 0)
+                {
+                    index[w] = low[w] = next_index++;
+                    stack[stack_top++] = w;
+                    on_stack[w] = 1;
+                    depth++;
+                    call[depth] = w;
+                    call_edge[depth] = 0;
+                }
+                else if (on_stack[w] && index[w] < low[v])
+                {
+                    low[v] = index[w];
+                }
+                continue;
+            }
+
+            // All edges of v visited
+            if (low[v] == index[v])
+            {
+                int w;
+                do
+                {
+                    w = stack[--stack_top];
+                    on_stack[w] = 0;
+                    scc[w] = scc_count;
+                } while (w != v);
+                scc_count++;
+            }
+            depth--;
+            if (depth >= 0 && low[v] < low[call[depth]])
+                low[call[depth]] = low[v];
+        }
+    }
+
+    // Rank per component: one more than the highest ranked predecessor component.
+    // Reusing the index/low arrays: comp_rank[c], comp_size[c].
+    int *comp_rank = index;
+    int *comp_size = low;
+    for (int c = 0; c < scc_count; ++c)
+    {
+        comp_rank[c] = 0;
+        comp_size[c] = 0;
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (gates[i])
+            comp_size[scc[i]]++;
+    }
+    // Bucket gates by component in topological order (highest id first)
+    int *comp_start = stack;
+    int pos = 0;
+    for (int c = scc_count - 1; c >= 0; --c)
+    {
+        comp_start[c] = pos;
+        pos += comp_size[c];
+    }
+    int *by_comp = call;
+    for (int c = 0; c < scc_count; ++c)
+        call_edge[c] = comp_start[c];
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (gates[i])
+            by_comp[call_edge[scc[i]]++] = (int)i;
+    }
+
+    int depth = 0;
+    for (int k = 0; k < pos; ++k)
+    {
+        int v = by_comp[k];
+        int c = scc[v];
+        if (comp_rank[c] + 1 > depth)
+            depth = comp_rank[c] + 1;
+        const struct Wire *out = wire_find(gates[v]->output);
+        if (!out)
+            continue;
+        for (int e = 0; e < out->num_fanout; ++e)
+        {
+            int w = levelize_index_of(gates, n, out->fanout[e]);
+            if (w < 0 || scc[w] == c || gate_is_clocked(gates[w]->type))
+                continue;
+            if (comp_rank[scc[w]] < comp_rank[c] + 1)
+                comp_rank[scc[w]] = comp_rank[c] + 1;
+        }
+    }
+
+    levels->level_start = calloc((size_t)depth + 1, sizeof(size_t));
+    levels->level_cyclic = calloc((size_t)depth + 1, 1);
+    if (!levels->level_start || !levels->level_cyclic)
+    {
+        free(index);
+        free(low);
+        free(scc);
+        free(stack);
+        free(call);
+        free(call_edge);
+        free(on_stack);
+        levelization_free(levels);
+        return 0;
+    }
+
+    // Final Gate.rank/cyclic, then counting sort into levels->order
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (!gates[i])
+            continue;
+        int c = scc[i];
+        int self_loop = 0;
+        const struct Wire *out = wire_find(gates[i]->output);
+        if (out && !gate_is_clocked(gates[i]->type) &&
+            (wire_find(gates[i]->input1) == out || wire_find(gates[i]->input2) == out))
+            self_loop = 1;
+        gates[i]->rank = comp_rank[c];
+        gates[i]->cyclic = (comp_size[c] > 1 || self_loop) ? 1 : 0;
+        levels->level_start[comp_rank[c] + 1]++;
+        if (gates[i]->cyclic)
+        {
+            levels->level_cyclic[comp_rank[c]] = 1;
+            levels->cyclic_count++;
+        }
+    }
+    for (int r = 0; r < depth; ++r)
+        levels->level_start[r + 1] += levels->level_start[r];
+    for (int r = 0; r < depth; ++r)
+        call_edge[r] = (int)levels->level_start[r];
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (!gates[i])
+            continue;
+        int slot = call_edge[gates[i]->rank]++;
+        levels->order[slot] = gates[i];
+        levels->order_source[slot] = i;
+    }
+
+    levels->count = (size_t)pos;
+    levels->depth = depth;
+    levels->valid = 1;
+
+    free(index);
+    free(low);
+    free(scc);
+    free(stack);
+    free(call);
+    free(call_edge);
+    free(on_stack);
+    return 1;
+}
+
+size_t levelized_settle(const struct Levelization *levels, int max_loop_iterations)
+{
+    size_t evaluated = 0;
+    for (int r = 0; r < levels->depth; ++r)
+    {
+        size_t begin = levels->level_start[r];
+        size_t end = levels->level_start[r + 1];
+        for (size_t i = begin; i < end; ++i)
+        {
+            update_gate(levels->order[i]);
+        }
+        evaluated += end - begin;
+        if (!levels->level_cyclic[r])
+            continue;
+
+        // Feedback loops in this rank: iterate their gates until nothing changes
+        for (int iter = 1; iter < max_loop_iterations; ++iter)
+        {
+            int changed = 0;
+            for (size_t i = begin; i < end; ++i)
+            {
+                struct Gate *gate = levels->order[i];
+                if (!gate->cyclic)
+                    continue;
+                struct Wire *out = wire_find(gate->output);
+                SignalState prev_out = out ? wire_state(out) : UNKNOWN;
+                update_gate(gate);
+                evaluated++;
+                if (out && wire_state(out) != prev_out)
+                    changed = 1;
+            }
+            if (!changed)
+                break;
+        }
+    }
+    return evaluated;
+}
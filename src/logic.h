@@ -1,6 +1,9 @@
 #ifndef LOGIC_H
 #define LOGIC_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 // Typedefs for defining some states
 typedef enum
 {
@@ -12,13 +15,23 @@ typedef enum
     NAND,
     NOR,
     XOR,
-    XNOR
+    XNOR,
+    CLOCK, // Clock source without inputs, driven by the clock stepping (sim_clock_edge)
+    DFF,   // D flip-flop: takes input1 on a rising edge of input2
+    LATCH, // D latch: follows input1 while input2 is HIGH, holds otherwise
+    TRISTATE // Tri-state buffer: drives input1 while input2 is HIGH, HIGH_Z otherwise
 } GateType;
+#define GATE_TYPE_COUNT (TRISTATE + 1)
+
+// Four-valued logic. UNKNOWN (X) is a value nobody can tell: an uninitialized net,
+// a gate reading one, or two drivers fighting. HIGH_Z is a net nobody drives; gates
+// read it as UNKNOWN. All four fit in NET_STATE_BITS bits.
 typedef enum
 {
     LOW = 0,
     HIGH = 1,
-    UNKNOWN = 2 // Just for Debugging or uninitialized wires
+    UNKNOWN = 2,
+    HIGH_Z = 3
 } SignalState;
 typedef enum
 {
@@ -39,6 +52,20 @@ struct Gate
     // Outputs
     // "Store the adress where the wire lives in memory"
     struct Wire *output;
+
+    // Event-driven simulation bookkeeping (owned by the SimQueue)
+    struct Gate *queue_next; // Next gate in the work queue
+    int queued;              // Non-zero while the gate is waiting in a queue
+
+    // Levelization results (see levelize_gates)
+    int rank;   // Topological level: 0 = driven only by primary inputs
+    int cyclic; // Non-zero if the gate is part of a feedback loop
+
+    // Clocked simulation (DFF only, see sim_clock_edge)
+    SignalState clock_seen; // Clock input when edges were last checked
+    SignalState sampled;    // Value the flip-flop takes in the current edge round
+
+    SignalState drive; // Value this gate puts on its output net (see gate_drive)
 };
 
 struct WireConnection
@@ -48,38 +75,52 @@ struct WireConnection
     union
     {
         struct Gate *gate;
-        struct Component *component;
+        struct Component *component; // Defined in component.h
         struct Lamp *lamp;
     } target;
 
     int pin_index; // Index of the pin on the target
 };
 
-struct Wire
-{
-    SignalState state;
-};
+// A wire is a node in the net table. Wires joined with wire_union form one net,
+// represented by its root wire (the net's identity): only the root's state and
+// fanout are meaningful, so always go through wire_find before using them.
+// Gate pins and lamps keep pointing at the wire they were attached to; merging
+// nets never has to rewrite them.
+//
+// A net may have several drivers (gate outputs). Its state is then the resolution
+// of their values: HIGH_Z drivers drop out, agreeing drivers win, LOW against HIGH
+// or any UNKNOWN driver gives UNKNOWN. The net table keeps a count of drivers per
+// value for every net, so a driver change resolves its net in constant time and
+// contention (LOW and HIGH drivers on one net) is known as soon as it happens.
+//
+// The state is not in the wire itself: every wire owns an entry of one packed table
+// of NET_STATE_BITS-bit states, read and written with wire_state/wire_set_state.
+// Gate evaluation then only touches the states of the nets it reads, 32 to a
+// 64-bit word, and a wire takes 40 bytes. The table is shared by all wires, so
+// wires are created and simulated on one thread.
+//
+// The wires of a net also form a ring through net_next, spliced by wire_union in
+// constant time, so a net's wires can be listed without looking at any other net.
+#define NET_STATE_BITS 2
+#define NET_STATES_PER_WORD 32
 
-struct Component
+struct Wire
 {
-    char *name; // Name of the component
-
-    // internal structure
-    struct Gate *gates;
-    int num_gates;
+    // Fanout: every gate reading this net on input1 and/or input2.
+    // Kept up to date by gate_set_input/gate_detach_inputs so the simulator
+    // only has to re-evaluate gates whose inputs actually changed.
+    struct Gate **fanout;
+    int num_fanout;
+    int fanout_capacity;
 
-    struct Component **subcomponents;
-    int num_subcomponents;
+    // Union-find (path halving + union by rank)
+    struct Wire *parent; // Points to itself for the root of a net
+    int net_rank;
 
-    struct Wire *wires;
-    int num_wires;
+    struct Wire *net_next; // Next wire of the same net (circular, itself when alone)
 
-    // external connections
-    struct Wire **inputs;
-    int num_inputs;
-
-    struct Wire **outputs;
-    int num_outputs;
+    uint32_t state_slot; // Entry in the net state table
 };
 
 struct Lamp
@@ -89,7 +130,158 @@ struct Lamp
     SignalState state;
 };
 
+// Work queue for the event-driven simulator.
+// Gates are linked intrusively through Gate.queue_next, so scheduling never allocates.
+// The queue keeps one FIFO per rank and always pops the lowest rank first, so with a
+// valid levelization every gate of an acyclic cone is evaluated at most once.
+struct SimQueue
+{
+    struct Gate **bucket_head; // Per-rank FIFO heads
+    struct Gate **bucket_tail;
+    int bucket_count;          // Number of ranks; 0 until the first gate is scheduled
+    int cursor;                // Lowest rank that may still hold events
+    size_t evaluations;        // Total number of update_gate calls made by sim_run
+};
+
+// Topological order of a gate set. Feedback loops (strongly connected components)
+// are collapsed into a single rank and flagged cyclic; everything else is settled
+// by evaluating the gates once in order.
+struct Levelization
+{
+    struct Gate **order;        // Gates sorted by rank
+    size_t *order_source;       // Index of each order entry in the array passed to levelize_gates
+    size_t count;
+    size_t *level_start;        // Index into order where each rank begins (depth + 1 entries)
+    unsigned char *level_cyclic; // Non-zero for ranks containing feedback loops
+    int depth;                  // Number of ranks, i.e. the combinational depth
+    size_t cyclic_count;        // Number of gates inside feedback loops
+    int valid;                  // Cleared by the owner whenever wiring changes
+};
+
+// Output of one gate type for the given input states (unconnected inputs read LOW),
+// one table lookup. UNKNOWN propagates unless the other input decides the output
+// (LOW into AND, HIGH into OR); HIGH_Z inputs read as UNKNOWN. Storage types return
+// what they would store (input1); see gate_next_state.
+SignalState gate_evaluate(GateType type, SignalState in_a, SignalState in_b);
+
+// Next output of a gate whose output net currently holds out: CLOCK and DFF keep it,
+// a LATCH follows in_a while in_b is HIGH (and keeps out on UNKNOWN only if in_a
+// agrees), every other type is gate_evaluate
+SignalState gate_next_state(GateType type, SignalState in_a, SignalState in_b, SignalState out);
+
+// Value of a net driven with a and b (see struct Wire), one table lookup
+SignalState signal_resolve(SignalState a, SignalState b);
+
+// Non-zero for CLOCK and DFF. Their outputs change only on clock edges, so settling
+// leaves them alone and levelization treats them as sources: they break feedback loops.
+int gate_is_clocked(GateType type);
 void update_gate(struct Gate *gate);
 void print_status(const char *wire_name, struct Wire *wire);
 
+// Wire lifetime. wire_destroy releases the fanout list as well; gates still
+// reading the wire must be detached first, and no other wire of the net may
+// still use it as parent (see wire_reset).
+struct Wire *wire_create(SignalState state);
+void wire_destroy(struct Wire *wire);
+
+// The same for wires in storage the caller owns (see pool.h): wire_init makes a
+// single-wire net (returns 0 if the state table cannot grow), wire_release frees
+// the fanout list and the state entry
+int wire_init(struct Wire *wire, SignalState state);
+void wire_release(struct Wire *wire);
+
+// State of the net whose root is wire (wire_find first; on any other wire it is a
+// leftover from before the wire was merged)
+SignalState wire_state(const struct Wire *wire);
+void wire_set_state(struct Wire *wire, SignalState state);
+
+// Bytes held by the net state table
+size_t wire_state_bytes(void);
+
+// Unconnected gate of the given type with cleared simulation bookkeeping; it drives
+// HIGH_Z until it is first evaluated
+void gate_init(struct Gate *gate, GateType type);
+
+// Put value on the gate's output net and resolve the net. Returns the net's new state
+// (UNKNOWN if the gate has no output).
+SignalState gate_drive(struct Gate *gate, SignalState value);
+
+// Move the gate's output to a wire (or NULL), taking its drive off the old net and
+// resolving both. A gate that never drove may have Gate.output assigned directly.
+void gate_set_output(struct Gate *gate, struct Wire *wire);
+
+// Count the gate's drive on the net its output currently belongs to again, after
+// the net was split (see wire_reset), and resolve that net
+void gate_relink_output(struct Gate *gate);
+
+// Non-zero if the net whose root is wire has both LOW and HIGH drivers
+int wire_contended(const struct Wire *wire);
+
+// Non-zero if a gate drives the net whose root is wire with anything but HIGH_Z
+int wire_driven(const struct Wire *wire);
+
+// Nets in contention right now
+size_t wire_contention_count(void);
+
+// Root wire of the net containing wire (NULL for NULL)
+struct Wire *wire_find(struct Wire *wire);
+
+// Merge the nets of a and b in near-constant time and return the new root.
+// Fanout lists and drivers are combined. The merged state is the resolution of the
+// drivers, or of the two states if neither net had one (signal_resolve).
+struct Wire *wire_union(struct Wire *a, struct Wire *b);
+
+// Turn a wire back into a single-wire net with an empty fanout and no drivers,
+// keeping its state. Collect the wires of the old net (net_next) before resetting any. Used when a net is split: reset every wire of the old net,
+// re-union the parts that are still connected, then gate_relink_inputs every gate
+// that read the net and gate_relink_output every gate that drove it.
+void wire_reset(struct Wire *wire);
+
+// Connect input pin 0 (input1) or 1 (input2) of a gate to a wire (or NULL),
+// keeping the fanout lists of the old and new wire in sync.
+void gate_set_input(struct Gate *gate, int input_index, struct Wire *wire);
+
+// Disconnect both inputs of a gate (used before the gate is freed)
+void gate_detach_inputs(struct Gate *gate);
+
+// Re-register a gate in the fanout of the nets its inputs currently belong to
+void gate_relink_inputs(struct Gate *gate);
+
+// Event-driven simulation
+void sim_queue_init(struct SimQueue *queue);
+void sim_queue_free(struct SimQueue *queue);
+void sim_queue_clear(struct SimQueue *queue);
+
+// Resize the rank buckets to match a levelization depth (drops pending events)
+void sim_queue_set_levels(struct SimQueue *queue, int depth);
+void sim_schedule_gate(struct SimQueue *queue, struct Gate *gate);
+void sim_schedule_fanout(struct SimQueue *queue, struct Wire *wire);
+
+// Evaluate queued gates until the queue drains or max_evaluations is reached
+// (oscillating feedback loops never drain). Every gate whose output changes
+// schedules its fanout. Returns the number of gates evaluated by this call.
+size_t sim_run(struct SimQueue *queue, size_t max_evaluations);
+
+// Clocked simulation on gate objects. Drives the output nets of all CLOCK gates to level
+// and propagates, then every DFF that saw a rising edge on input2 takes input1 (all of
+// them at once, with the values from before the edge) and the changes propagate. That
+// repeats while flip-flops change, so flip-flops clocked by other flip-flops (ripple
+// counters) follow within the same call. Returns the number of gates evaluated.
+size_t sim_clock_edge(struct SimQueue *queue, struct Gate *const *gates, size_t count, SignalState level,
+                      size_t max_evaluations);
+
+// Take the current clock input of every DFF as the reference for the next edge, so
+// no flip-flop fires on a level it already had (call on a settled circuit, e.g.
+// after loading it or changing its wiring)
+void sim_clock_reset(struct Gate *const *gates, size_t count);
+
+// Levelization: compute Gate.rank/Gate.cyclic for every gate and cache the order.
+// Returns 0 on allocation failure (levels->valid stays 0).
+int levelize_gates(struct Levelization *levels, struct Gate *const *gates, size_t count);
+void levelization_free(struct Levelization *levels);
+
+// Settle all gates with one pass in rank order; ranks with feedback loops are
+// iterated until stable or max_loop_iterations is reached. Returns evaluations.
+size_t levelized_settle(const struct Levelization *levels, int max_loop_iterations);
+
 #endif // LOGIC_H
@@ -23,6 +23,10 @@ static UI *ui = NULL;
 static UI *ingame_ui = NULL;
 static InputHandler *input_handler = NULL;
 
+// Quick save/load slot (F5 / F9), relative to the working directory
+#define CIRCUIT_FILE_PATH "circuit.vlg"
+#define WAVEFORM_FILE_PATH "waveform.vcd"
+
 // Function to update button positions based on window size
 static void update_ui_layout(int window_w, int window_h)
 {
@@ -273,6 +277,54 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event)
                 case SDL_SCANCODE_9:
                     editor_set_selected_gate_type(XNOR);
                     break;
+                case SDL_SCANCODE_0:
+                    editor_set_selected_gate_type(CLOCK);
+                    break;
+                case SDL_SCANCODE_F:
+                    // D flip-flop: input 1 = D, input 2 = clock
+                    editor_set_selected_gate_type(DFF);
+                    break;
+                case SDL_SCANCODE_G:
+                    // Gated D latch: input 1 = D, input 2 = enable
+                    editor_set_selected_gate_type(LATCH);
+                    break;
+                case SDL_SCANCODE_B:
+                    // Tri-state buffer: input 1 = data, input 2 = enable
+                    editor_set_selected_gate_type(TRISTATE);
+                    break;
+                case SDL_SCANCODE_C:
+                    editor_clock_step();
+                    break;
+                case SDL_SCANCODE_R:
+                    editor_clock_toggle_running();
+                    break;
+                case SDL_SCANCODE_P:
+                    // Critical path and glitch view
+                    editor_timing_toggle_view();
+                    break;
+                case SDL_SCANCODE_W:
+                    if (editor_waveform_is_recording())
+                    {
+                        editor_waveform_stop();
+                        SDL_Log("Recorded %s", WAVEFORM_FILE_PATH);
+                    }
+                    else if (editor_waveform_start(WAVEFORM_FILE_PATH))
+                        SDL_Log("Recording %s", WAVEFORM_FILE_PATH);
+                    else
+                        SDL_Log("Couldn't record %s", WAVEFORM_FILE_PATH);
+                    break;
+                case SDL_SCANCODE_F5:
+                    if (editor_save(CIRCUIT_FILE_PATH))
+                        SDL_Log("Saved %s", CIRCUIT_FILE_PATH);
+                    else
+                        SDL_Log("Couldn't save %s", CIRCUIT_FILE_PATH);
+                    break;
+                case SDL_SCANCODE_F9:
+                    if (editor_load(CIRCUIT_FILE_PATH))
+                        SDL_Log("Loaded %s", CIRCUIT_FILE_PATH);
+                    else
+                        SDL_Log("Couldn't load %s", CIRCUIT_FILE_PATH);
+                    break;
                 default:
                     break;
                 }
@@ -302,6 +354,7 @@ SDL_AppResult SDL_AppIterate(void *appstate)
 
     case UI_STATE_INGAME:
         // Render the circuit editor/simulation view
+        editor_clock_update();
         editor_render(renderer);
         ui_render(ingame_ui, renderer);
         break;
@@ -328,6 +381,7 @@ void SDL_AppQuit(void *appstate, SDL_AppResult result)
 
     // Editor cleanup
     editor_shutdown();
+    render_text_cache_clear();
 
     if (font)
     {
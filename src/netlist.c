@@ -0,0 +1,888 @@
+#include <stdlib.h>
+#include <string.h>
+#include "netlist.h"
+#include "thread_pool.h"
+
+// Largest input count netlist_truth_table accepts (2^30 patterns)
+#define NETLIST_MAX_TRUTH_TABLE_INPUTS 30
+
+static size_t wire_hash(const struct Wire *wire, size_t mask)
+{
+    uintptr_t key = (uintptr_t)wire;
+    key ^= key >> 17;
+    key *= (uintptr_t)0x9E3779B97F4A7C15ull;
+    key ^= key >> 29;
+    return (size_t)key & mask;
+}
+
+uint32_t netlist_net_of(const struct Netlist *nl, struct Wire *wire)
+{
+    // Nets are keyed by their root wire
+    wire = wire_find(wire);
+    if (!wire || nl->wire_table_size == 0)
+        return NETLIST_NO_NET;
+    size_t mask = nl->wire_table_size - 1;
+    for (size_t slot = wire_hash(wire, mask);; slot = (slot + 1) & mask)
+    {
+        if (nl->wire_keys[slot] == wire)
+            return nl->wire_nets[slot];
+        if (nl->wire_keys[slot] == NULL)
+            return NETLIST_NO_NET;
+    }
+}
+
+// Look up a wire, assigning the next free net index on first sight
+static uint32_t netlist_intern_wire(struct Netlist *nl, struct Wire *wire)
+{
+    wire = wire_find(wire);
+    if (!wire)
+        return NETLIST_NO_NET;
+    size_t mask = nl->wire_table_size - 1;
+    size_t slot = wire_hash(wire, mask);
+    while (nl->wire_keys[slot] != NULL)
+    {
+        if (nl->wire_keys[slot] == wire)
+            return nl->wire_nets[slot];
+        slot = (slot + 1) & mask;
+    }
+    uint32_t net = (uint32_t)nl->net_count++;
+    nl->wire_keys[slot] = wire;
+    nl->wire_nets[slot] = net;
+    nl->net_wire[net] = wire;
+    nl->net_driver[net] = NETLIST_NO_NET;
+    return net;
+}
+
+void netlist_free(struct Netlist *nl)
+{
+    if (nl->borrowed)
+    {
+        memset(nl, 0, sizeof(*nl));
+        return;
+    }
+    free(nl->gate_type);
+    free(nl->gate_in1);
+    free(nl->gate_in2);
+    free(nl->gate_out);
+    free(nl->gate_cyclic);
+    free(nl->gate_source);
+    free(nl->level_start);
+    free(nl->level_cyclic);
+    free(nl->group_start);
+    free(nl->group_type);
+    free(nl->group_contiguous);
+    free(nl->level_group_start);
+    free(nl->net_wire);
+    free(nl->net_driver);
+    free(nl->wire_keys);
+    free(nl->wire_nets);
+    memset(nl, 0, sizeof(*nl));
+}
+
+// Number of distinct GateType values that get their own group
+#define NETLIST_TYPE_SLOTS 16
+
+// A gate of the rank being numbered: its position in the levelized order and its input nets
+struct CompileEntry
+{
+    uint32_t in1;
+    uint32_t in2;
+    uint32_t pos;
+};
+
+static int compare_compile_entries(const void *a, const void *b)
+{
+    const struct CompileEntry *x = a;
+    const struct CompileEntry *y = b;
+    if (x->in1 != y->in1)
+        return (x->in1 > y->in1) - (x->in1 < y->in1);
+    if (x->in2 != y->in2)
+        return (x->in2 > y->in2) - (x->in2 < y->in2);
+    return (x->pos > y->pos) - (x->pos < y->pos); // Keep equal keys in levelized order
+}
+
+int netlist_compile(struct Netlist *nl, struct Gate *const *gates, size_t gate_count,
+                    struct Wire *const *extra_wires, size_t extra_count)
+{
+    memset(nl, 0, sizeof(*nl));
+
+    struct Levelization levels = {0};
+    if (!levelize_gates(&levels, gates, gate_count))
+        return 0;
+
+    // Upper bound on distinct nets: three per gate plus the extra wires
+    size_t max_nets = NETLIST_FIRST_NET + gate_count * 3 + extra_count;
+    size_t table_size = 16;
+    while (table_size < max_nets * 2)
+        table_size <<= 1;
+
+    size_t n = levels.count;
+    size_t depth = (size_t)levels.depth;
+    // At most one group per gate, plus one spare so empty netlists still allocate
+    size_t max_groups = n + 1;
+    struct CompileEntry *entries = malloc((n + 1) * sizeof(struct CompileEntry));
+    nl->gate_type = malloc((n + 1) * sizeof(uint8_t));
+    nl->gate_in1 = malloc((n + 1) * sizeof(uint32_t));
+    nl->gate_in2 = malloc((n + 1) * sizeof(uint32_t));
+    nl->gate_out = malloc((n + 1) * sizeof(uint32_t));
+    nl->gate_cyclic = malloc((n + 1) * sizeof(uint8_t));
+    nl->gate_source = malloc((n + 1) * sizeof(uint32_t));
+    nl->level_start = malloc((depth + 1) * sizeof(size_t));
+    nl->level_cyclic = malloc((depth + 1) * sizeof(uint8_t));
+    nl->group_start = malloc((max_groups + 1) * sizeof(size_t));
+    nl->group_type = malloc(max_groups * sizeof(uint8_t));
+    nl->group_contiguous = malloc(max_groups * sizeof(uint8_t));
+    nl->level_group_start = malloc((depth + 1) * sizeof(size_t));
+    nl->net_wire = malloc(max_nets * sizeof(struct Wire *));
+    nl->net_driver = malloc(max_nets * sizeof(uint32_t));
+    nl->wire_keys = calloc(table_size, sizeof(struct Wire *));
+    nl->wire_nets = malloc(table_size * sizeof(uint32_t));
+    if (!entries || !nl->gate_type || !nl->gate_in1 || !nl->gate_in2 || !nl->gate_out || !nl->gate_cyclic ||
+        !nl->gate_source ||
+        !nl->level_start || !nl->level_cyclic || !nl->group_start || !nl->group_type ||
+        !nl->group_contiguous || !nl->level_group_start || !nl->net_wire || !nl->net_driver ||
+        !nl->wire_keys || !nl->wire_nets)
+    {
+        free(entries);
+        levelization_free(&levels);
+        netlist_free(nl);
+        return 0;
+    }
+    nl->wire_table_size = table_size;
+    nl->net_count = NETLIST_FIRST_NET;
+    nl->net_wire[NETLIST_NET_LOW] = NULL;
+    nl->net_driver[NETLIST_NET_LOW] = NETLIST_NO_NET;
+
+    // Rank by rank: sort the gates by type (counting sort, stable) into groups, then
+    // inside each group by the nets they read, and number the output nets in that
+    // order. Gates reading neighbouring nets end up next to each other and write
+    // neighbouring nets, so every rank walks memory mostly forwards no matter how
+    // the circuit was drawn. Inputs of a feedback rank may come from the rank
+    // itself; those ranks keep their order and intern inputs after the outputs.
+    // Clocked gates sit in rank 0 but read nets of any rank: their inputs are
+    // interned after all ranks.
+    nl->depth = levels.depth;
+    nl->group_count = 0;
+    for (size_t r = 0; r < depth; ++r)
+    {
+        size_t begin = levels.level_start[r];
+        size_t end = levels.level_start[r + 1];
+        size_t type_count[NETLIST_TYPE_SLOTS] = {0};
+        for (size_t i = begin; i < end; ++i)
+            type_count[(unsigned)levels.order[i]->type % NETLIST_TYPE_SLOTS]++;
+
+        size_t type_pos[NETLIST_TYPE_SLOTS];
+        size_t pos = begin;
+        nl->level_group_start[r] = nl->group_count;
+        for (int t = 0; t < NETLIST_TYPE_SLOTS; ++t)
+        {
+            type_pos[t] = pos;
+            if (type_count[t] == 0)
+                continue;
+            nl->group_start[nl->group_count] = pos;
+            nl->group_type[nl->group_count] = (uint8_t)t;
+            nl->group_count++;
+            pos += type_count[t];
+        }
+        for (size_t i = begin; i < end; ++i)
+            entries[type_pos[(unsigned)levels.order[i]->type % NETLIST_TYPE_SLOTS]++].pos = (uint32_t)i;
+
+        if (!levels.level_cyclic[r])
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const struct Gate *gate = levels.order[entries[i].pos];
+                int clocked = gate_is_clocked(gate->type);
+                entries[i].in1 = clocked ? NETLIST_NO_NET : netlist_intern_wire(nl, gate->input1);
+                entries[i].in2 = clocked ? NETLIST_NO_NET : netlist_intern_wire(nl, gate->input2);
+            }
+            for (size_t g = nl->level_group_start[r]; g < nl->group_count; ++g)
+            {
+                size_t group_end = (g + 1 < nl->group_count) ? nl->group_start[g + 1] : end;
+                qsort(entries + nl->group_start[g], group_end - nl->group_start[g], sizeof(struct CompileEntry),
+                      compare_compile_entries);
+            }
+        }
+
+        // Output nets in gate order, so groups write consecutive nets.
+        // Gates without an output wire get a private net nobody reads.
+        for (size_t i = begin; i < end; ++i)
+        {
+            const struct Gate *gate = levels.order[entries[i].pos];
+            uint32_t out = netlist_intern_wire(nl, gate->output);
+            if (out == NETLIST_NO_NET)
+            {
+                out = (uint32_t)nl->net_count++;
+                nl->net_wire[out] = NULL;
+            }
+            nl->gate_out[i] = out;
+            nl->net_driver[out] = (uint32_t)i;
+            nl->gate_type[i] = (uint8_t)gate->type;
+            nl->gate_cyclic[i] = (uint8_t)gate->cyclic;
+            nl->gate_source[i] = (uint32_t)levels.order_source[entries[i].pos];
+        }
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (levels.level_cyclic[r])
+            {
+                const struct Gate *gate = levels.order[entries[i].pos];
+                int clocked = gate_is_clocked(gate->type);
+                entries[i].in1 = clocked ? NETLIST_NO_NET : netlist_intern_wire(nl, gate->input1);
+                entries[i].in2 = clocked ? NETLIST_NO_NET : netlist_intern_wire(nl, gate->input2);
+            }
+            nl->gate_in1[i] = (entries[i].in1 == NETLIST_NO_NET) ? NETLIST_NET_LOW : entries[i].in1;
+            nl->gate_in2[i] = (entries[i].in2 == NETLIST_NO_NET) ? NETLIST_NET_LOW : entries[i].in2;
+        }
+
+        nl->level_start[r] = begin;
+        nl->level_cyclic[r] = levels.level_cyclic[r];
+    }
+    nl->level_start[depth] = n;
+    nl->level_group_start[depth] = nl->group_count;
+    nl->group_start[nl->group_count] = n;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        const struct Gate *gate = levels.order[entries[i].pos];
+        if (!gate_is_clocked(gate->type))
+            continue;
+        uint32_t in1 = netlist_intern_wire(nl, gate->input1);
+        uint32_t in2 = netlist_intern_wire(nl, gate->input2);
+        nl->gate_in1[i] = (in1 == NETLIST_NO_NET) ? NETLIST_NET_LOW : in1;
+        nl->gate_in2[i] = (in2 == NETLIST_NO_NET) ? NETLIST_NET_LOW : in2;
+    }
+
+    for (size_t i = 0; i < extra_count; ++i)
+    {
+        netlist_intern_wire(nl, extra_wires[i]);
+    }
+    nl->gate_count = n;
+
+    // Nets driven by several gates break the one-net-per-gate numbering. Groups
+    // touching such a net are never contiguous, which also keeps them off the
+    // parallel path (two threads could otherwise write the same net).
+    uint8_t *multi_driven = calloc(nl->net_count + 1, 1);
+    if (!multi_driven)
+    {
+        free(entries);
+        levelization_free(&levels);
+        netlist_free(nl);
+        return 0;
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (nl->net_driver[nl->gate_out[i]] != (uint32_t)i)
+            multi_driven[nl->gate_out[i]] = 1;
+    }
+    for (size_t g = 0; g < nl->group_count; ++g)
+    {
+        size_t begin = nl->group_start[g];
+        size_t end = nl->group_start[g + 1];
+        uint8_t contiguous = 1;
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (multi_driven[nl->gate_out[i]] || nl->gate_out[i] != nl->gate_out[begin] + (uint32_t)(i - begin))
+            {
+                contiguous = 0;
+                break;
+            }
+        }
+        nl->group_contiguous[g] = contiguous;
+    }
+    free(multi_driven);
+
+    free(entries);
+    levelization_free(&levels);
+    return 1;
+}
+
+PatternWord update_gate_packed(GateType type, PatternWord in_a, PatternWord in_b)
+{
+    switch (type)
+    {
+    case CONSTANT_LOW:
+        return 0;
+    case CONSTANT_HIGH:
+        return ~(PatternWord)0;
+    case AND:
+        return in_a & in_b;
+    case OR:
+        return in_a | in_b;
+    case INVERT:
+        return ~in_a;
+    case NAND:
+        return ~(in_a & in_b);
+    case NOR:
+        return ~(in_a | in_b);
+    case XOR:
+        return in_a ^ in_b;
+    case XNOR:
+        return ~(in_a ^ in_b);
+    case CLOCK:
+        return 0;
+    default:
+        // Same as update_gate: unknown types buffer input A (as do DFF and LATCH)
+        return in_a;
+    }
+}
+
+PatternWord update_gate_packed_next(GateType type, PatternWord in_a, PatternWord in_b, PatternWord out)
+{
+    if (gate_is_clocked(type))
+        return out;
+    // Two-valued: a disabled tri-state buffer leaves its net alone, like a closed latch
+    if (type == LATCH || type == TRISTATE)
+        return (in_a & in_b) | (out & ~in_b);
+    return update_gate_packed(type, in_a, in_b);
+}
+
+void netlist_load_states(const struct Netlist *nl, PatternWord *net_words)
+{
+    net_words[NETLIST_NET_LOW] = 0;
+    for (size_t net = NETLIST_FIRST_NET; net < nl->net_count; ++net)
+    {
+        const struct Wire *wire = nl->net_wire ? nl->net_wire[net] : NULL;
+        net_words[net] = (wire && wire_state(wire) == HIGH) ? ~(PatternWord)0 : 0;
+    }
+}
+
+// Type-specialised kernels: one loop per gate type keeps the switch out of the
+// per-gate path and lets the compiler keep everything in registers.
+#define NETLIST_GROUP_LOOP(expr)                              \
+    for (size_t i = 0; i < count; ++i)                        \
+    {                                                         \
+        PatternWord a = words[in1[i]];                        \
+        PatternWord b = words[in2[i]];                        \
+        (void)a;                                              \
+        (void)b;                                              \
+        words[out[i]] = (expr);                               \
+    }
+
+static void eval_group_scalar(GateType type, const uint32_t *in1, const uint32_t *in2,
+                              const uint32_t *out, size_t count, PatternWord *words)
+{
+    switch (type)
+    {
+    case CONSTANT_LOW:
+        NETLIST_GROUP_LOOP((PatternWord)0);
+        break;
+    case CONSTANT_HIGH:
+        NETLIST_GROUP_LOOP(~(PatternWord)0);
+        break;
+    case AND:
+        NETLIST_GROUP_LOOP(a & b);
+        break;
+    case OR:
+        NETLIST_GROUP_LOOP(a | b);
+        break;
+    case INVERT:
+        NETLIST_GROUP_LOOP(~a);
+        break;
+    case NAND:
+        NETLIST_GROUP_LOOP(~(a & b));
+        break;
+    case NOR:
+        NETLIST_GROUP_LOOP(~(a | b));
+        break;
+    case XOR:
+        NETLIST_GROUP_LOOP(a ^ b);
+        break;
+    case XNOR:
+        NETLIST_GROUP_LOOP(~(a ^ b));
+        break;
+    case CLOCK:
+    case DFF:
+        break; // Only netlist_clock_edge writes their nets
+    case LATCH:
+    case TRISTATE:
+        NETLIST_GROUP_LOOP((a & b) | (words[out[i]] & ~b));
+        break;
+    default:
+        NETLIST_GROUP_LOOP(update_gate_packed(type, a, b));
+        break;
+    }
+}
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NETLIST_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define NETLIST_TARGET_AVX2
+#else
+#define NETLIST_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#ifdef NETLIST_X86
+// AVX2: gather four input words per operand, combine them with one vector op and
+// store four results. Contiguous groups store straight into the net array.
+NETLIST_TARGET_AVX2
+static void eval_group_avx2(GateType type, const uint32_t *in1, const uint32_t *in2,
+                            const uint32_t *out, size_t count, int contiguous, PatternWord *words)
+{
+    if (type == CLOCK || type == DFF || type == LATCH || type == TRISTATE)
+    {
+        // Storage elements read (or keep) their own output
+        eval_group_scalar(type, in1, in2, out, count, words);
+        return;
+    }
+    const long long *base = (const long long *)words;
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256i a = _mm256_i32gather_epi64(base, _mm_loadu_si128((const __m128i *)(in1 + i)), 8);
+        __m256i b = _mm256_i32gather_epi64(base, _mm_loadu_si128((const __m128i *)(in2 + i)), 8);
+        __m256i r;
+        switch (type)
+        {
+        case CONSTANT_LOW:
+            r = _mm256_setzero_si256();
+            break;
+        case CONSTANT_HIGH:
+            r = ones;
+            break;
+        case AND:
+            r = _mm256_and_si256(a, b);
+            break;
+        case OR:
+            r = _mm256_or_si256(a, b);
+            break;
+        case INVERT:
+            r = _mm256_xor_si256(a, ones);
+            break;
+        case NAND:
+            r = _mm256_xor_si256(_mm256_and_si256(a, b), ones);
+            break;
+        case NOR:
+            r = _mm256_xor_si256(_mm256_or_si256(a, b), ones);
+            break;
+        case XOR:
+            r = _mm256_xor_si256(a, b);
+            break;
+        case XNOR:
+            r = _mm256_xor_si256(_mm256_xor_si256(a, b), ones);
+            break;
+        default:
+            r = a;
+            break;
+        }
+        if (contiguous)
+        {
+            _mm256_storeu_si256((__m256i *)(words + out[i]), r);
+        }
+        else
+        {
+            // AVX2 has no scatter
+            PatternWord lanes[4];
+            _mm256_storeu_si256((__m256i *)lanes, r);
+            words[out[i]] = lanes[0];
+            words[out[i + 1]] = lanes[1];
+            words[out[i + 2]] = lanes[2];
+            words[out[i + 3]] = lanes[3];
+        }
+    }
+    if (i < count)
+        eval_group_scalar(type, in1 + i, in2 + i, out + i, count - i, words);
+}
+
+static int netlist_cpu_has_avx2(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7)
+        return 0;
+    __cpuid(regs, 1);
+    // OSXSAVE and AVX, then make sure the OS saves the YMM state
+    if ((regs[2] & (1 << 27)) == 0 || (regs[2] & (1 << 28)) == 0)
+        return 0;
+    if ((_xgetbv(0) & 0x6) != 0x6)
+        return 0;
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+}
+#endif
+
+// -1 = not detected yet
+static int netlist_simd_detected = -1;
+static NetlistSimd netlist_simd_active = NETLIST_SIMD_SCALAR;
+
+NetlistSimd netlist_simd_supported(void)
+{
+    if (netlist_simd_detected < 0)
+    {
+#ifdef NETLIST_X86
+        netlist_simd_detected = netlist_cpu_has_avx2() ? NETLIST_SIMD_AVX2 : NETLIST_SIMD_SCALAR;
+#else
+        netlist_simd_detected = NETLIST_SIMD_SCALAR;
+#endif
+        netlist_simd_active = (NetlistSimd)netlist_simd_detected;
+    }
+    return (NetlistSimd)netlist_simd_detected;
+}
+
+NetlistSimd netlist_get_simd(void)
+{
+    netlist_simd_supported();
+    return netlist_simd_active;
+}
+
+void netlist_set_simd(NetlistSimd simd)
+{
+    NetlistSimd supported = netlist_simd_supported();
+    netlist_simd_active = (simd > supported) ? supported : simd;
+}
+
+// Evaluate gates [begin, end) of one acyclic group with the active kernel
+static void netlist_eval_group_range(const struct Netlist *nl, size_t group, size_t begin, size_t end,
+                                     NetlistSimd simd, PatternWord *words)
+{
+    size_t count = end - begin;
+    GateType type = (GateType)nl->group_type[group];
+#ifdef NETLIST_X86
+    if (simd == NETLIST_SIMD_AVX2)
+    {
+        eval_group_avx2(type, nl->gate_in1 + begin, nl->gate_in2 + begin, nl->gate_out + begin,
+                        count, nl->group_contiguous[group], words);
+        return;
+    }
+#else
+    (void)simd;
+#endif
+    eval_group_scalar(type, nl->gate_in1 + begin, nl->gate_in2 + begin, nl->gate_out + begin, count, words);
+}
+
+// Rank with feedback loops: one ordered pass, then iterate the loop gates until stable
+static size_t netlist_eval_cyclic_level(const struct Netlist *nl, int r, PatternWord *net_words, int max_loop_iterations)
+{
+    size_t begin = nl->level_start[r];
+    size_t end = nl->level_start[r + 1];
+    size_t evaluated = end - begin;
+    for (size_t i = begin; i < end; ++i)
+    {
+        net_words[nl->gate_out[i]] = update_gate_packed_next((GateType)nl->gate_type[i],
+                                                             net_words[nl->gate_in1[i]],
+                                                             net_words[nl->gate_in2[i]],
+                                                             net_words[nl->gate_out[i]]);
+    }
+    for (int iter = 1; iter < max_loop_iterations; ++iter)
+    {
+        int changed = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (!nl->gate_cyclic[i])
+                continue;
+            PatternWord result = update_gate_packed_next((GateType)nl->gate_type[i],
+                                                         net_words[nl->gate_in1[i]],
+                                                         net_words[nl->gate_in2[i]],
+                                                         net_words[nl->gate_out[i]]);
+            evaluated++;
+            if (net_words[nl->gate_out[i]] != result)
+            {
+                net_words[nl->gate_out[i]] = result;
+                changed = 1;
+            }
+        }
+        if (!changed)
+            break;
+    }
+    return evaluated;
+}
+
+size_t netlist_eval_packed(const struct Netlist *nl, PatternWord *net_words, int max_loop_iterations)
+{
+    NetlistSimd simd = netlist_get_simd();
+    size_t evaluated = 0;
+    for (int r = 0; r < nl->depth; ++r)
+    {
+        if (nl->level_cyclic[r])
+        {
+            evaluated += netlist_eval_cyclic_level(nl, r, net_words, max_loop_iterations);
+            continue;
+        }
+        // Gates of one acyclic rank never read each other's outputs
+        for (size_t g = nl->level_group_start[r]; g < nl->level_group_start[r + 1]; ++g)
+            netlist_eval_group_range(nl, g, nl->group_start[g], nl->group_start[g + 1], simd, net_words);
+        evaluated += nl->level_start[r + 1] - nl->level_start[r];
+    }
+    return evaluated;
+}
+
+struct NetlistLevelJob
+{
+    const struct Netlist *nl;
+    PatternWord *words;
+    NetlistSimd simd;
+    int level;
+};
+
+// Thread pool task: gates [begin, end) relative to the start of the job's rank
+static void netlist_level_task(void *ctx, size_t begin, size_t end)
+{
+    const struct NetlistLevelJob *job = ctx;
+    const struct Netlist *nl = job->nl;
+    size_t first = nl->level_start[job->level] + begin;
+    size_t last = nl->level_start[job->level] + end;
+
+    // Binary search for the group containing the first gate
+    size_t lo = nl->level_group_start[job->level];
+    size_t hi = nl->level_group_start[job->level + 1];
+    while (hi - lo > 1)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (nl->group_start[mid] <= first)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    for (size_t g = lo; first < last; ++g)
+    {
+        size_t group_end = nl->group_start[g + 1] < last ? nl->group_start[g + 1] : last;
+        netlist_eval_group_range(nl, g, first, group_end, job->simd, job->words);
+        first = group_end;
+    }
+}
+
+static int netlist_level_parallel_safe(const struct Netlist *nl, int r)
+{
+    for (size_t g = nl->level_group_start[r]; g < nl->level_group_start[r + 1]; ++g)
+    {
+        if (!nl->group_contiguous[g])
+            return 0;
+    }
+    return 1;
+}
+
+size_t netlist_eval_parallel(const struct Netlist *nl, PatternWord *net_words, int max_loop_iterations,
+                             struct ThreadPool *pool, size_t min_parallel_gates)
+{
+    if (thread_pool_size(pool) <= 1)
+        return netlist_eval_packed(nl, net_words, max_loop_iterations);
+
+    struct NetlistLevelJob job;
+    job.nl = nl;
+    job.words = net_words;
+    job.simd = netlist_get_simd();
+
+    size_t evaluated = 0;
+    size_t chunk = NETLIST_PARALLEL_CHUNK;
+    for (int r = 0; r < nl->depth; ++r)
+    {
+        size_t level_gates = nl->level_start[r + 1] - nl->level_start[r];
+        if (nl->level_cyclic[r])
+        {
+            evaluated += netlist_eval_cyclic_level(nl, r, net_words, max_loop_iterations);
+            continue;
+        }
+        job.level = r;
+        if (level_gates < min_parallel_gates || !netlist_level_parallel_safe(nl, r))
+        {
+            // Too small to pay for the wake-up, or nets shared between gates
+            netlist_level_task(&job, 0, level_gates);
+        }
+        else
+        {
+            // parallel_for returns when the whole rank is done: the per-level barrier
+            thread_pool_parallel_for(pool, level_gates, chunk, netlist_level_task, &job);
+        }
+        evaluated += level_gates;
+    }
+    return evaluated;
+}
+
+int netlist_clock_init(struct NetlistClock *clock, const struct Netlist *nl, const PatternWord *net_words)
+{
+    memset(clock, 0, sizeof(*clock));
+    size_t clocks = 0, dffs = 0;
+    for (size_t i = 0; i < nl->gate_count; ++i)
+    {
+        clocks += nl->gate_type[i] == CLOCK;
+        dffs += nl->gate_type[i] == DFF;
+    }
+    clock->clock_nets = malloc((clocks + 1) * sizeof(uint32_t));
+    clock->dff_gates = malloc((dffs + 1) * sizeof(uint32_t));
+    clock->dff_clock = malloc((dffs + 1) * sizeof(PatternWord));
+    clock->dff_next = malloc((dffs + 1) * sizeof(PatternWord));
+    uint8_t *is_clock = calloc(nl->net_count + 1, 1);
+    if (!clock->clock_nets || !clock->dff_gates || !clock->dff_clock || !clock->dff_next || !is_clock)
+    {
+        free(is_clock);
+        netlist_clock_free(clock);
+        return 0;
+    }
+    for (size_t i = 0; i < nl->gate_count; ++i)
+    {
+        if (nl->gate_type[i] == CLOCK)
+        {
+            clock->clock_nets[clock->clock_count++] = nl->gate_out[i];
+            is_clock[nl->gate_out[i]] = 1;
+        }
+        else if (nl->gate_type[i] == DFF)
+        {
+            clock->dff_clock[clock->dff_count] = net_words[nl->gate_in2[i]];
+            clock->dff_gates[clock->dff_count++] = (uint32_t)i;
+        }
+    }
+    // Clocks that only reach flip-flop clock pins need no settle before the edge check
+    for (size_t i = 0; i < nl->gate_count; ++i)
+    {
+        if (!gate_is_clocked((GateType)nl->gate_type[i]) && (is_clock[nl->gate_in1[i]] || is_clock[nl->gate_in2[i]]))
+            clock->clock_feeds_logic = 1;
+    }
+    clock->level = (clocks > 0 && (net_words[clock->clock_nets[0]] & 1)) ? 1 : 0;
+    free(is_clock);
+    return 1;
+}
+
+void netlist_clock_free(struct NetlistClock *clock)
+{
+    free(clock->clock_nets);
+    free(clock->dff_gates);
+    free(clock->dff_clock);
+    free(clock->dff_next);
+    memset(clock, 0, sizeof(*clock));
+}
+
+static size_t netlist_clock_settle(const struct NetlistClock *clock, const struct Netlist *nl,
+                                   PatternWord *net_words, int max_loop_iterations)
+{
+    if (clock->settle)
+        return clock->settle(clock->settle_context, nl, net_words, max_loop_iterations);
+    return netlist_eval_packed(nl, net_words, max_loop_iterations);
+}
+
+size_t netlist_clock_edge(struct NetlistClock *clock, const struct Netlist *nl, PatternWord *net_words,
+                          int level, int max_loop_iterations)
+{
+    PatternWord value = level ? ~(PatternWord)0 : 0;
+    int changed = 0;
+    for (size_t k = 0; k < clock->clock_count; ++k)
+    {
+        changed |= net_words[clock->clock_nets[k]] != value;
+        net_words[clock->clock_nets[k]] = value;
+    }
+    clock->level = level ? 1 : 0;
+
+    size_t evaluated = 0;
+    if (changed && clock->clock_feeds_logic)
+        evaluated += netlist_clock_settle(clock, nl, net_words, max_loop_iterations);
+    for (int round = 0; round < max_loop_iterations; ++round)
+    {
+        // Sample every flip-flop before any of them changes
+        PatternWord any = 0;
+        for (size_t k = 0; k < clock->dff_count; ++k)
+        {
+            uint32_t g = clock->dff_gates[k];
+            PatternWord clk = net_words[nl->gate_in2[g]];
+            PatternWord rising = clk & ~clock->dff_clock[k];
+            PatternWord q = net_words[nl->gate_out[g]];
+            clock->dff_clock[k] = clk;
+            clock->dff_next[k] = (q & ~rising) | (net_words[nl->gate_in1[g]] & rising);
+            any |= clock->dff_next[k] ^ q;
+        }
+        if (!any)
+            break;
+        for (size_t k = 0; k < clock->dff_count; ++k)
+            net_words[nl->gate_out[clock->dff_gates[k]]] = clock->dff_next[k];
+        evaluated += netlist_clock_settle(clock, nl, net_words, max_loop_iterations);
+    }
+    clock->evaluations += evaluated;
+    return evaluated;
+}
+
+size_t netlist_clock_cycles(struct NetlistClock *clock, const struct Netlist *nl, PatternWord *net_words,
+                            uint64_t cycles, int max_loop_iterations)
+{
+    size_t evaluated = 0;
+    for (uint64_t c = 0; c < cycles; ++c)
+    {
+        evaluated += netlist_clock_edge(clock, nl, net_words, 1, max_loop_iterations);
+        evaluated += netlist_clock_edge(clock, nl, net_words, 0, max_loop_iterations);
+        clock->cycles++;
+    }
+    return evaluated;
+}
+
+int netlist_simulate_patterns(const struct Netlist *nl,
+                              const uint32_t *input_nets, size_t input_count, const PatternWord *input_words,
+                              const uint32_t *output_nets, size_t output_count, PatternWord *output_words,
+                              size_t word_count)
+{
+    PatternWord *base = malloc((nl->net_count + 1) * sizeof(PatternWord));
+    PatternWord *words = malloc((nl->net_count + 1) * sizeof(PatternWord));
+    if (!base || !words)
+    {
+        free(base);
+        free(words);
+        return 0;
+    }
+    netlist_load_states(nl, base);
+
+    for (size_t w = 0; w < word_count; ++w)
+    {
+        memcpy(words, base, nl->net_count * sizeof(PatternWord));
+        for (size_t i = 0; i < input_count; ++i)
+        {
+            if (input_nets[i] >= NETLIST_FIRST_NET && input_nets[i] < nl->net_count)
+                words[input_nets[i]] = input_words[w * input_count + i];
+        }
+        netlist_eval_packed(nl, words, NETLIST_PATTERNS_PER_WORD);
+        for (size_t j = 0; j < output_count; ++j)
+        {
+            uint32_t net = output_nets[j];
+            output_words[w * output_count + j] = (net < nl->net_count) ? words[net] : 0;
+        }
+    }
+
+    free(base);
+    free(words);
+    return 1;
+}
+
+size_t netlist_truth_table_words(size_t input_count)
+{
+    if (input_count <= 6)
+        return 1;
+    return (size_t)1 << (input_count - 6);
+}
+
+int netlist_truth_table(const struct Netlist *nl,
+                        const uint32_t *input_nets, size_t input_count,
+                        const uint32_t *output_nets, size_t output_count, PatternWord *output_words)
+{
+    // Bit k of these words is bit i of k: the first six inputs count inside a word
+    static const PatternWord lane_patterns[6] = {
+        0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+        0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull};
+
+    if (input_count > NETLIST_MAX_TRUTH_TABLE_INPUTS)
+        return 0;
+    size_t word_count = netlist_truth_table_words(input_count);
+    PatternWord *input_words = malloc((word_count * input_count + 1) * sizeof(PatternWord));
+    if (!input_words)
+        return 0;
+
+    for (size_t w = 0; w < word_count; ++w)
+    {
+        for (size_t i = 0; i < input_count; ++i)
+        {
+            PatternWord value;
+            if (i < 6)
+                value = lane_patterns[i];
+            else
+                value = ((w >> (i - 6)) & 1u) ? ~(PatternWord)0 : 0;
+            input_words[w * input_count + i] = value;
+        }
+    }
+
+    int ok = netlist_simulate_patterns(nl, input_nets, input_count, input_words,
+                                       output_nets, output_count, output_words, word_count);
+    free(input_words);
+    return ok;
+}
@@ -0,0 +1,169 @@
+#ifndef NETLIST_H
+#define NETLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "logic.h"
+
+// Compiled, index-based form of a gate set for batch simulation.
+// Every net carries a PatternWord: bit k holds the net's value for input vector k,
+// so one pass over the gates simulates 64 input vectors at once. The packed form is
+// two-valued: UNKNOWN and HIGH_Z are simulated as LOW, and a disabled tri-state
+// buffer leaves its net as it is. Four-valued simulation is update_gate's.
+typedef uint64_t PatternWord;
+
+// Instruction set used by netlist_eval_packed, detected once at runtime (CPUID)
+typedef enum
+{
+    NETLIST_SIMD_SCALAR = 0,
+    NETLIST_SIMD_AVX2 = 1
+} NetlistSimd;
+
+#define NETLIST_PATTERNS_PER_WORD 64
+// Gates per thread pool task in netlist_eval_parallel
+#define NETLIST_PARALLEL_CHUNK 2048
+// Default for min_parallel_gates: smaller ranks are evaluated on the calling thread
+#define NETLIST_PARALLEL_MIN_GATES 8192
+#define NETLIST_NO_NET UINT32_MAX
+#define NETLIST_NET_LOW 0 // Always LOW, read by unconnected inputs
+#define NETLIST_FIRST_NET 1
+
+// Structure-of-arrays layout: gates are sorted by rank and, inside a rank, by type.
+// A run of same-type gates in one rank forms a group that is evaluated by a single
+// type-specialised (SIMD) kernel. Inside a group gates are ordered by the nets they
+// read, and each gate's output net is numbered after its position, so most groups
+// write a contiguous block of nets and fanout neighbours sit next to each other.
+struct Netlist
+{
+    // Gates in topological (rank, type) order
+    size_t gate_count;
+    uint8_t *gate_type; // GateType
+    uint32_t *gate_in1; // Net index, NETLIST_NET_LOW when unconnected
+    uint32_t *gate_in2;
+    uint32_t *gate_out; // Net index; gates without an output wire get a private net
+    uint8_t *gate_cyclic; // Non-zero for gates inside feedback loops
+    uint32_t *gate_source; // Index of each gate in the array given to netlist_compile (NULL when borrowed)
+
+    // Ranks: gates [level_start[r], level_start[r + 1]) share rank r
+    int depth;
+    size_t *level_start;
+    uint8_t *level_cyclic;
+
+    // Groups: gates [group_start[g], group_start[g + 1]) share rank and type;
+    // groups [level_group_start[r], level_group_start[r + 1]) belong to rank r
+    size_t group_count;
+    size_t *group_start;
+    uint8_t *group_type;
+    uint8_t *group_contiguous; // Output nets are gate_out[begin] + 0, 1, 2, ...
+    size_t *level_group_start;
+
+    // Nets
+    size_t net_count;
+    struct Wire **net_wire;  // Root wire of each net (NULL for reserved and private nets)
+    uint32_t *net_driver;    // Index of the (last) gate driving the net, NETLIST_NO_NET if undriven
+
+    // struct Wire * -> net index lookup (open addressing, power-of-two size)
+    const struct Wire **wire_keys;
+    uint32_t *wire_nets;
+    size_t wire_table_size;
+
+    // Arrays point into memory owned elsewhere (a mapped .vlg file); netlist_free
+    // leaves them alone. Borrowed netlists have no wires (net_wire is NULL).
+    int borrowed;
+};
+
+// Build a netlist from the given gates. Every wire the gates touch becomes a net;
+// extra_wires (may be NULL) adds nets for wires not connected to any gate, e.g. lamp inputs.
+// Returns 0 on allocation failure.
+int netlist_compile(struct Netlist *nl, struct Gate *const *gates, size_t gate_count,
+                    struct Wire *const *extra_wires, size_t extra_count);
+void netlist_free(struct Netlist *nl);
+
+// Net index of a logic wire, NETLIST_NO_NET if the wire is not part of the netlist
+uint32_t netlist_net_of(const struct Netlist *nl, struct Wire *wire);
+
+// Bitwise evaluation of one gate type on 64 patterns
+PatternWord update_gate_packed(GateType type, PatternWord in_a, PatternWord in_b);
+
+// Next value of a gate's output net on 64 patterns (see gate_next_state)
+PatternWord update_gate_packed_next(GateType type, PatternWord in_a, PatternWord in_b, PatternWord out);
+
+// Best instruction set supported by this CPU, and the one currently in use.
+// netlist_set_simd clamps the request to what the CPU supports (e.g. to force scalar).
+NetlistSimd netlist_simd_supported(void);
+NetlistSimd netlist_get_simd(void);
+void netlist_set_simd(NetlistSimd simd);
+
+// Fill net_words from the current logic wire states (HIGH = all ones, anything else zero);
+// nets without a wire start LOW
+void netlist_load_states(const struct Netlist *nl, PatternWord *net_words);
+
+// Evaluate every gate once in rank order; ranks with feedback loops iterate until
+// stable or max_loop_iterations is reached. Returns the number of gate evaluations.
+size_t netlist_eval_packed(const struct Netlist *nl, PatternWord *net_words, int max_loop_iterations);
+
+// Same result as netlist_eval_packed, but every acyclic rank with at least
+// min_parallel_gates gates is split across the thread pool, with a barrier
+// between ranks. Falls back to netlist_eval_packed without a pool.
+struct ThreadPool;
+size_t netlist_eval_parallel(const struct Netlist *nl, PatternWord *net_words, int max_loop_iterations,
+                             struct ThreadPool *pool, size_t min_parallel_gates);
+
+// Simulate word_count * 64 input vectors. For word w, input_words[w * input_count + i]
+// drives input_nets[i] and output_words[w * output_count + j] receives output_nets[j].
+// Nets that are neither inputs nor driven by a gate keep their current wire state.
+// Returns 0 on allocation failure.
+int netlist_simulate_patterns(const struct Netlist *nl,
+                              const uint32_t *input_nets, size_t input_count, const PatternWord *input_words,
+                              const uint32_t *output_nets, size_t output_count, PatternWord *output_words,
+                              size_t word_count);
+
+// Exhaustive truth table: pattern p sets input i to bit i of p. output_words must hold
+// netlist_truth_table_words(input_count) * output_count words, laid out as above.
+size_t netlist_truth_table_words(size_t input_count);
+int netlist_truth_table(const struct Netlist *nl,
+                        const uint32_t *input_nets, size_t input_count,
+                        const uint32_t *output_nets, size_t output_count, PatternWord *output_words);
+
+// Settles the logic between clock edges. The default is netlist_eval_packed; tools
+// plug in the thread pool or a compiled evaluator here.
+typedef size_t (*NetlistSettleFn)(void *context, const struct Netlist *nl, PatternWord *net_words,
+                                  int max_loop_iterations);
+
+// Clocked simulation. CLOCK gates are the clock sources (all in phase); DFF gates take
+// input1 on a rising edge of input2. Settling never writes their nets, so between
+// edges the netlist is purely combinational.
+struct NetlistClock
+{
+    uint32_t *clock_nets;   // Output net of every CLOCK gate
+    size_t clock_count;
+    uint32_t *dff_gates;    // Every DFF gate
+    size_t dff_count;
+    PatternWord *dff_clock; // Clock input of each flip-flop when edges were last checked
+    PatternWord *dff_next;  // Value each flip-flop takes in the current edge round
+    int clock_feeds_logic;  // Some gate other than a flip-flop clock pin reads a clock net
+    int level;              // Current level of the clock sources
+    uint64_t cycles;        // Full cycles run by netlist_clock_cycles
+    size_t evaluations;     // Gate evaluations spent on edges so far
+    NetlistSettleFn settle; // NULL = netlist_eval_packed
+    void *settle_context;
+};
+
+// Find the clocks and flip-flops of nl. net_words must be settled; the clock inputs
+// found there are the reference for the first edge. Returns 0 on allocation failure.
+int netlist_clock_init(struct NetlistClock *clock, const struct Netlist *nl, const PatternWord *net_words);
+void netlist_clock_free(struct NetlistClock *clock);
+
+// Drive every clock source to level (0 or 1) and settle. Flip-flops that see a rising
+// edge take their D input, all at once with the values from before the edge, and the
+// logic settles again; that repeats (at most max_loop_iterations rounds) while
+// flip-flops change, so flip-flops clocked by other flip-flops follow. Inputs changed
+// since the last call must be settled first. Returns the number of gate evaluations.
+size_t netlist_clock_edge(struct NetlistClock *clock, const struct Netlist *nl, PatternWord *net_words,
+                          int level, int max_loop_iterations);
+
+// Full clock cycles (rising then falling edge). Returns the number of gate evaluations.
+size_t netlist_clock_cycles(struct NetlistClock *clock, const struct Netlist *nl, PatternWord *net_words,
+                            uint64_t cycles, int max_loop_iterations);
+
+#endif // NETLIST_H
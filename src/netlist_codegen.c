@@ -0,0 +1,270 @@
+#include <stdlib.h>
+#include <string.h>
+#include "netlist_codegen.h"
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#include <unistd.h>
+#endif
+
+// Gates per generated function. The compiler's optimizer gets slow on long runs of
+// stores to one array; small functions keep compile time linear in the gate count
+// (and run faster too).
+#define CODEGEN_PART_GATES 64
+#define CODEGEN_ENTRY "netlist_compiled_eval"
+
+// q is the gate's own output net (read by latches)
+static void write_expression(FILE *out, GateType type, uint32_t a, uint32_t b, uint32_t q)
+{
+    switch (type)
+    {
+    case CONSTANT_LOW:
+        fputs("0", out);
+        break;
+    case CONSTANT_HIGH:
+        fputs("~(W)0", out);
+        break;
+    case AND:
+        fprintf(out, "w[%u] & w[%u]", a, b);
+        break;
+    case OR:
+        fprintf(out, "w[%u] | w[%u]", a, b);
+        break;
+    case INVERT:
+        fprintf(out, "~w[%u]", a);
+        break;
+    case NAND:
+        fprintf(out, "~(w[%u] & w[%u])", a, b);
+        break;
+    case NOR:
+        fprintf(out, "~(w[%u] | w[%u])", a, b);
+        break;
+    case XOR:
+        fprintf(out, "w[%u] ^ w[%u]", a, b);
+        break;
+    case XNOR:
+        fprintf(out, "~(w[%u] ^ w[%u])", a, b);
+        break;
+    case LATCH:
+    case TRISTATE:
+        fprintf(out, "(w[%u] & w[%u]) | (w[%u] & ~w[%u])", a, b, q, b);
+        break;
+    default:
+        // Same as update_gate_packed: unknown types buffer input A
+        fprintf(out, "w[%u]", a);
+        break;
+    }
+}
+
+static void write_gate(FILE *out, const struct Netlist *nl, size_t i)
+{
+    if (gate_is_clocked((GateType)nl->gate_type[i]))
+        return; // Written by netlist_clock_edge only
+    fprintf(out, "    w[%u] = ", nl->gate_out[i]);
+    write_expression(out, (GateType)nl->gate_type[i], nl->gate_in1[i], nl->gate_in2[i], nl->gate_out[i]);
+    fputs(";\n", out);
+}
+
+// A rank with feedback loops: one full pass, then the loop gates until nothing
+// changes, exactly like the interpreter (so the evaluation counts match too).
+// Both are split into functions of CODEGEN_PART_GATES gates.
+static void write_cyclic_rank(FILE *out, const struct Netlist *nl, int r, size_t step)
+{
+    size_t begin = nl->level_start[r];
+    size_t end = nl->level_start[r + 1];
+    size_t pass_parts = 0, loop_parts = 0, part_gates = 0, loop_gates = 0;
+    for (size_t i = begin; i < end; ++i)
+    {
+        if (part_gates == 0)
+            fprintf(out, "PART void step_%zu_pass_%zu(W *restrict w)\n{\n", step, pass_parts++);
+        write_gate(out, nl, i);
+        if (++part_gates == CODEGEN_PART_GATES || i + 1 == end)
+        {
+            fputs("}\n\n", out);
+            part_gates = 0;
+        }
+    }
+    for (size_t i = begin; i < end; ++i)
+    {
+        if (!nl->gate_cyclic[i])
+            continue;
+        if (part_gates == 0)
+            fprintf(out, "PART W step_%zu_loop_%zu(W *restrict w)\n{\n    W v, changed = 0;\n", step, loop_parts++);
+        fputs("    v = ", out);
+        write_expression(out, (GateType)nl->gate_type[i], nl->gate_in1[i], nl->gate_in2[i], nl->gate_out[i]);
+        fprintf(out, ";\n    changed |= v ^ w[%u];\n    w[%u] = v;\n", nl->gate_out[i], nl->gate_out[i]);
+        loop_gates++;
+        if (++part_gates == CODEGEN_PART_GATES)
+        {
+            fputs("    return changed;\n}\n\n", out);
+            part_gates = 0;
+        }
+    }
+    if (part_gates > 0)
+        fputs("    return changed;\n}\n\n", out);
+
+    fprintf(out, "PART size_t step_%zu(W *w, int max_loop_iterations)\n{\n", step);
+    for (size_t p = 0; p < pass_parts; ++p)
+        fprintf(out, "    step_%zu_pass_%zu(w);\n", step, p);
+    fprintf(out, "    size_t evaluated = %zu;\n", end - begin);
+    fputs("    for (int iter = 1; iter < max_loop_iterations; ++iter)\n    {\n        W changed = 0;\n", out);
+    for (size_t p = 0; p < loop_parts; ++p)
+        fprintf(out, "        changed |= step_%zu_loop_%zu(w);\n", step, p);
+    fprintf(out, "        evaluated += %zu;\n        if (!changed)\n            break;\n    }\n", loop_gates);
+    fputs("    return evaluated;\n}\n\n", out);
+}
+
+int netlist_codegen_write(const struct Netlist *nl, FILE *out)
+{
+    // Steps in call order: acyclic parts (0) and feedback ranks (1)
+    size_t max_steps = (size_t)(nl->depth > 0 ? nl->depth : 0) + nl->gate_count / CODEGEN_PART_GATES + 1;
+    uint8_t *step_cyclic = malloc(max_steps);
+    if (!step_cyclic)
+        return 0;
+
+    fprintf(out, "// Generated from a netlist with %zu gates and %zu nets; do not edit.\n"
+                 "#include <stddef.h>\n#include <stdint.h>\n\ntypedef uint64_t W;\n\n"
+                 "// Inlining every part back into one function would undo the split\n"
+                 "#if defined(__GNUC__)\n#define PART static __attribute__((noinline))\n#else\n#define PART static\n#endif\n\n",
+            nl->gate_count, nl->net_count);
+    size_t step_count = 0, part_gates = 0, acyclic_gates = 0;
+    for (int r = 0; r < nl->depth; ++r)
+    {
+        if (nl->level_cyclic[r])
+        {
+            if (part_gates > 0)
+                fputs("}\n\n", out);
+            part_gates = 0;
+            step_cyclic[step_count] = 1;
+            write_cyclic_rank(out, nl, r, step_count++);
+            continue;
+        }
+        for (size_t i = nl->level_start[r]; i < nl->level_start[r + 1]; ++i)
+        {
+            if (part_gates == CODEGEN_PART_GATES)
+            {
+                fputs("}\n\n", out);
+                part_gates = 0;
+            }
+            if (part_gates == 0)
+            {
+                step_cyclic[step_count] = 0;
+                fprintf(out, "PART void step_%zu(W *restrict w)\n{\n", step_count++);
+            }
+            write_gate(out, nl, i);
+            part_gates++;
+            acyclic_gates++;
+        }
+    }
+    if (part_gates > 0)
+        fputs("}\n\n", out);
+
+    fprintf(out, "size_t " CODEGEN_ENTRY "(W *w, int max_loop_iterations)\n{\n"
+                 "    size_t evaluated = %zu;\n    (void)max_loop_iterations;\n",
+            acyclic_gates);
+    for (size_t s = 0; s < step_count; ++s)
+    {
+        if (step_cyclic[s])
+            fprintf(out, "    evaluated += step_%zu(w, max_loop_iterations);\n", s);
+        else
+            fprintf(out, "    step_%zu(w);\n", s);
+    }
+    fputs("    return evaluated;\n}\n", out);
+    free(step_cyclic);
+    return !ferror(out);
+}
+
+#ifdef _WIN32
+
+int netlist_codegen_load(struct NetlistCompiled *compiled, const struct Netlist *nl)
+{
+    // No system compiler to rely on: callers fall back to the interpreter
+    (void)nl;
+    memset(compiled, 0, sizeof(*compiled));
+    return 0;
+}
+
+void netlist_codegen_unload(struct NetlistCompiled *compiled)
+{
+    memset(compiled, 0, sizeof(*compiled));
+}
+
+#else
+
+int netlist_codegen_load(struct NetlistCompiled *compiled, const struct Netlist *nl)
+{
+    memset(compiled, 0, sizeof(*compiled));
+
+    const char *tmp = getenv("TMPDIR");
+    const char *cc = getenv("VLG_CC");
+    const char *cflags = getenv("VLG_CFLAGS");
+    if (!tmp || !*tmp)
+        tmp = "/tmp";
+    if (!cc || !*cc)
+        cc = "cc";
+    if (!cflags)
+        cflags = "-O1";
+    // The paths are pasted into a double-quoted shell command, where these still expand
+    if (strpbrk(tmp, "\"$`\\"))
+        return 0;
+
+    // A private directory (mode 0700) so no other user can swap the source or the
+    // library between our write, the compile and the dlopen
+    char dir[512], source_path[512], library_path[512], command[1536];
+    if (snprintf(dir, sizeof(dir), "%s/vlg_netlist_XXXXXX", tmp) >= (int)sizeof(dir) || !mkdtemp(dir))
+        return 0;
+    int paths_ok = snprintf(source_path, sizeof(source_path), "%s/netlist.c", dir) < (int)sizeof(source_path) &&
+                   snprintf(library_path, sizeof(library_path), "%s/netlist.so", dir) < (int)sizeof(library_path);
+    int ok = paths_ok && snprintf(command, sizeof(command), "%s %s -shared -fPIC -o \"%s\" \"%s\" >/dev/null 2>&1",
+                                  cc, cflags, library_path, source_path) < (int)sizeof(command);
+
+    FILE *f = ok ? fopen(source_path, "w") : NULL;
+    if (f)
+    {
+        ok = netlist_codegen_write(nl, f);
+        ok = (fclose(f) == 0) && ok;
+        ok = ok && system(command) == 0;
+        remove(source_path);
+        if (ok)
+        {
+            compiled->library = dlopen(library_path, RTLD_NOW | RTLD_LOCAL);
+        }
+    }
+    // The mapping stays valid until dlclose. A failed compile may have left a partial
+    // library behind, which would keep rmdir from removing the directory.
+    if (paths_ok)
+        remove(library_path);
+    rmdir(dir);
+    if (!compiled->library)
+        return 0;
+
+    compiled->eval = (NetlistCompiledEval)dlsym(compiled->library, CODEGEN_ENTRY);
+    if (!compiled->eval)
+    {
+        netlist_codegen_unload(compiled);
+        return 0;
+    }
+    compiled->source = nl;
+    compiled->source_gate_out = nl->gate_out;
+    compiled->gate_count = nl->gate_count;
+    compiled->net_count = nl->net_count;
+    return 1;
+}
+
+void netlist_codegen_unload(struct NetlistCompiled *compiled)
+{
+    if (compiled->library)
+        dlclose(compiled->library);
+    memset(compiled, 0, sizeof(*compiled));
+}
+
+#endif
+
+size_t netlist_codegen_eval(const struct NetlistCompiled *compiled, const struct Netlist *nl,
+                            PatternWord *net_words, int max_loop_iterations)
+{
+    if (compiled && compiled->eval && compiled->source == nl && compiled->source_gate_out == nl->gate_out &&
+        compiled->gate_count == nl->gate_count && compiled->net_count == nl->net_count)
+        return compiled->eval(net_words, max_loop_iterations);
+    return netlist_eval_packed(nl, net_words, max_loop_iterations);
+}
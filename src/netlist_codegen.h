@@ -0,0 +1,46 @@
+#ifndef NETLIST_CODEGEN_H
+#define NETLIST_CODEGEN_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "netlist.h"
+
+// Compiled simulation: a netlist is emitted as straight-line C (one bitwise
+// statement per gate on packed words, no type dispatch), built into a shared
+// object by the system compiler and loaded as the evaluator. Worth it for designs
+// that are simulated for many passes without changing; anything else should keep
+// using netlist_eval_packed.
+//
+// The compiler is $VLG_CC (default "cc") with $VLG_CFLAGS (default "-O1"); the
+// generated files go to a private directory under $TMPDIR (default /tmp), which is
+// removed once the code is loaded.
+
+// Same contract as netlist_eval_packed: one settle pass, returns gate evaluations
+typedef size_t (*NetlistCompiledEval)(PatternWord *net_words, int max_loop_iterations);
+
+struct NetlistCompiled
+{
+    void *library; // Shared object handle, NULL when nothing is loaded
+    NetlistCompiledEval eval;
+    // The netlist the code was generated from, and its gate arrays: a netlist rebuilt
+    // in the same struct gets new arrays. Netlists never change after they are built.
+    const struct Netlist *source;
+    const uint32_t *source_gate_out;
+    size_t gate_count;
+    size_t net_count;
+};
+
+// Write the evaluator source (entry point netlist_compiled_eval). Returns 0 on write errors.
+int netlist_codegen_write(const struct Netlist *nl, FILE *out);
+
+// Generate, compile and load an evaluator for nl. Returns 0 if any step fails: no
+// compiler, compile error, or no dynamic loading on this platform.
+int netlist_codegen_load(struct NetlistCompiled *compiled, const struct Netlist *nl);
+void netlist_codegen_unload(struct NetlistCompiled *compiled);
+
+// Run the compiled evaluator when it was loaded for this very netlist, the interpreter
+// (netlist_eval_packed) otherwise
+size_t netlist_codegen_eval(const struct NetlistCompiled *compiled, const struct Netlist *nl,
+                            PatternWord *net_words, int max_loop_iterations);
+
+#endif // NETLIST_CODEGEN_H
@@ -0,0 +1,489 @@
+#include <stdlib.h>
+#include <string.h>
+#include "netlist_opt.h"
+#include "pool.h"
+
+// The optimizer works on nodes: values that the simplified circuit computes.
+// Node 0 is constant LOW, node 1 constant HIGH (driven by a CONSTANT_HIGH gate that
+// only survives if something needs it); every other node is an input or the output
+// of one simplified gate. Each src net maps to the node holding its value.
+#define OPT_LOW 0
+#define OPT_HIGH 1
+#define OPT_NONE UINT32_MAX
+
+typedef enum
+{
+    OPT_NEW,       // A gate was added for the result
+    OPT_FOLDED,    // Constant input or repeated input made the gate trivial
+    OPT_COLLAPSED, // Inverter of an inverter
+    OPT_MERGED     // An identical gate already exists
+} OptOutcome;
+
+struct OptGate
+{
+    uint8_t type;
+    uint32_t a;
+    uint32_t b;
+    uint32_t out;
+};
+
+struct Optimizer
+{
+    const struct Netlist *src;
+    uint32_t *value;      // Node of each src net
+    uint32_t *node_rep;   // A src net carrying the node's value (OPT_NONE for none)
+    uint32_t *node_input; // Input node of the inverter driving the node, OPT_NONE otherwise
+    size_t node_count;
+    struct OptGate *gates;
+    size_t gate_count;
+    uint32_t *table; // Open-addressed hash of gate indices, OPT_NONE when empty
+    size_t table_size;
+};
+
+static uint32_t opt_new_node(struct Optimizer *opt)
+{
+    uint32_t node = (uint32_t)opt->node_count++;
+    opt->node_rep[node] = OPT_NONE;
+    opt->node_input[node] = OPT_NONE;
+    return node;
+}
+
+static void opt_emit(struct Optimizer *opt, GateType type, uint32_t a, uint32_t b, uint32_t out)
+{
+    struct OptGate *gate = &opt->gates[opt->gate_count++];
+    gate->type = (uint8_t)type;
+    gate->a = a;
+    gate->b = b;
+    gate->out = out;
+}
+
+static size_t opt_hash(GateType type, uint32_t a, uint32_t b, size_t mask)
+{
+    uint64_t key = ((uint64_t)a << 32 | b) * 0x9E3779B97F4A7C15ull + (uint64_t)type;
+    return (size_t)(key ^ (key >> 29)) & mask;
+}
+
+// Gate with the given (already simplified) inputs, shared with an identical gate if one exists
+static uint32_t opt_hashed(struct Optimizer *opt, GateType type, uint32_t a, uint32_t b, OptOutcome *outcome)
+{
+    if (type != INVERT && a > b)
+    {
+        uint32_t swap = a;
+        a = b;
+        b = swap;
+    }
+    size_t mask = opt->table_size - 1;
+    size_t slot = opt_hash(type, a, b, mask);
+    for (; opt->table[slot] != OPT_NONE; slot = (slot + 1) & mask)
+    {
+        const struct OptGate *gate = &opt->gates[opt->table[slot]];
+        if (gate->type == (uint8_t)type && gate->a == a && gate->b == b)
+        {
+            *outcome = OPT_MERGED;
+            return gate->out;
+        }
+    }
+    uint32_t out = opt_new_node(opt);
+    if (type == INVERT)
+        opt->node_input[out] = a;
+    opt->table[slot] = (uint32_t)opt->gate_count;
+    opt_emit(opt, type, a, b, out);
+    *outcome = OPT_NEW;
+    return out;
+}
+
+static uint32_t opt_invert(struct Optimizer *opt, uint32_t a, OptOutcome *outcome)
+{
+    if (a == OPT_LOW || a == OPT_HIGH)
+    {
+        *outcome = OPT_FOLDED;
+        return a ^ 1u;
+    }
+    if (opt->node_input[a] != OPT_NONE)
+    {
+        *outcome = OPT_COLLAPSED;
+        return opt->node_input[a];
+    }
+    return opt_hashed(opt, INVERT, a, OPT_LOW, outcome);
+}
+
+// Inverter that replaces a gate folded by a constant input (e.g. NAND with HIGH)
+static uint32_t opt_fold_invert(struct Optimizer *opt, uint32_t a, OptOutcome *outcome)
+{
+    uint32_t node = opt_invert(opt, a, outcome);
+    *outcome = OPT_FOLDED;
+    return node;
+}
+
+static uint32_t opt_reduce(struct Optimizer *opt, GateType type, uint32_t a, uint32_t b, OptOutcome *outcome)
+{
+    *outcome = OPT_FOLDED;
+    switch (type)
+    {
+    case CONSTANT_LOW:
+        return OPT_LOW;
+    case CONSTANT_HIGH:
+        return OPT_HIGH;
+    case INVERT:
+        return opt_invert(opt, a, outcome);
+    case AND:
+        if (a == OPT_LOW || b == OPT_LOW)
+            return OPT_LOW;
+        if (a == OPT_HIGH)
+            return b;
+        if (b == OPT_HIGH || a == b)
+            return a;
+        break;
+    case OR:
+        if (a == OPT_HIGH || b == OPT_HIGH)
+            return OPT_HIGH;
+        if (a == OPT_LOW)
+            return b;
+        if (b == OPT_LOW || a == b)
+            return a;
+        break;
+    case NAND:
+        if (a == OPT_LOW || b == OPT_LOW)
+            return OPT_HIGH;
+        if (a == OPT_HIGH)
+            return opt_fold_invert(opt, b, outcome);
+        if (b == OPT_HIGH || a == b)
+            return opt_fold_invert(opt, a, outcome);
+        break;
+    case NOR:
+        if (a == OPT_HIGH || b == OPT_HIGH)
+            return OPT_LOW;
+        if (a == OPT_LOW)
+            return opt_fold_invert(opt, b, outcome);
+        if (b == OPT_LOW || a == b)
+            return opt_fold_invert(opt, a, outcome);
+        break;
+    case XOR:
+        if (a == b)
+            return OPT_LOW;
+        if (a == OPT_LOW)
+            return b;
+        if (b == OPT_LOW)
+            return a;
+        if (a == OPT_HIGH)
+            return opt_fold_invert(opt, b, outcome);
+        if (b == OPT_HIGH)
+            return opt_fold_invert(opt, a, outcome);
+        break;
+    case XNOR:
+        if (a == b)
+            return OPT_HIGH;
+        if (a == OPT_HIGH)
+            return b;
+        if (b == OPT_HIGH)
+            return a;
+        if (a == OPT_LOW)
+            return opt_fold_invert(opt, b, outcome);
+        if (b == OPT_LOW)
+            return opt_fold_invert(opt, a, outcome);
+        break;
+    default:
+        break;
+    }
+    return opt_hashed(opt, type, a, b, outcome);
+}
+
+// Gates copied unchanged: feedback loops, storage elements, and drivers of nets
+// that have several drivers
+static int opt_opaque(const struct Netlist *src, const uint8_t *driver_count, size_t i)
+{
+    GateType type = (GateType)src->gate_type[i];
+    return src->gate_cyclic[i] || driver_count[src->gate_out[i]] > 1 || gate_is_clocked(type) || type == LATCH ||
+           type == TRISTATE;
+}
+
+// Node a gate input reads. A net no earlier gate has written (possible only in a
+// malformed netlist) reads as constant LOW, so the node is always a valid index.
+static uint32_t opt_input(const struct Optimizer *opt, uint32_t net)
+{
+    uint32_t node = opt->value[net];
+    return node != OPT_NONE ? node : OPT_LOW;
+}
+
+// Forward pass over src in rank order: every net gets its node
+static void opt_simplify(struct Optimizer *opt, const uint8_t *driver_count, struct NetlistOptStats *stats)
+{
+    const struct Netlist *src = opt->src;
+    opt_new_node(opt); // OPT_LOW, never driven
+    opt_new_node(opt); // OPT_HIGH
+    opt_emit(opt, CONSTANT_HIGH, OPT_LOW, OPT_LOW, OPT_HIGH);
+
+    // Inputs, and the nets of gates that are copied unchanged, exist up front:
+    // feedback loops read nets driven later in the same rank
+    for (size_t net = 0; net < src->net_count; ++net)
+        opt->value[net] = OPT_NONE;
+    opt->value[NETLIST_NET_LOW] = OPT_LOW;
+    for (size_t i = 0; i < src->gate_count; ++i)
+    {
+        uint32_t out = src->gate_out[i];
+        if (opt_opaque(src, driver_count, i) && opt->value[out] == OPT_NONE)
+        {
+            opt->value[out] = opt_new_node(opt);
+            opt->node_rep[opt->value[out]] = out;
+        }
+    }
+    for (size_t net = NETLIST_FIRST_NET; net < src->net_count; ++net)
+    {
+        if (src->net_driver[net] == NETLIST_NO_NET)
+        {
+            opt->value[net] = opt_new_node(opt);
+            opt->node_rep[opt->value[net]] = (uint32_t)net;
+        }
+    }
+
+    for (size_t i = 0; i < src->gate_count; ++i)
+    {
+        GateType type = (GateType)src->gate_type[i];
+        uint32_t out = src->gate_out[i];
+        if (gate_is_clocked(type))
+            continue; // Reads nets of later ranks, copied below
+        uint32_t a = opt_input(opt, src->gate_in1[i]);
+        uint32_t b = opt_input(opt, src->gate_in2[i]);
+        if (opt_opaque(src, driver_count, i))
+        {
+            opt_emit(opt, type, a, b, opt->value[out]); // Copied unchanged
+            continue;
+        }
+        OptOutcome outcome;
+        uint32_t node = opt_reduce(opt, type, a, b, &outcome);
+        opt->value[out] = node;
+        if (node > OPT_HIGH && opt->node_rep[node] == OPT_NONE)
+            opt->node_rep[node] = out;
+        if (outcome == OPT_FOLDED)
+            stats->folded++;
+        else if (outcome == OPT_COLLAPSED)
+            stats->collapsed++;
+        else if (outcome == OPT_MERGED)
+            stats->merged++;
+    }
+    for (size_t i = 0; i < src->gate_count; ++i)
+    {
+        if (gate_is_clocked((GateType)src->gate_type[i]))
+            opt_emit(opt, (GateType)src->gate_type[i], opt_input(opt, src->gate_in1[i]),
+                     opt_input(opt, src->gate_in2[i]), opt->value[src->gate_out[i]]);
+    }
+}
+
+// Backward pass: mark the gates that a kept node depends on
+static int opt_mark_live(const struct Optimizer *opt, const uint32_t *keep_nets, size_t keep_count,
+                         uint8_t *live_gate)
+{
+    size_t nodes = opt->node_count;
+    uint32_t *driver_start = calloc(nodes + 1, sizeof(uint32_t));
+    uint32_t *drivers = malloc((opt->gate_count + 1) * sizeof(uint32_t));
+    uint32_t *stack = malloc((nodes + 1) * sizeof(uint32_t));
+    uint8_t *seen = calloc(nodes + 1, 1);
+    if (!driver_start || !drivers || !stack || !seen)
+    {
+        free(driver_start);
+        free(drivers);
+        free(stack);
+        free(seen);
+        return 0;
+    }
+    for (size_t g = 0; g < opt->gate_count; ++g)
+        driver_start[opt->gates[g].out + 1]++;
+    for (size_t n = 0; n < nodes; ++n)
+        driver_start[n + 1] += driver_start[n];
+    uint32_t *fill = stack; // Reused as the fill cursor before the walk starts
+    memcpy(fill, driver_start, nodes * sizeof(uint32_t));
+    for (size_t g = 0; g < opt->gate_count; ++g)
+        drivers[fill[opt->gates[g].out]++] = (uint32_t)g;
+
+    size_t top = 0;
+    for (size_t k = 0; k < keep_count; ++k)
+    {
+        uint32_t node = opt->value[keep_nets[k]];
+        if (node != OPT_NONE && !seen[node])
+        {
+            seen[node] = 1;
+            stack[top++] = node;
+        }
+    }
+    while (top > 0)
+    {
+        uint32_t node = stack[--top];
+        for (uint32_t d = driver_start[node]; d < driver_start[node + 1]; ++d)
+        {
+            const struct OptGate *gate = &opt->gates[drivers[d]];
+            live_gate[drivers[d]] = 1;
+            int inputs = 2;
+            if (gate->type == CONSTANT_LOW || gate->type == CONSTANT_HIGH || gate->type == CLOCK)
+                inputs = 0;
+            else if (gate->type == INVERT)
+                inputs = 1;
+            uint32_t in[2] = {gate->a, gate->b};
+            for (int k = 0; k < inputs; ++k)
+            {
+                if (!seen[in[k]])
+                {
+                    seen[in[k]] = 1;
+                    stack[top++] = in[k];
+                }
+            }
+        }
+    }
+    free(driver_start);
+    free(drivers);
+    free(stack);
+    free(seen);
+    return 1;
+}
+
+// Build dst from the live gates through netlist_compile, then map every src net
+static int opt_build(const struct Optimizer *opt, const uint32_t *keep_nets, size_t keep_count,
+                     const uint8_t *live_gate, struct Netlist *dst, uint32_t *net_map)
+{
+    const struct Netlist *src = opt->src;
+    struct Wire **node_wire = calloc(opt->node_count + 1, sizeof(struct Wire *));
+    struct Gate **gates = calloc(opt->gate_count + 1, sizeof(struct Gate *));
+    struct Wire **extras = malloc((keep_count + src->net_count + 1) * sizeof(struct Wire *));
+    int ok = node_wire && gates && extras;
+    struct LogicPool pool; // The temporary gates and wires
+    logic_pool_init(&pool);
+
+    // A wire for every node a live gate touches, plus the inputs and kept nodes
+    size_t gate_total = 0;
+    for (size_t g = 0; ok && g < opt->gate_count; ++g)
+    {
+        if (!live_gate[g])
+            continue;
+        const struct OptGate *og = &opt->gates[g];
+        uint32_t nodes[3] = {og->a, og->b, og->out};
+        for (int k = 0; ok && k < 3; ++k)
+        {
+            if (nodes[k] != OPT_LOW && !node_wire[nodes[k]] && !(node_wire[nodes[k]] = logic_pool_new_wire(&pool, UNKNOWN)))
+                ok = 0;
+        }
+        struct Gate *gate = ok ? logic_pool_new_gate(&pool, (GateType)og->type) : NULL;
+        if (!gate)
+        {
+            ok = 0;
+            break;
+        }
+        gate_set_input(gate, 0, node_wire[og->a]);
+        gate_set_input(gate, 1, node_wire[og->b]);
+        gate->output = node_wire[og->out];
+        gates[gate_total++] = gate;
+    }
+    size_t extra_total = 0;
+    for (size_t k = 0; ok && k <= keep_count + src->net_count; ++k)
+    {
+        uint32_t node;
+        if (k < keep_count)
+            node = opt->value[keep_nets[k]];
+        else if (k - keep_count < src->net_count && src->net_driver[k - keep_count] == NETLIST_NO_NET)
+            node = opt->value[k - keep_count];
+        else
+            continue;
+        if (node == OPT_NONE || node == OPT_LOW)
+            continue;
+        if (!node_wire[node] && !(node_wire[node] = logic_pool_new_wire(&pool, UNKNOWN)))
+            ok = 0;
+        else
+            extras[extra_total++] = node_wire[node];
+    }
+
+    ok = ok && netlist_compile(dst, gates, gate_total, extras, extra_total);
+    if (ok)
+    {
+        for (size_t net = 0; net < src->net_count; ++net)
+        {
+            uint32_t node = opt->value[net];
+            if (node == OPT_LOW)
+                net_map[net] = NETLIST_NET_LOW;
+            else
+                net_map[net] = (node != OPT_NONE) ? netlist_net_of(dst, node_wire[node]) : NETLIST_NO_NET;
+        }
+        // Point the nets at the src wires carrying the same value, then forget the
+        // temporary wires. The gate array was internal too.
+        for (uint32_t node = OPT_HIGH; node < opt->node_count; ++node)
+        {
+            uint32_t net = node_wire[node] ? netlist_net_of(dst, node_wire[node]) : NETLIST_NO_NET;
+            if (net == NETLIST_NO_NET)
+                continue;
+            uint32_t rep = opt->node_rep[node];
+            dst->net_wire[net] = (src->net_wire && rep != OPT_NONE) ? src->net_wire[rep] : NULL;
+        }
+        free(dst->wire_keys);
+        free(dst->wire_nets);
+        free(dst->gate_source);
+        dst->wire_keys = NULL;
+        dst->wire_nets = NULL;
+        dst->gate_source = NULL;
+        dst->wire_table_size = 0;
+    }
+
+    for (size_t node = 0; node_wire && node < opt->node_count; ++node)
+    {
+        if (node_wire[node])
+            wire_release(node_wire[node]);
+    }
+    logic_pool_free(&pool);
+    free(node_wire);
+    free(gates);
+    free(extras);
+    return ok;
+}
+
+int netlist_optimize(const struct Netlist *src, const uint32_t *keep_nets, size_t keep_count,
+                     struct Netlist *dst, uint32_t *net_map, struct NetlistOptStats *stats)
+{
+    memset(dst, 0, sizeof(*dst));
+    struct NetlistOptStats local = {0};
+    local.gates_before = src->gate_count;
+
+    // At most one new gate per src gate, plus the shared HIGH driver
+    size_t max_gates = src->gate_count + 1;
+    size_t max_nodes = src->net_count + max_gates + 2;
+    size_t table_size = 16;
+    while (table_size < max_gates * 2)
+        table_size <<= 1;
+
+    struct Optimizer opt = {0};
+    opt.src = src;
+    opt.value = malloc((src->net_count + 1) * sizeof(uint32_t));
+    opt.node_rep = malloc(max_nodes * sizeof(uint32_t));
+    opt.node_input = malloc(max_nodes * sizeof(uint32_t));
+    opt.gates = malloc(max_gates * sizeof(struct OptGate));
+    opt.table = malloc(table_size * sizeof(uint32_t));
+    opt.table_size = table_size;
+    uint8_t *driver_count = calloc(src->net_count + 1, 1);
+    uint8_t *live_gate = calloc(max_gates, 1);
+    int ok = opt.value && opt.node_rep && opt.node_input && opt.gates && opt.table && driver_count && live_gate;
+    if (ok)
+    {
+        memset(opt.table, 0xFF, table_size * sizeof(uint32_t));
+        for (size_t i = 0; i < src->gate_count; ++i)
+        {
+            if (driver_count[src->gate_out[i]] < 2)
+                driver_count[src->gate_out[i]]++;
+        }
+        opt_simplify(&opt, driver_count, &local);
+        ok = opt_mark_live(&opt, keep_nets, keep_count, live_gate);
+    }
+    if (ok)
+    {
+        for (size_t g = 1; g < opt.gate_count; ++g)
+            local.removed += !live_gate[g];
+        ok = opt_build(&opt, keep_nets, keep_count, live_gate, dst, net_map);
+    }
+    if (ok)
+        local.gates_after = dst->gate_count;
+    if (ok && stats)
+        *stats = local;
+
+    free(opt.value);
+    free(opt.node_rep);
+    free(opt.node_input);
+    free(opt.gates);
+    free(opt.table);
+    free(driver_count);
+    free(live_gate);
+    return ok;
+}
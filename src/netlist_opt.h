@@ -0,0 +1,38 @@
+#ifndef NETLIST_OPT_H
+#define NETLIST_OPT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "netlist.h"
+
+// Logic simplification on a compiled netlist. The result is a new netlist with:
+//   - constants folded through the gates they feed (AND with LOW is LOW, XOR with
+//     HIGH is an inverter, ...), as are gates reading the same net twice
+//   - double inversions collapsed (NOT NOT x is x)
+//   - structurally identical gates (same type, same input nets) merged into one
+//   - gates with no path to a kept net removed
+// Gates inside feedback loops, storage elements (CLOCK, DFF, LATCH), tri-state
+// buffers and gates driving a net that has several drivers are copied unchanged
+// (only their inputs are renamed). The source netlist and whatever it was compiled from are left
+// alone, so the editor keeps its drawing.
+struct NetlistOptStats
+{
+    size_t gates_before;
+    size_t gates_after;
+    size_t folded;    // Gates that became a constant or one of their inputs
+    size_t collapsed; // Inverters cancelled by an inverter in front of them
+    size_t merged;    // Gates identical to an earlier gate
+    size_t removed;   // Gates with no path to a kept net
+};
+
+// keep_nets: nets of src whose values must stay observable (lamps, outputs).
+// net_map (src->net_count entries) receives the net of dst that carries the value of
+// each src net, NETLIST_NET_LOW for nets that are constantly LOW, NETLIST_NO_NET for
+// nets whose logic was removed. Undriven src nets (the inputs) always survive.
+// dst->net_wire keeps pointing at the wires of src, so netlist_load_states works on
+// either netlist; dst has no wire lookup table. stats may be NULL.
+// Returns 0 on allocation failure.
+int netlist_optimize(const struct Netlist *src, const uint32_t *keep_nets, size_t keep_count,
+                     struct Netlist *dst, uint32_t *net_map, struct NetlistOptStats *stats);
+
+#endif // NETLIST_OPT_H
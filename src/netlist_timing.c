@@ -0,0 +1,393 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "netlist_timing.h"
+
+static const char *const gate_type_names[TIMING_GATE_TYPES] = {
+    "LOW", "HIGH", "AND", "OR", "NOT", "NAND", "NOR", "XOR", "XNOR", "CLK", "DFF", "LATCH", "TRI",
+};
+
+void timing_model_default(struct TimingModel *model)
+{
+    static const uint32_t defaults[TIMING_GATE_TYPES] = {
+        0,  // CONSTANT_LOW
+        0,  // CONSTANT_HIGH
+        20, // AND
+        20, // OR
+        10, // INVERT
+        15, // NAND
+        15, // NOR
+        30, // XOR
+        30, // XNOR
+        0,  // CLOCK
+        40, // DFF (clock to output)
+        30, // LATCH
+        15, // TRISTATE
+    };
+    memcpy(model->delay, defaults, sizeof(defaults));
+}
+
+// Delay of a gate type in a per-type table; types the table does not cover take 1
+static uint32_t type_delay(const uint32_t delay[TIMING_GATE_TYPES], unsigned type)
+{
+    return type < TIMING_GATE_TYPES ? delay[type] : 1;
+}
+
+const char *timing_gate_type_name(GateType type)
+{
+    return ((unsigned)type < TIMING_GATE_TYPES) ? gate_type_names[type] : "?";
+}
+
+int timing_model_parse(struct TimingModel *model, const char *spec)
+{
+    const char *p = spec;
+    while (*p)
+    {
+        const char *name = p;
+        while (*p && *p != '=' && *p != ',')
+            p++;
+        size_t name_length = (size_t)(p - name);
+        if (*p != '=')
+            return 0;
+        char *end;
+        unsigned long delay = strtoul(++p, &end, 10);
+        if (end == p || (*end && *end != ',') || delay > UINT32_MAX / 2)
+            return 0;
+        p = end + (*end == ',');
+
+        int type = -1;
+        for (int t = 0; t < TIMING_GATE_TYPES && type < 0; ++t)
+        {
+            size_t k = 0;
+            while (k < name_length && gate_type_names[t][k] &&
+                   toupper((unsigned char)name[k]) == gate_type_names[t][k])
+                k++;
+            if (k == name_length && gate_type_names[t][k] == '\0')
+                type = t;
+        }
+        if (type < 0)
+            return 0;
+        model->delay[type] = (uint32_t)delay;
+    }
+    return 1;
+}
+
+// Inputs that time a gate's output: none for sources and flip-flops (their outputs
+// start at the clock edge), input 1 for inverters
+static int timed_inputs(GateType type)
+{
+    switch (type)
+    {
+    case CONSTANT_LOW:
+    case CONSTANT_HIGH:
+    case CLOCK:
+    case DFF:
+        return 0;
+    case INVERT:
+        return 1;
+    default:
+        return 2;
+    }
+}
+
+int netlist_timing_analyze(struct NetlistTiming *timing, const struct Netlist *nl, const struct TimingModel *model)
+{
+    memset(timing, 0, sizeof(*timing));
+    timing->critical_net = NETLIST_NO_NET;
+    timing->arrival = calloc(nl->net_count + 1, sizeof(uint32_t));
+    timing->arrival_gate = malloc((nl->net_count + 1) * sizeof(uint32_t));
+    timing->late_input = malloc((nl->gate_count + 1) * sizeof(uint32_t));
+    timing->path = malloc((nl->gate_count + 1) * sizeof(uint32_t));
+    if (!timing->arrival || !timing->arrival_gate || !timing->late_input || !timing->path)
+    {
+        netlist_timing_free(timing);
+        return 0;
+    }
+    for (size_t net = 0; net < nl->net_count; ++net)
+        timing->arrival_gate[net] = NETLIST_NO_NET;
+
+    // One pass in rank order: every input is final before its readers, except inside
+    // feedback loops, where inputs from later in the loop still read what they had
+    uint32_t *arrival = timing->arrival;
+    for (size_t g = 0; g < nl->gate_count; ++g)
+    {
+        GateType type = (GateType)nl->gate_type[g];
+        uint32_t inputs[2] = {nl->gate_in1[g], nl->gate_in2[g]};
+        uint32_t late = NETLIST_NO_NET, start = 0;
+        for (int k = 0; k < timed_inputs(type); ++k)
+        {
+            if (inputs[k] < nl->net_count && (late == NETLIST_NO_NET || arrival[inputs[k]] > start))
+            {
+                late = inputs[k];
+                start = arrival[late];
+            }
+        }
+        timing->late_input[g] = late;
+        timing->loop_gates += nl->gate_cyclic[g] != 0;
+
+        uint32_t out = nl->gate_out[g];
+        uint32_t delay = type_delay(model->delay, type);
+        uint32_t at = start + delay;
+        if (at < start)
+            at = UINT32_MAX; // Saturate on absurd models
+        // Several drivers: the net is stable once the last of them is
+        if (at > arrival[out] || timing->arrival_gate[out] == NETLIST_NO_NET)
+        {
+            arrival[out] = at;
+            timing->arrival_gate[out] = (uint32_t)g;
+        }
+        if (timing->critical_net == NETLIST_NO_NET || at > timing->critical_delay)
+        {
+            timing->critical_delay = at;
+            timing->critical_net = out;
+        }
+    }
+
+    // Walk back along the latest inputs; a path through a cut loop could come back
+    // around, so it is never longer than the gate count
+    uint32_t net = timing->critical_net;
+    while (net != NETLIST_NO_NET && timing->arrival_gate[net] != NETLIST_NO_NET &&
+           timing->path_length < nl->gate_count)
+    {
+        uint32_t g = timing->arrival_gate[net];
+        timing->path[timing->path_length++] = g;
+        net = timing->late_input[g];
+    }
+    for (size_t i = 0, j = timing->path_length; i + 1 < j; ++i, --j)
+    {
+        uint32_t swap = timing->path[i];
+        timing->path[i] = timing->path[j - 1];
+        timing->path[j - 1] = swap;
+    }
+    return 1;
+}
+
+void netlist_timing_free(struct NetlistTiming *timing)
+{
+    free(timing->arrival);
+    free(timing->arrival_gate);
+    free(timing->late_input);
+    free(timing->path);
+    memset(timing, 0, sizeof(*timing));
+    timing->critical_net = NETLIST_NO_NET;
+}
+
+int netlist_wheel_init(struct NetlistWheel *wheel, const struct Netlist *nl, const struct TimingModel *model,
+                       const PatternWord *net_words)
+{
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->nl = nl;
+    uint32_t longest = 1;
+    for (int t = 0; t < TIMING_GATE_TYPES; ++t)
+    {
+        wheel->delay[t] = model->delay[t] > 0 ? model->delay[t] : 1;
+        if (wheel->delay[t] > longest)
+            longest = wheel->delay[t];
+    }
+    size_t slots = 2;
+    while (slots <= longest)
+        slots *= 2;
+    wheel->slot_mask = slots - 1;
+
+    wheel->fanout_start = calloc(nl->net_count + 2, sizeof(uint32_t));
+    wheel->fanout_gates = malloc((2 * nl->gate_count + 1) * sizeof(uint32_t));
+    wheel->slot_events = calloc(slots, sizeof(struct WheelEvent *));
+    wheel->slot_count = calloc(slots, sizeof(size_t));
+    wheel->slot_capacity = calloc(slots, sizeof(size_t));
+    wheel->projected = malloc((nl->net_count + 1) * sizeof(PatternWord));
+    wheel->toggled = malloc((nl->net_count + 1) * sizeof(PatternWord));
+    wheel->glitched = malloc((nl->net_count + 1) * sizeof(PatternWord));
+    wheel->dff_clock = malloc((nl->gate_count + 1) * sizeof(PatternWord));
+    wheel->gate_stamp = calloc(nl->gate_count + 1, sizeof(uint32_t));
+    if (!wheel->fanout_start || !wheel->fanout_gates || !wheel->slot_events || !wheel->slot_count ||
+        !wheel->slot_capacity || !wheel->projected || !wheel->toggled || !wheel->glitched || !wheel->dff_clock ||
+        !wheel->gate_stamp)
+    {
+        netlist_wheel_free(wheel);
+        return 0;
+    }
+
+    // Counting sort of (net, reader) pairs; a gate reading a net twice is listed once
+    uint32_t *start = wheel->fanout_start;
+    for (size_t g = 0; g < nl->gate_count; ++g)
+    {
+        uint32_t a = nl->gate_in1[g], b = nl->gate_in2[g];
+        if (a != NETLIST_NET_LOW && a < nl->net_count)
+            start[a + 2]++;
+        if (b != NETLIST_NET_LOW && b < nl->net_count && b != a)
+            start[b + 2]++;
+    }
+    for (size_t net = 2; net < nl->net_count + 2; ++net)
+        start[net] += start[net - 1];
+    for (size_t g = 0; g < nl->gate_count; ++g)
+    {
+        uint32_t a = nl->gate_in1[g], b = nl->gate_in2[g];
+        if (a != NETLIST_NET_LOW && a < nl->net_count)
+            wheel->fanout_gates[start[a + 1]++] = (uint32_t)g;
+        if (b != NETLIST_NET_LOW && b < nl->net_count && b != a)
+            wheel->fanout_gates[start[b + 1]++] = (uint32_t)g;
+    }
+    netlist_wheel_reset(wheel, net_words);
+    return 1;
+}
+
+void netlist_wheel_free(struct NetlistWheel *wheel)
+{
+    if (wheel->slot_events)
+    {
+        for (size_t s = 0; s <= wheel->slot_mask; ++s)
+            free(wheel->slot_events[s]);
+    }
+    free(wheel->slot_events);
+    free(wheel->slot_count);
+    free(wheel->slot_capacity);
+    free(wheel->fanout_start);
+    free(wheel->fanout_gates);
+    free(wheel->projected);
+    free(wheel->toggled);
+    free(wheel->glitched);
+    free(wheel->dff_clock);
+    free(wheel->gate_stamp);
+    free(wheel->changed);
+    memset(wheel, 0, sizeof(*wheel));
+}
+
+void netlist_wheel_reset(struct NetlistWheel *wheel, const PatternWord *net_words)
+{
+    const struct Netlist *nl = wheel->nl;
+    for (size_t s = 0; s <= wheel->slot_mask; ++s)
+        wheel->slot_count[s] = 0;
+    wheel->pending = 0;
+    wheel->now = 0;
+    wheel->last_change = 0;
+    memcpy(wheel->projected, net_words, nl->net_count * sizeof(PatternWord));
+    memset(wheel->toggled, 0, nl->net_count * sizeof(PatternWord));
+    memset(wheel->glitched, 0, nl->net_count * sizeof(PatternWord));
+    for (size_t g = 0; g < nl->gate_count; ++g)
+    {
+        uint32_t clk = nl->gate_in2[g];
+        wheel->dff_clock[g] = (nl->gate_type[g] == DFF && clk < nl->net_count) ? net_words[clk] : 0;
+    }
+}
+
+static int wheel_schedule(struct NetlistWheel *wheel, uint64_t time, uint32_t net, PatternWord value)
+{
+    size_t s = (size_t)(time & wheel->slot_mask);
+    if (wheel->slot_count[s] == wheel->slot_capacity[s])
+    {
+        size_t new_capacity = wheel->slot_capacity[s] == 0 ? 64 : wheel->slot_capacity[s] * 2;
+        struct WheelEvent *events = realloc(wheel->slot_events[s], new_capacity * sizeof(struct WheelEvent));
+        if (!events)
+            return 0;
+        wheel->slot_events[s] = events;
+        wheel->slot_capacity[s] = new_capacity;
+    }
+    wheel->slot_events[s][wheel->slot_count[s]++] = (struct WheelEvent){net, value};
+    wheel->projected[net] = value;
+    wheel->pending++;
+    return 1;
+}
+
+int netlist_wheel_drive(struct NetlistWheel *wheel, uint32_t net, PatternWord value)
+{
+    if (net >= wheel->nl->net_count)
+        return 1;
+    return wheel_schedule(wheel, wheel->now, net, value);
+}
+
+// Output a gate takes delay after now; DFFs also remember the clock they saw
+static PatternWord wheel_gate_next(struct NetlistWheel *wheel, const PatternWord *net_words, uint32_t g)
+{
+    const struct Netlist *nl = wheel->nl;
+    GateType type = (GateType)nl->gate_type[g];
+    PatternWord a = net_words[nl->gate_in1[g] < nl->net_count ? nl->gate_in1[g] : NETLIST_NET_LOW];
+    PatternWord b = net_words[nl->gate_in2[g] < nl->net_count ? nl->gate_in2[g] : NETLIST_NET_LOW];
+    PatternWord q = wheel->projected[nl->gate_out[g]];
+    if (type == DFF)
+    {
+        PatternWord rising = b & ~wheel->dff_clock[g];
+        wheel->dff_clock[g] = b;
+        return (q & ~rising) | (a & rising);
+    }
+    return update_gate_packed_next(type, a, b, q);
+}
+
+size_t netlist_wheel_run(struct NetlistWheel *wheel, PatternWord *net_words, uint64_t until)
+{
+    const struct Netlist *nl = wheel->nl;
+    size_t evaluated = 0;
+    while (wheel->pending > 0 && wheel->now <= until)
+    {
+        size_t s = (size_t)(wheel->now & wheel->slot_mask);
+        size_t count = wheel->slot_count[s];
+        if (count == 0)
+        {
+            wheel->now++;
+            continue;
+        }
+        if (wheel->changed_capacity < count)
+        {
+            uint32_t *changed = realloc(wheel->changed, count * sizeof(uint32_t));
+            if (!changed)
+                break;
+            wheel->changed = changed;
+            wheel->changed_capacity = count;
+        }
+
+        // Apply the whole slot first, so gates see all of this instant's changes
+        size_t changed_count = 0;
+        for (size_t e = 0; e < count; ++e)
+        {
+            const struct WheelEvent *ev = &wheel->slot_events[s][e];
+            PatternWord diff = net_words[ev->net] ^ ev->value;
+            if (!diff)
+                continue;
+            net_words[ev->net] = ev->value;
+            wheel->glitched[ev->net] |= wheel->toggled[ev->net] & diff;
+            wheel->toggled[ev->net] |= diff;
+            wheel->changed[changed_count++] = ev->net;
+        }
+        wheel->slot_count[s] = 0;
+        wheel->pending -= count;
+        wheel->events += changed_count;
+        if (changed_count > 0)
+            wheel->last_change = wheel->now;
+
+        // Every delay is at least 1 and shorter than the wheel: no event lands in slot s
+        wheel->stamp++;
+        for (size_t c = 0; c < changed_count; ++c)
+        {
+            uint32_t net = wheel->changed[c];
+            for (uint32_t f = wheel->fanout_start[net]; f < wheel->fanout_start[net + 1]; ++f)
+            {
+                uint32_t g = wheel->fanout_gates[f];
+                if (wheel->gate_stamp[g] == wheel->stamp)
+                    continue;
+                wheel->gate_stamp[g] = wheel->stamp;
+                evaluated++;
+                PatternWord next = wheel_gate_next(wheel, net_words, g);
+                uint32_t out = nl->gate_out[g];
+                if (next != wheel->projected[out] &&
+                    !wheel_schedule(wheel, wheel->now + type_delay(wheel->delay, nl->gate_type[g]), out, next))
+                {
+                    wheel->evaluations += evaluated;
+                    return evaluated; // Out of memory: the rest of the slot is lost
+                }
+            }
+        }
+        wheel->now++;
+    }
+    wheel->evaluations += evaluated;
+    return evaluated;
+}
+
+size_t netlist_wheel_glitches(const struct NetlistWheel *wheel, PatternWord lanes)
+{
+    size_t count = 0;
+    for (size_t net = 0; net < wheel->nl->net_count; ++net)
+    {
+        for (PatternWord bits = wheel->glitched[net] & lanes; bits; bits &= bits - 1)
+            count++;
+    }
+    return count;
+}
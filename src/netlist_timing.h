@@ -0,0 +1,112 @@
+#ifndef NETLIST_TIMING_H
+#define NETLIST_TIMING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "netlist.h"
+
+// Gate-delay timing on a compiled netlist. Every gate type has a propagation delay
+// (struct TimingModel, in picoseconds).
+//
+// netlist_timing_analyze is the static pass: the latest time every net can still
+// change after the inputs do (or, behind a flip-flop, after the clock edge) and the
+// longest path through the logic, which is the shortest usable clock period.
+//
+// struct NetlistWheel is the dynamic counterpart: event-driven simulation on a
+// timing wheel where each gate's output follows its inputs after the gate's delay.
+// Paths of different lengths into one gate then show up as glitches, nets that
+// change more than once before they settle.
+
+#define TIMING_GATE_TYPES GATE_TYPE_COUNT
+
+struct TimingModel
+{
+    uint32_t delay[TIMING_GATE_TYPES]; // Per GateType; for DFF the clock-to-output delay
+};
+
+// Rough defaults: inverters fastest, XOR/XNOR slowest, sources (constants, CLOCK) 0
+void timing_model_default(struct TimingModel *model);
+
+// Apply comma-separated TYPE=ps pairs, e.g. "XOR=40,DFF=60" (names as in
+// timing_gate_type_name, case-insensitive). Returns 0 on a syntax error or an unknown
+// type; the pairs before it have been applied.
+int timing_model_parse(struct TimingModel *model, const char *spec);
+const char *timing_gate_type_name(GateType type);
+
+struct NetlistTiming
+{
+    uint32_t *arrival;       // Per net: latest change after an input change or clock edge
+    uint32_t *arrival_gate;  // Per net: driver on the latest path, NETLIST_NO_NET for sources
+    uint32_t *late_input;    // Per gate: the input net that arrives last, NETLIST_NO_NET if none
+    uint32_t critical_delay; // Longest path (flip-flop setup times are not modelled)
+    uint32_t critical_net;   // Net the longest path ends on, NETLIST_NO_NET without gates
+    uint32_t *path;          // Gates on the longest path, first to last
+    size_t path_length;
+    size_t loop_gates;       // Gates in feedback loops; a loop is cut where it closes
+};
+
+// Returns 0 on allocation failure
+int netlist_timing_analyze(struct NetlistTiming *timing, const struct Netlist *nl, const struct TimingModel *model);
+void netlist_timing_free(struct NetlistTiming *timing);
+
+struct WheelEvent
+{
+    uint32_t net;
+    PatternWord value;
+};
+
+// Timed simulation of 64 patterns at once. Time t lives in slot t & slot_mask; every
+// delay is shorter than the wheel, so a slot never holds events of two different
+// times. Gate delays of 0 take one time unit here, so feedback loops still advance.
+struct NetlistWheel
+{
+    const struct Netlist *nl;
+    uint32_t delay[TIMING_GATE_TYPES];
+
+    // Gates reading each net: fanout_gates[fanout_start[n] .. fanout_start[n + 1])
+    uint32_t *fanout_start;
+    uint32_t *fanout_gates;
+
+    struct WheelEvent **slot_events;
+    size_t *slot_count;
+    size_t *slot_capacity;
+    size_t slot_mask;
+    size_t pending; // Events in all slots
+
+    uint64_t now;         // Next time to process
+    uint64_t last_change; // Time of the latest net change: when the logic settled
+    size_t events;        // Net changes applied so far
+    size_t evaluations;   // Gate evaluations so far
+
+    PatternWord *projected; // Per net: value once the pending events are applied
+    PatternWord *toggled;   // Per net: lanes that changed since the last reset
+    PatternWord *glitched;  // Per net: lanes that changed more than once
+    PatternWord *dff_clock; // Per gate: clock input a DFF saw last
+    uint32_t *gate_stamp;   // Per gate: slot pass that last evaluated it
+    uint32_t stamp;
+    uint32_t *changed; // Nets changed in the slot being processed
+    size_t changed_capacity;
+};
+
+// net_words must be settled; they are the starting point (see netlist_wheel_reset).
+// Returns 0 on allocation failure.
+int netlist_wheel_init(struct NetlistWheel *wheel, const struct Netlist *nl, const struct TimingModel *model,
+                       const PatternWord *net_words);
+void netlist_wheel_free(struct NetlistWheel *wheel);
+
+// Drop pending events, restart at time 0 from the settled net_words and clear the
+// glitch record
+void netlist_wheel_reset(struct NetlistWheel *wheel, const PatternWord *net_words);
+
+// Change a net (an input or a clock source) at the current time. Returns 0 on
+// allocation failure.
+int netlist_wheel_drive(struct NetlistWheel *wheel, uint32_t net, PatternWord value);
+
+// Process events up to and including time until, or until none are left. Returns the
+// gate evaluations made by this call.
+size_t netlist_wheel_run(struct NetlistWheel *wheel, PatternWord *net_words, uint64_t until);
+
+// (net, pattern) pairs among the given lanes that glitched since the last reset
+size_t netlist_wheel_glitches(const struct NetlistWheel *wheel, PatternWord lanes);
+
+#endif // NETLIST_TIMING_H
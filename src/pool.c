@@ -0,0 +1,200 @@
+#include <stdlib.h>
+#include <string.h>
+#include "pool.h"
+
+void pool_init(struct Pool *pool, size_t object_size)
+{
+    memset(pool, 0, sizeof(*pool));
+    // Objects are pointer-aligned and large enough for the free list link
+    size_t align = sizeof(struct PoolFree);
+    if (object_size < align)
+        object_size = align;
+    pool->object_size = (object_size + align - 1) / align * align;
+    pool->slab_objects = POOL_FIRST_SLAB_OBJECTS;
+}
+
+void *pool_alloc(struct Pool *pool)
+{
+    if (pool->free_list)
+    {
+        struct PoolFree *object = pool->free_list;
+        pool->free_list = object->next;
+        pool->live++;
+        return object;
+    }
+    if (pool->left == 0)
+    {
+        if (pool->slab_count == pool->slab_capacity)
+        {
+            size_t new_capacity = pool->slab_capacity == 0 ? 8 : pool->slab_capacity * 2;
+            char **slabs = realloc(pool->slabs, new_capacity * sizeof(char *));
+            if (!slabs)
+                return NULL;
+            pool->slabs = slabs;
+            pool->slab_capacity = new_capacity;
+        }
+        char *slab = malloc(pool->slab_objects * pool->object_size);
+        if (!slab)
+            return NULL;
+        pool->slabs[pool->slab_count++] = slab;
+        pool->next = slab;
+        pool->left = pool->slab_objects;
+        if (pool->slab_objects < POOL_MAX_SLAB_OBJECTS)
+            pool->slab_objects *= 2;
+    }
+    void *object = pool->next;
+    pool->next += pool->object_size;
+    pool->left--;
+    pool->live++;
+    return object;
+}
+
+void pool_release(struct Pool *pool, void *object)
+{
+    if (!object)
+        return;
+    struct PoolFree *link = object;
+    link->next = pool->free_list;
+    pool->free_list = link;
+    pool->live--;
+}
+
+void pool_free(struct Pool *pool)
+{
+    for (size_t s = 0; s < pool->slab_count; ++s)
+        free(pool->slabs[s]);
+    free(pool->slabs);
+    pool_init(pool, pool->object_size);
+}
+
+size_t pool_bytes(const struct Pool *pool)
+{
+    // Slabs double from POOL_FIRST_SLAB_OBJECTS until they reach the maximum
+    size_t objects = 0, slab_objects = POOL_FIRST_SLAB_OBJECTS;
+    for (size_t s = 0; s < pool->slab_count; ++s)
+    {
+        objects += slab_objects;
+        if (slab_objects < POOL_MAX_SLAB_OBJECTS)
+            slab_objects *= 2;
+    }
+    return objects * pool->object_size + pool->slab_capacity * sizeof(char *);
+}
+
+void array_pool_init(struct ArrayPool *pool, size_t element_size)
+{
+    pool->element_size = element_size;
+    for (int k = 0; k < POOL_ARRAY_CLASSES; ++k)
+        pool_init(&pool->classes[k], element_size << k);
+}
+
+// Smallest class holding count elements, POOL_ARRAY_CLASSES if none does
+static int array_pool_class(size_t count)
+{
+    int k = 0;
+    while (k < POOL_ARRAY_CLASSES && ((size_t)1 << k) < count)
+        k++;
+    return k;
+}
+
+void *array_pool_alloc(struct ArrayPool *pool, size_t count, size_t *capacity)
+{
+    int k = array_pool_class(count);
+    if (k == POOL_ARRAY_CLASSES)
+        return NULL;
+    void *array = pool_alloc(&pool->classes[k]);
+    if (array)
+        *capacity = (size_t)1 << k;
+    return array;
+}
+
+void array_pool_release(struct ArrayPool *pool, void *array, size_t capacity)
+{
+    int k = array_pool_class(capacity);
+    if (k < POOL_ARRAY_CLASSES)
+        pool_release(&pool->classes[k], array);
+}
+
+void array_pool_free(struct ArrayPool *pool)
+{
+    for (int k = 0; k < POOL_ARRAY_CLASSES; ++k)
+        pool_free(&pool->classes[k]);
+}
+
+size_t array_pool_bytes(const struct ArrayPool *pool)
+{
+    size_t bytes = 0;
+    for (int k = 0; k < POOL_ARRAY_CLASSES; ++k)
+        bytes += pool_bytes(&pool->classes[k]);
+    return bytes;
+}
+
+void logic_pool_init(struct LogicPool *pool)
+{
+    pool_init(&pool->gates, sizeof(struct Gate));
+    pool_init(&pool->wires, sizeof(struct Wire));
+    pool_init(&pool->lamps, sizeof(struct Lamp));
+}
+
+struct Gate *logic_pool_new_gate(struct LogicPool *pool, GateType type)
+{
+    struct Gate *gate = pool_alloc(&pool->gates);
+    if (gate)
+        gate_init(gate, type);
+    return gate;
+}
+
+struct Wire *logic_pool_new_wire(struct LogicPool *pool, SignalState state)
+{
+    struct Wire *wire = pool_alloc(&pool->wires);
+    if (wire && !wire_init(wire, state))
+    {
+        pool_release(&pool->wires, wire);
+        wire = NULL;
+    }
+    return wire;
+}
+
+struct Lamp *logic_pool_new_lamp(struct LogicPool *pool, struct Wire *input)
+{
+    struct Lamp *lamp = pool_alloc(&pool->lamps);
+    if (lamp)
+    {
+        lamp->input = input;
+        lamp->state = UNKNOWN;
+    }
+    return lamp;
+}
+
+void logic_pool_delete_gate(struct LogicPool *pool, struct Gate *gate)
+{
+    if (!gate)
+        return;
+    gate_detach_inputs(gate);
+    gate_set_output(gate, NULL);
+    pool_release(&pool->gates, gate);
+}
+
+void logic_pool_delete_wire(struct LogicPool *pool, struct Wire *wire)
+{
+    if (!wire)
+        return;
+    wire_release(wire);
+    pool_release(&pool->wires, wire);
+}
+
+void logic_pool_delete_lamp(struct LogicPool *pool, struct Lamp *lamp)
+{
+    pool_release(&pool->lamps, lamp);
+}
+
+void logic_pool_free(struct LogicPool *pool)
+{
+    pool_free(&pool->gates);
+    pool_free(&pool->wires);
+    pool_free(&pool->lamps);
+}
+
+size_t logic_pool_bytes(const struct LogicPool *pool)
+{
+    return pool_bytes(&pool->gates) + pool_bytes(&pool->wires) + pool_bytes(&pool->lamps);
+}
@@ -0,0 +1,93 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include "logic.h"
+
+// Slab allocators for the many small objects of a design.
+//
+// struct Pool hands out objects of one size, carved from slabs that double in size up
+// to POOL_MAX_SLAB_OBJECTS objects. Released objects go on a free list and are reused
+// first, so allocating is a pointer bump or a list pop; pool_free gives every slab
+// back at once, without visiting the objects.
+//
+// struct ArrayPool does the same for arrays of one element type, with a Pool per
+// power-of-two size class. struct LogicPool holds the gates, wires and lamps of a
+// design and hands them out initialized.
+
+#define POOL_FIRST_SLAB_OBJECTS 64
+#define POOL_MAX_SLAB_OBJECTS 65536
+#define POOL_ARRAY_CLASSES 17 // Arrays of 1, 2, 4 ... 65536 elements
+
+struct PoolFree
+{
+    struct PoolFree *next;
+};
+
+struct Pool
+{
+    size_t object_size;  // Rounded up so every object can hold a free list link
+    size_t slab_objects; // Size of the next slab
+    char **slabs;
+    size_t slab_count;
+    size_t slab_capacity;
+    char *next;  // Unused tail of the newest slab
+    size_t left; // Objects left there
+    struct PoolFree *free_list;
+    size_t live; // Objects handed out and not released
+};
+
+void pool_init(struct Pool *pool, size_t object_size);
+
+// Uninitialized object, NULL when out of memory
+void *pool_alloc(struct Pool *pool);
+void pool_release(struct Pool *pool, void *object);
+
+// Release every slab; all objects become invalid at once. The pool stays usable.
+void pool_free(struct Pool *pool);
+
+// Bytes held in slabs
+size_t pool_bytes(const struct Pool *pool);
+
+struct ArrayPool
+{
+    size_t element_size;
+    struct Pool classes[POOL_ARRAY_CLASSES];
+};
+
+void array_pool_init(struct ArrayPool *pool, size_t element_size);
+
+// Room for count elements (at least one); *capacity receives the size class, which
+// array_pool_release needs back. NULL when out of memory or count is larger than
+// the largest class.
+void *array_pool_alloc(struct ArrayPool *pool, size_t count, size_t *capacity);
+void array_pool_release(struct ArrayPool *pool, void *array, size_t capacity);
+void array_pool_free(struct ArrayPool *pool);
+size_t array_pool_bytes(const struct ArrayPool *pool);
+
+struct LogicPool
+{
+    struct Pool gates;
+    struct Pool wires;
+    struct Pool lamps;
+};
+
+void logic_pool_init(struct LogicPool *pool);
+
+// Fresh objects as gate_init / wire_init leave them; NULL when out of memory
+struct Gate *logic_pool_new_gate(struct LogicPool *pool, GateType type);
+struct Wire *logic_pool_new_wire(struct LogicPool *pool, SignalState state);
+struct Lamp *logic_pool_new_lamp(struct LogicPool *pool, struct Wire *input);
+
+// Single deletes: the gate is detached from its inputs and its drive taken off its
+// output net first, the wire's fanout list freed (the same rules as wire_destroy apply)
+void logic_pool_delete_gate(struct LogicPool *pool, struct Gate *gate);
+void logic_pool_delete_wire(struct LogicPool *pool, struct Wire *wire);
+void logic_pool_delete_lamp(struct LogicPool *pool, struct Lamp *lamp);
+
+// Release all objects at once. Fanout lists live on the heap, since they grow: call
+// wire_release on the wires still in use first.
+void logic_pool_free(struct LogicPool *pool);
+size_t logic_pool_bytes(const struct LogicPool *pool);
+
+#endif // POOL_H
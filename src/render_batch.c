@@ -0,0 +1,120 @@
+#include "render_batch.h"
+#include <math.h>
+#include <stdlib.h>
+
+void render_batch_init(RenderBatch *batch)
+{
+    batch->vertices = NULL;
+    batch->vertex_count = 0;
+    batch->vertex_capacity = 0;
+    batch->indices = NULL;
+    batch->index_count = 0;
+    batch->index_capacity = 0;
+}
+
+void render_batch_free(RenderBatch *batch)
+{
+    free(batch->vertices);
+    free(batch->indices);
+    render_batch_init(batch);
+}
+
+// Make room for one more quad; returns 0 on allocation failure
+static int ensure_quad_capacity(RenderBatch *batch)
+{
+    if (batch->vertex_count + 4 > batch->vertex_capacity)
+    {
+        int new_capacity = batch->vertex_capacity == 0 ? 1024 : batch->vertex_capacity * 2;
+        SDL_Vertex *vertices = realloc(batch->vertices, (size_t)new_capacity * sizeof(SDL_Vertex));
+        if (!vertices)
+            return 0;
+        batch->vertices = vertices;
+        batch->vertex_capacity = new_capacity;
+    }
+    if (batch->index_count + 6 > batch->index_capacity)
+    {
+        int new_capacity = batch->index_capacity == 0 ? 1536 : batch->index_capacity * 2;
+        int *indices = realloc(batch->indices, (size_t)new_capacity * sizeof(int));
+        if (!indices)
+            return 0;
+        batch->indices = indices;
+        batch->index_capacity = new_capacity;
+    }
+    return 1;
+}
+
+// Corners in winding order: (x0, y0) (x1, y1) (x2, y2) (x3, y3)
+static void push_quad(RenderBatch *batch, const float *xs, const float *ys, SDL_Color color)
+{
+    if (!ensure_quad_capacity(batch))
+        return;
+    SDL_FColor fcolor = {color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f};
+    int base = batch->vertex_count;
+    for (int i = 0; i < 4; ++i)
+    {
+        SDL_Vertex *v = &batch->vertices[base + i];
+        v->position.x = xs[i];
+        v->position.y = ys[i];
+        v->color = fcolor;
+        v->tex_coord.x = 0.0f;
+        v->tex_coord.y = 0.0f;
+    }
+    batch->vertex_count += 4;
+
+    int *idx = &batch->indices[batch->index_count];
+    idx[0] = base;
+    idx[1] = base + 1;
+    idx[2] = base + 2;
+    idx[3] = base;
+    idx[4] = base + 2;
+    idx[5] = base + 3;
+    batch->index_count += 6;
+}
+
+void render_batch_fill_rect(RenderBatch *batch, const SDL_FRect *rect, SDL_Color color)
+{
+    float xs[4] = {rect->x, rect->x + rect->w, rect->x + rect->w, rect->x};
+    float ys[4] = {rect->y, rect->y, rect->y + rect->h, rect->y + rect->h};
+    push_quad(batch, xs, ys, color);
+}
+
+void render_batch_rect(RenderBatch *batch, const SDL_FRect *rect, float thickness, SDL_Color color)
+{
+    float t = thickness;
+    if (t * 2.0f >= rect->w || t * 2.0f >= rect->h)
+    {
+        render_batch_fill_rect(batch, rect, color);
+        return;
+    }
+    render_batch_fill_rect(batch, &(SDL_FRect){rect->x, rect->y, rect->w, t}, color);
+    render_batch_fill_rect(batch, &(SDL_FRect){rect->x, rect->y + rect->h - t, rect->w, t}, color);
+    render_batch_fill_rect(batch, &(SDL_FRect){rect->x, rect->y + t, t, rect->h - 2.0f * t}, color);
+    render_batch_fill_rect(batch, &(SDL_FRect){rect->x + rect->w - t, rect->y + t, t, rect->h - 2.0f * t}, color);
+}
+
+void render_batch_line(RenderBatch *batch, float x1, float y1, float x2, float y2,
+                       float thickness, SDL_Color color)
+{
+    float dx = x2 - x1;
+    float dy = y2 - y1;
+    float len = sqrtf(dx * dx + dy * dy);
+    if (len <= 0.0f)
+        return;
+    // Offset both ends by half the width along the normal
+    float nx = -dy / len * thickness * 0.5f;
+    float ny = dx / len * thickness * 0.5f;
+    float xs[4] = {x1 + nx, x2 + nx, x2 - nx, x1 - nx};
+    float ys[4] = {y1 + ny, y2 + ny, y2 - ny, y1 - ny};
+    push_quad(batch, xs, ys, color);
+}
+
+void render_batch_flush(RenderBatch *batch, SDL_Renderer *renderer)
+{
+    if (batch->index_count > 0)
+    {
+        SDL_RenderGeometry(renderer, NULL, batch->vertices, batch->vertex_count,
+                           batch->indices, batch->index_count);
+    }
+    batch->vertex_count = 0;
+    batch->index_count = 0;
+}
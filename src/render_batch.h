@@ -0,0 +1,32 @@
+#ifndef RENDER_BATCH_H
+#define RENDER_BATCH_H
+
+#include <SDL3/SDL.h>
+
+// Collects solid-colour quads (filled rects, outlines, thick lines) as indexed
+// triangles with per-vertex colours, so a whole layer of the scene goes to the GPU
+// in one SDL_RenderGeometry call instead of one draw call per primitive.
+typedef struct RenderBatch
+{
+    SDL_Vertex *vertices;
+    int vertex_count;
+    int vertex_capacity;
+    int *indices;
+    int index_count;
+    int index_capacity;
+} RenderBatch;
+
+void render_batch_init(RenderBatch *batch);
+void render_batch_free(RenderBatch *batch);
+
+void render_batch_fill_rect(RenderBatch *batch, const SDL_FRect *rect, SDL_Color color);
+// Border of width thickness drawn inside rect (thickness 1 matches SDL_RenderRect)
+void render_batch_rect(RenderBatch *batch, const SDL_FRect *rect, float thickness, SDL_Color color);
+// Line from (x1, y1) to (x2, y2) as a quad of the given width
+void render_batch_line(RenderBatch *batch, float x1, float y1, float x2, float y2,
+                       float thickness, SDL_Color color);
+
+// Draw everything collected so far and start over (keeps the allocations)
+void render_batch_flush(RenderBatch *batch, SDL_Renderer *renderer);
+
+#endif // RENDER_BATCH_H
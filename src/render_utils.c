@@ -1,38 +1,167 @@
 #include "render_utils.h"
 #include <string.h>
 
-void render_text_centered(SDL_Renderer *renderer, TTF_Font *font,
-                          const char *text, float y, SDL_Color color)
+// Text cache: fixed number of entries, hashed by key, evicted least recently used first
+#define TEXT_CACHE_CAPACITY 256
+#define TEXT_CACHE_BUCKETS 512 // Power of two
+#define TEXT_CACHE_MAX_TEXT 64 // Longer strings are rendered uncached
+
+typedef struct
 {
-    SDL_Surface *surface = TTF_RenderText_Blended(font, text, strlen(text), color);
+    SDL_Renderer *renderer;
+    TTF_Font *font;
+    float font_size;
+    SDL_Color color;
+    char text[TEXT_CACHE_MAX_TEXT];
 
-    if (surface)
+    SDL_Texture *texture;
+    float width, height;
+
+    int bucket_next; // Next entry in the same hash bucket, -1 = end
+    int lru_prev;    // Towards most recently used, -1 = head
+    int lru_next;    // Towards least recently used, -1 = tail
+} TextCacheEntry;
+
+static TextCacheEntry text_cache[TEXT_CACHE_CAPACITY];
+static int text_cache_buckets[TEXT_CACHE_BUCKETS];
+static int text_cache_count = 0;
+static int text_cache_lru_head = -1;
+static int text_cache_lru_tail = -1;
+static int text_cache_ready = 0;
+
+static void text_cache_init(void)
+{
+    for (int i = 0; i < TEXT_CACHE_BUCKETS; ++i)
+        text_cache_buckets[i] = -1;
+    text_cache_count = 0;
+    text_cache_lru_head = -1;
+    text_cache_lru_tail = -1;
+    text_cache_ready = 1;
+}
+
+static unsigned int text_cache_hash(SDL_Renderer *renderer, TTF_Font *font, float font_size,
+                                    SDL_Color color, const char *text)
+{
+    // FNV-1a over the key fields
+    unsigned int hash = 2166136261u;
+    const void *parts[4] = {&renderer, &font, &font_size, &color};
+    const size_t sizes[4] = {sizeof(renderer), sizeof(font), sizeof(font_size), sizeof(color)};
+    for (int p = 0; p < 4; ++p)
     {
-        SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+        const unsigned char *bytes = parts[p];
+        for (size_t i = 0; i < sizes[p]; ++i)
+            hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    for (const unsigned char *c = (const unsigned char *)text; *c; ++c)
+        hash = (hash ^ *c) * 16777619u;
+    return hash & (TEXT_CACHE_BUCKETS - 1);
+}
 
-        if (texture)
-        {
-            // Get actual window size
-            int window_w, window_h;
-            SDL_Window *window = SDL_GetRenderWindow(renderer);
-            SDL_GetWindowSizeInPixels(window, &window_w, &window_h);
+static void lru_unlink(int index)
+{
+    TextCacheEntry *e = &text_cache[index];
+    if (e->lru_prev >= 0)
+        text_cache[e->lru_prev].lru_next = e->lru_next;
+    else
+        text_cache_lru_head = e->lru_next;
+    if (e->lru_next >= 0)
+        text_cache[e->lru_next].lru_prev = e->lru_prev;
+    else
+        text_cache_lru_tail = e->lru_prev;
+}
 
-            SDL_FRect dest_rect;
-            dest_rect.w = (float)surface->w;
-            dest_rect.h = (float)surface->h;
-            dest_rect.x = ((float)window_w - dest_rect.w) / 2.0f;
-            dest_rect.y = y;
+static void lru_push_front(int index)
+{
+    TextCacheEntry *e = &text_cache[index];
+    e->lru_prev = -1;
+    e->lru_next = text_cache_lru_head;
+    if (text_cache_lru_head >= 0)
+        text_cache[text_cache_lru_head].lru_prev = index;
+    text_cache_lru_head = index;
+    if (text_cache_lru_tail < 0)
+        text_cache_lru_tail = index;
+}
 
-            SDL_RenderTexture(renderer, texture, NULL, &dest_rect);
-            SDL_DestroyTexture(texture);
+static void bucket_unlink(int index)
+{
+    TextCacheEntry *e = &text_cache[index];
+    unsigned int bucket = text_cache_hash(e->renderer, e->font, e->font_size, e->color, e->text);
+    int *link = &text_cache_buckets[bucket];
+    while (*link >= 0 && *link != index)
+        link = &text_cache[*link].bucket_next;
+    if (*link == index)
+        *link = e->bucket_next;
+}
+
+// Cached texture for the text, rasterizing it on a miss. NULL if it cannot be drawn.
+static TextCacheEntry *text_cache_get(SDL_Renderer *renderer, TTF_Font *font, const char *text, SDL_Color color)
+{
+    if (!text_cache_ready)
+        text_cache_init();
+    float font_size = TTF_GetFontSize(font);
+    unsigned int bucket = text_cache_hash(renderer, font, font_size, color, text);
+    for (int i = text_cache_buckets[bucket]; i >= 0; i = text_cache[i].bucket_next)
+    {
+        TextCacheEntry *e = &text_cache[i];
+        if (e->renderer == renderer && e->font == font && e->font_size == font_size &&
+            e->color.r == color.r && e->color.g == color.g && e->color.b == color.b && e->color.a == color.a &&
+            strcmp(e->text, text) == 0)
+        {
+            lru_unlink(i);
+            lru_push_front(i);
+            return e;
         }
+    }
 
-        SDL_DestroySurface(surface);
+    SDL_Surface *surface = TTF_RenderText_Blended(font, text, strlen(text), color);
+    if (!surface)
+        return NULL;
+    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+    float width = (float)surface->w;
+    float height = (float)surface->h;
+    SDL_DestroySurface(surface);
+    if (!texture)
+        return NULL;
+
+    int index;
+    if (text_cache_count < TEXT_CACHE_CAPACITY)
+    {
+        index = text_cache_count++;
+    }
+    else
+    {
+        // Reuse the least recently used entry
+        index = text_cache_lru_tail;
+        lru_unlink(index);
+        bucket_unlink(index);
+        SDL_DestroyTexture(text_cache[index].texture);
     }
+
+    TextCacheEntry *e = &text_cache[index];
+    e->renderer = renderer;
+    e->font = font;
+    e->font_size = font_size;
+    e->color = color;
+    strcpy(e->text, text);
+    e->texture = texture;
+    e->width = width;
+    e->height = height;
+    e->bucket_next = text_cache_buckets[bucket];
+    text_cache_buckets[bucket] = index;
+    lru_push_front(index);
+    return e;
 }
 
-void render_text(SDL_Renderer *renderer, TTF_Font *font,
-                 const char *text, float x, float y, SDL_Color color)
+void render_text_cache_clear(void)
+{
+    for (int i = 0; i < text_cache_count; ++i)
+        SDL_DestroyTexture(text_cache[i].texture);
+    text_cache_init();
+}
+
+// Uncached path for strings too long to key
+static void render_text_direct(SDL_Renderer *renderer, TTF_Font *font, const char *text,
+                               float x, float y, SDL_Color color, int center_x)
 {
     SDL_Surface *surface = TTF_RenderText_Blended(font, text, strlen(text), color);
 
@@ -45,7 +174,7 @@ void render_text(SDL_Renderer *renderer, TTF_Font *font,
             SDL_FRect dest_rect;
             dest_rect.w = (float)surface->w;
             dest_rect.h = (float)surface->h;
-            dest_rect.x = x;
+            dest_rect.x = center_x ? x - dest_rect.w / 2.0f : x;
             dest_rect.y = y;
 
             SDL_RenderTexture(renderer, texture, NULL, &dest_rect);
@@ -54,4 +183,42 @@ void render_text(SDL_Renderer *renderer, TTF_Font *font,
 
         SDL_DestroySurface(surface);
     }
-}
\ No newline at end of file
+}
+
+static void render_text_at(SDL_Renderer *renderer, TTF_Font *font, const char *text,
+                           float x, float y, SDL_Color color, int center_x)
+{
+    if (!renderer || !font || !text || !*text)
+        return;
+    if (strlen(text) >= TEXT_CACHE_MAX_TEXT)
+    {
+        render_text_direct(renderer, font, text, x, y, color, center_x);
+        return;
+    }
+    TextCacheEntry *e = text_cache_get(renderer, font, text, color);
+    if (!e)
+        return;
+    SDL_FRect dest_rect;
+    dest_rect.w = e->width;
+    dest_rect.h = e->height;
+    dest_rect.x = center_x ? x - dest_rect.w / 2.0f : x;
+    dest_rect.y = y;
+    SDL_RenderTexture(renderer, e->texture, NULL, &dest_rect);
+}
+
+void render_text_centered(SDL_Renderer *renderer, TTF_Font *font,
+                          const char *text, float y, SDL_Color color)
+{
+    // Get actual window size
+    int window_w, window_h;
+    SDL_Window *window = SDL_GetRenderWindow(renderer);
+    SDL_GetWindowSizeInPixels(window, &window_w, &window_h);
+
+    render_text_at(renderer, font, text, (float)window_w / 2.0f, y, color, 1);
+}
+
+void render_text(SDL_Renderer *renderer, TTF_Font *font,
+                 const char *text, float x, float y, SDL_Color color)
+{
+    render_text_at(renderer, font, text, x, y, color, 0);
+}
@@ -4,10 +4,16 @@
 #include <SDL3/SDL.h>
 #include <SDL3_ttf/SDL_ttf.h>
 
+// Text is rasterized once per (renderer, font, size, colour, string) and the texture
+// is kept in a small LRU cache, so repeated labels cost one textured quad per frame.
+
 void render_text_centered(SDL_Renderer *renderer, TTF_Font *font,
                           const char *text, float y, SDL_Color color);
 
 void render_text(SDL_Renderer *renderer, TTF_Font *font,
                  const char *text, float x, float y, SDL_Color color);
 
-#endif
\ No newline at end of file
+// Destroy every cached text texture (call before the renderer or fonts go away)
+void render_text_cache_clear(void);
+
+#endif
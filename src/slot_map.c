@@ -0,0 +1,108 @@
+#include <stdlib.h>
+#include <string.h>
+#include "slot_map.h"
+
+#define SLOT_MAP_NO_SLOT UINT32_MAX
+
+void slot_map_init(struct SlotMap *map)
+{
+    memset(map, 0, sizeof(*map));
+    map->free_head = SLOT_MAP_NO_SLOT;
+}
+
+void slot_map_free(struct SlotMap *map)
+{
+    free(map->slot_index);
+    free(map->slot_generation);
+    free(map->dense_slot);
+    slot_map_init(map);
+}
+
+static uint32_t next_generation(uint32_t generation)
+{
+    return generation == UINT32_MAX ? 1 : generation + 1;
+}
+
+void slot_map_clear(struct SlotMap *map)
+{
+    // Retire the live slots' generations and put every slot back on the free list
+    for (size_t i = 0; i < map->count; ++i)
+    {
+        uint32_t slot = map->dense_slot[i];
+        map->slot_generation[slot] = next_generation(map->slot_generation[slot]);
+    }
+    map->free_head = SLOT_MAP_NO_SLOT;
+    for (size_t slot = map->slot_count; slot-- > 0;)
+    {
+        map->slot_index[slot] = map->free_head;
+        map->free_head = (uint32_t)slot;
+    }
+    map->count = 0;
+}
+
+SlotHandle slot_map_insert(struct SlotMap *map)
+{
+    uint32_t slot = map->free_head;
+    if (slot == SLOT_MAP_NO_SLOT)
+    {
+        if (map->slot_count >= SLOT_MAP_NO_SLOT)
+            return SLOT_NONE;
+        if (map->slot_count == map->capacity)
+        {
+            size_t new_capacity = map->capacity == 0 ? 64 : map->capacity * 2;
+            uint32_t *slot_index = realloc(map->slot_index, new_capacity * sizeof(uint32_t));
+            if (!slot_index)
+                return SLOT_NONE;
+            map->slot_index = slot_index;
+            uint32_t *slot_generation = realloc(map->slot_generation, new_capacity * sizeof(uint32_t));
+            if (!slot_generation)
+                return SLOT_NONE;
+            map->slot_generation = slot_generation;
+            uint32_t *dense_slot = realloc(map->dense_slot, new_capacity * sizeof(uint32_t));
+            if (!dense_slot)
+                return SLOT_NONE;
+            map->dense_slot = dense_slot;
+            map->capacity = new_capacity;
+        }
+        slot = (uint32_t)map->slot_count++;
+        map->slot_generation[slot] = 1;
+    }
+    else
+    {
+        map->free_head = map->slot_index[slot];
+    }
+    map->slot_index[slot] = (uint32_t)map->count;
+    map->dense_slot[map->count++] = slot;
+    return ((SlotHandle)map->slot_generation[slot] << 32) | slot;
+}
+
+SlotHandle slot_map_handle(const struct SlotMap *map, size_t index)
+{
+    uint32_t slot = map->dense_slot[index];
+    return ((SlotHandle)map->slot_generation[slot] << 32) | slot;
+}
+
+size_t slot_map_index(const struct SlotMap *map, SlotHandle handle)
+{
+    uint32_t slot = (uint32_t)handle;
+    if (slot >= map->slot_count || map->slot_generation[slot] != (uint32_t)(handle >> 32))
+        return SLOT_MAP_NO_INDEX;
+    // A free slot's generation is already the next one, so it never matches a handle
+    return map->slot_index[slot];
+}
+
+size_t slot_map_remove(struct SlotMap *map, size_t index)
+{
+    uint32_t slot = map->dense_slot[index];
+    size_t last = --map->count;
+    if (index != last)
+    {
+        uint32_t moved = map->dense_slot[last];
+        map->dense_slot[index] = moved;
+        map->slot_index[moved] = (uint32_t)index;
+    }
+    map->slot_generation[slot] = next_generation(map->slot_generation[slot]);
+    map->slot_index[slot] = map->free_head;
+    map->free_head = slot;
+    return last;
+}
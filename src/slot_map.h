@@ -0,0 +1,52 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Stable handles for objects kept in a dense array. The caller owns the array; the
+// slot map only tracks which handle lives at which index.
+//
+// A handle is a slot number and the slot's generation. Removing an object moves the
+// last one into its place (swap-remove, O(1)) and bumps the generation of the freed
+// slot, so every handle to the removed object stops resolving instead of pointing at
+// whatever takes its index. Handles to the moved object keep working.
+
+typedef uint64_t SlotHandle;
+
+#define SLOT_NONE ((SlotHandle)0) // Never a live handle
+#define SLOT_MAP_NO_INDEX SIZE_MAX
+
+struct SlotMap
+{
+    uint32_t *slot_index;      // Per slot: dense index while live, next free slot while free
+    uint32_t *slot_generation; // Per slot: generation of its current (or next) handle, never 0
+    uint32_t *dense_slot;      // Per dense index: slot of the object there
+    size_t count;              // Objects, i.e. used dense indices
+    size_t slot_count;
+    size_t capacity; // Of all three arrays
+    uint32_t free_head; // First free slot, UINT32_MAX if none
+};
+
+void slot_map_init(struct SlotMap *map);
+void slot_map_free(struct SlotMap *map);
+
+// Remove every object; all handles stop resolving
+void slot_map_clear(struct SlotMap *map);
+
+// Register the object the caller appends at dense index count. Returns its handle,
+// SLOT_NONE on allocation failure (nothing was registered).
+SlotHandle slot_map_insert(struct SlotMap *map);
+
+// Handle of the object at a dense index (index < count)
+SlotHandle slot_map_handle(const struct SlotMap *map, size_t index);
+
+// Dense index of a handle, SLOT_MAP_NO_INDEX if it is SLOT_NONE or its object is gone
+size_t slot_map_index(const struct SlotMap *map, SlotHandle handle);
+
+// Remove the object at a dense index. The last object moves into its place: returns
+// the index it moved from, which the caller copies to index in its own arrays (equal
+// to index when the removed object was the last one).
+size_t slot_map_remove(struct SlotMap *map, size_t index);
+
+#endif // SLOT_MAP_H
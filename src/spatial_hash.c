@@ -0,0 +1,265 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "spatial_hash.h"
+
+static size_t cell_hash(int32_t cx, int32_t cy, size_t mask)
+{
+    uint32_t key = (uint32_t)cx * 73856093u ^ (uint32_t)cy * 19349663u;
+    key ^= key >> 15;
+    key *= 0x2C1B3C6Du;
+    key ^= key >> 12;
+    return (size_t)key & mask;
+}
+
+static int32_t cell_coord(float value, float cell_size)
+{
+    return (int32_t)floorf(value / cell_size);
+}
+
+void spatial_hash_init(struct SpatialHash *hash, float cell_width, float cell_height)
+{
+    memset(hash, 0, sizeof(*hash));
+    hash->cell_width = cell_width > 0.0f ? cell_width : 1.0f;
+    hash->cell_height = cell_height > 0.0f ? cell_height : 1.0f;
+}
+
+void spatial_hash_free(struct SpatialHash *hash)
+{
+    for (size_t i = 0; i < hash->table_size; ++i)
+        free(hash->cells[i].items);
+    free(hash->cells);
+    free(hash->results);
+    free(hash->item_stamp);
+    spatial_hash_init(hash, hash->cell_width, hash->cell_height);
+}
+
+void spatial_hash_clear(struct SpatialHash *hash)
+{
+    for (size_t i = 0; i < hash->table_size; ++i)
+        hash->cells[i].count = 0;
+}
+
+static struct SpatialHashCell *find_cell(const struct SpatialHash *hash, int32_t cx, int32_t cy)
+{
+    if (hash->table_size == 0)
+        return NULL;
+    size_t mask = hash->table_size - 1;
+    for (size_t slot = cell_hash(cx, cy, mask);; slot = (slot + 1) & mask)
+    {
+        struct SpatialHashCell *cell = &hash->cells[slot];
+        if (!cell->used)
+            return NULL;
+        if (cell->cx == cx && cell->cy == cy)
+            return cell;
+    }
+}
+
+static int grow_table(struct SpatialHash *hash)
+{
+    size_t new_size = hash->table_size == 0 ? 64 : hash->table_size * 2;
+    struct SpatialHashCell *cells = calloc(new_size, sizeof(struct SpatialHashCell));
+    if (!cells)
+        return 0;
+    size_t mask = new_size - 1;
+    for (size_t i = 0; i < hash->table_size; ++i)
+    {
+        struct SpatialHashCell *old = &hash->cells[i];
+        if (!old->used)
+            continue;
+        size_t slot = cell_hash(old->cx, old->cy, mask);
+        while (cells[slot].used)
+            slot = (slot + 1) & mask;
+        cells[slot] = *old;
+    }
+    free(hash->cells);
+    hash->cells = cells;
+    hash->table_size = new_size;
+    return 1;
+}
+
+static struct SpatialHashCell *find_or_add_cell(struct SpatialHash *hash, int32_t cx, int32_t cy)
+{
+    struct SpatialHashCell *cell = find_cell(hash, cx, cy);
+    if (cell)
+        return cell;
+    // Keep the load factor at or below one half
+    if ((hash->used_cells + 1) * 2 > hash->table_size && !grow_table(hash))
+        return NULL;
+    size_t mask = hash->table_size - 1;
+    size_t slot = cell_hash(cx, cy, mask);
+    while (hash->cells[slot].used)
+        slot = (slot + 1) & mask;
+    cell = &hash->cells[slot];
+    cell->cx = cx;
+    cell->cy = cy;
+    cell->used = 1;
+    hash->used_cells++;
+    return cell;
+}
+
+static int ensure_stamp_capacity(struct SpatialHash *hash, uint32_t id)
+{
+    if (id < hash->stamp_capacity)
+        return 1;
+    size_t new_capacity = hash->stamp_capacity == 0 ? 64 : hash->stamp_capacity;
+    while (new_capacity <= id)
+        new_capacity *= 2;
+    uint32_t *stamps = realloc(hash->item_stamp, new_capacity * sizeof(uint32_t));
+    if (!stamps)
+        return 0;
+    memset(stamps + hash->stamp_capacity, 0, (new_capacity - hash->stamp_capacity) * sizeof(uint32_t));
+    hash->item_stamp = stamps;
+    hash->stamp_capacity = new_capacity;
+    return 1;
+}
+
+int spatial_hash_insert(struct SpatialHash *hash, uint32_t id,
+                        float min_x, float min_y, float max_x, float max_y)
+{
+    if (!ensure_stamp_capacity(hash, id))
+        return 0;
+    int32_t x0 = cell_coord(min_x, hash->cell_width), x1 = cell_coord(max_x, hash->cell_width);
+    int32_t y0 = cell_coord(min_y, hash->cell_height), y1 = cell_coord(max_y, hash->cell_height);
+    for (int32_t cy = y0; cy <= y1; ++cy)
+    {
+        for (int32_t cx = x0; cx <= x1; ++cx)
+        {
+            struct SpatialHashCell *cell = find_or_add_cell(hash, cx, cy);
+            if (!cell)
+                return 0;
+            if (cell->count >= cell->capacity)
+            {
+                uint32_t new_capacity = cell->capacity == 0 ? 4 : cell->capacity * 2;
+                uint32_t *items = realloc(cell->items, new_capacity * sizeof(uint32_t));
+                if (!items)
+                    return 0;
+                cell->items = items;
+                cell->capacity = new_capacity;
+            }
+            cell->items[cell->count++] = id;
+        }
+    }
+    return 1;
+}
+
+void spatial_hash_remove(struct SpatialHash *hash, uint32_t id,
+                         float min_x, float min_y, float max_x, float max_y)
+{
+    int32_t x0 = cell_coord(min_x, hash->cell_width), x1 = cell_coord(max_x, hash->cell_width);
+    int32_t y0 = cell_coord(min_y, hash->cell_height), y1 = cell_coord(max_y, hash->cell_height);
+    for (int32_t cy = y0; cy <= y1; ++cy)
+    {
+        for (int32_t cx = x0; cx <= x1; ++cx)
+        {
+            struct SpatialHashCell *cell = find_cell(hash, cx, cy);
+            if (!cell)
+                continue;
+            // One occurrence per insert; an item inserted with several boxes
+            // (e.g. wire segments) is removed with the same boxes
+            for (uint32_t i = 0; i < cell->count; ++i)
+            {
+                if (cell->items[i] == id)
+                {
+                    cell->items[i] = cell->items[--cell->count];
+                    break;
+                }
+            }
+        }
+    }
+}
+
+int spatial_hash_relocate(struct SpatialHash *hash, uint32_t old_id, uint32_t new_id,
+                          float min_x, float min_y, float max_x, float max_y)
+{
+    if (!ensure_stamp_capacity(hash, new_id))
+        return 0;
+    int32_t x0 = cell_coord(min_x, hash->cell_width), x1 = cell_coord(max_x, hash->cell_width);
+    int32_t y0 = cell_coord(min_y, hash->cell_height), y1 = cell_coord(max_y, hash->cell_height);
+    for (int32_t cy = y0; cy <= y1; ++cy)
+    {
+        for (int32_t cx = x0; cx <= x1; ++cx)
+        {
+            struct SpatialHashCell *cell = find_cell(hash, cx, cy);
+            if (!cell)
+                continue;
+            for (uint32_t i = 0; i < cell->count; ++i)
+            {
+                if (cell->items[i] == old_id)
+                {
+                    cell->items[i] = new_id;
+                    break;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+// Append the cell's items not yet seen by this query; returns 0 on allocation failure
+static int collect_cell(struct SpatialHash *hash, const struct SpatialHashCell *cell, size_t *found)
+{
+    for (uint32_t i = 0; i < cell->count; ++i)
+    {
+        uint32_t id = cell->items[i];
+        if (hash->item_stamp[id] == hash->query_stamp)
+            continue;
+        hash->item_stamp[id] = hash->query_stamp;
+        if (*found >= hash->result_capacity)
+        {
+            size_t new_capacity = hash->result_capacity == 0 ? 64 : hash->result_capacity * 2;
+            uint32_t *results = realloc(hash->results, new_capacity * sizeof(uint32_t));
+            if (!results)
+                return 0;
+            hash->results = results;
+            hash->result_capacity = new_capacity;
+        }
+        hash->results[(*found)++] = id;
+    }
+    return 1;
+}
+
+size_t spatial_hash_query(struct SpatialHash *hash, float min_x, float min_y, float max_x, float max_y,
+                          const uint32_t **out_ids)
+{
+    *out_ids = hash->results;
+    if (hash->used_cells == 0)
+        return 0;
+    if (++hash->query_stamp == 0)
+    {
+        // Stamp counter wrapped: forget every old stamp
+        memset(hash->item_stamp, 0, hash->stamp_capacity * sizeof(uint32_t));
+        hash->query_stamp = 1;
+    }
+
+    size_t found = 0;
+    int32_t x0 = cell_coord(min_x, hash->cell_width), x1 = cell_coord(max_x, hash->cell_width);
+    int32_t y0 = cell_coord(min_y, hash->cell_height), y1 = cell_coord(max_y, hash->cell_height);
+    uint64_t span = (uint64_t)((int64_t)x1 - x0 + 1) * (uint64_t)((int64_t)y1 - y0 + 1);
+    if (span > hash->table_size)
+    {
+        // Box covers more cells than exist (e.g. zoomed far out): walk the table instead
+        for (size_t i = 0; i < hash->table_size; ++i)
+        {
+            const struct SpatialHashCell *cell = &hash->cells[i];
+            if (cell->used && cell->cx >= x0 && cell->cx <= x1 && cell->cy >= y0 && cell->cy <= y1 &&
+                !collect_cell(hash, cell, &found))
+                break;
+        }
+    }
+    else
+    {
+        int ok = 1;
+        for (int32_t cy = y0; cy <= y1 && ok; ++cy)
+        {
+            for (int32_t cx = x0; cx <= x1 && ok; ++cx)
+            {
+                const struct SpatialHashCell *cell = find_cell(hash, cx, cy);
+                if (cell)
+                    ok = collect_cell(hash, cell, &found);
+            }
+        }
+    }
+    *out_ids = hash->results;
+    return found;
+}
@@ -0,0 +1,60 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Uniform grid over world space, hashed so only occupied cells cost memory.
+// Items are identified by a caller-chosen index and registered with an axis-aligned
+// bounding box; they appear in every cell the box overlaps. Queries return each
+// item at most once, so a lookup costs O(items in the cells it touches).
+struct SpatialHashCell
+{
+    int32_t cx, cy;
+    uint32_t *items;
+    uint32_t count;
+    uint32_t capacity;
+    int used; // Slot holds a cell (cells are never removed, only emptied)
+};
+
+struct SpatialHash
+{
+    float cell_width;
+    float cell_height;
+
+    // Open addressing, power-of-two size
+    struct SpatialHashCell *cells;
+    size_t table_size;
+    size_t used_cells;
+
+    // Query results and per-item stamps for de-duplication
+    uint32_t *results;
+    size_t result_capacity;
+    uint32_t *item_stamp;
+    size_t stamp_capacity;
+    uint32_t query_stamp;
+};
+
+void spatial_hash_init(struct SpatialHash *hash, float cell_width, float cell_height);
+void spatial_hash_free(struct SpatialHash *hash);
+// Drop every item but keep the cell size
+void spatial_hash_clear(struct SpatialHash *hash);
+
+// Register item id over the box. Returns 0 on allocation failure.
+int spatial_hash_insert(struct SpatialHash *hash, uint32_t id,
+                        float min_x, float min_y, float max_x, float max_y);
+// Unregister item id; the box must cover the cells it was inserted with
+void spatial_hash_remove(struct SpatialHash *hash, uint32_t id,
+                         float min_x, float min_y, float max_x, float max_y);
+// Rename item old_id to new_id in the cells of the box (the box rules of
+// spatial_hash_remove apply), e.g. after the caller moved the item within its array.
+// new_id must not be registered. Returns 0 on allocation failure.
+int spatial_hash_relocate(struct SpatialHash *hash, uint32_t old_id, uint32_t new_id,
+                          float min_x, float min_y, float max_x, float max_y);
+
+// Items whose cells overlap the box, in no particular order. The returned array
+// belongs to the hash and stays valid until the next query or modification.
+size_t spatial_hash_query(struct SpatialHash *hash, float min_x, float min_y, float max_x, float max_y,
+                          const uint32_t **out_ids);
+
+#endif // SPATIAL_HASH_H
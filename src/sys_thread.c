@@ -0,0 +1,150 @@
+#include <stdlib.h>
+#include "sys_thread.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// Heap-allocated trampoline so both platforms can use the same entry signature
+struct SysThreadStart
+{
+    void (*entry)(void *arg);
+    void *arg;
+};
+
+#ifdef _WIN32
+
+static DWORD WINAPI sys_thread_trampoline(LPVOID param)
+{
+    struct SysThreadStart start = *(struct SysThreadStart *)param;
+    free(param);
+    start.entry(start.arg);
+    return 0;
+}
+
+int sys_thread_create(SysThread *thread, void (*entry)(void *arg), void *arg)
+{
+    struct SysThreadStart *start = malloc(sizeof(struct SysThreadStart));
+    if (!start)
+        return 0;
+    start->entry = entry;
+    start->arg = arg;
+    *thread = CreateThread(NULL, 0, sys_thread_trampoline, start, 0, NULL);
+    if (!*thread)
+    {
+        free(start);
+        return 0;
+    }
+    return 1;
+}
+
+void sys_thread_join(SysThread thread)
+{
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+void sys_mutex_init(SysMutex *mutex) { InitializeCriticalSection(mutex); }
+void sys_mutex_destroy(SysMutex *mutex) { DeleteCriticalSection(mutex); }
+void sys_mutex_lock(SysMutex *mutex) { EnterCriticalSection(mutex); }
+void sys_mutex_unlock(SysMutex *mutex) { LeaveCriticalSection(mutex); }
+
+void sys_cond_init(SysCond *cond) { InitializeConditionVariable(cond); }
+void sys_cond_destroy(SysCond *cond) { (void)cond; }
+void sys_cond_wait(SysCond *cond, SysMutex *mutex) { SleepConditionVariableCS(cond, mutex, INFINITE); }
+void sys_cond_signal(SysCond *cond) { WakeConditionVariable(cond); }
+void sys_cond_broadcast(SysCond *cond) { WakeAllConditionVariable(cond); }
+
+size_t sys_atomic_fetch_add(volatile size_t *value, size_t delta)
+{
+#ifdef _WIN64
+    return (size_t)InterlockedExchangeAdd64((volatile LONG64 *)value, (LONG64)delta);
+#else
+    return (size_t)InterlockedExchangeAdd((volatile LONG *)value, (LONG)delta);
+#endif
+}
+
+size_t sys_atomic_load(volatile size_t *value)
+{
+    return sys_atomic_fetch_add(value, 0);
+}
+
+void sys_atomic_store(volatile size_t *value, size_t new_value)
+{
+#ifdef _WIN64
+    InterlockedExchange64((volatile LONG64 *)value, (LONG64)new_value);
+#else
+    InterlockedExchange((volatile LONG *)value, (LONG)new_value);
+#endif
+}
+
+int sys_cpu_count(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+#else
+
+static void *sys_thread_trampoline(void *param)
+{
+    struct SysThreadStart start = *(struct SysThreadStart *)param;
+    free(param);
+    start.entry(start.arg);
+    return NULL;
+}
+
+int sys_thread_create(SysThread *thread, void (*entry)(void *arg), void *arg)
+{
+    struct SysThreadStart *start = malloc(sizeof(struct SysThreadStart));
+    if (!start)
+        return 0;
+    start->entry = entry;
+    start->arg = arg;
+    if (pthread_create(thread, NULL, sys_thread_trampoline, start) != 0)
+    {
+        free(start);
+        return 0;
+    }
+    return 1;
+}
+
+void sys_thread_join(SysThread thread)
+{
+    pthread_join(thread, NULL);
+}
+
+void sys_mutex_init(SysMutex *mutex) { pthread_mutex_init(mutex, NULL); }
+void sys_mutex_destroy(SysMutex *mutex) { pthread_mutex_destroy(mutex); }
+void sys_mutex_lock(SysMutex *mutex) { pthread_mutex_lock(mutex); }
+void sys_mutex_unlock(SysMutex *mutex) { pthread_mutex_unlock(mutex); }
+
+void sys_cond_init(SysCond *cond) { pthread_cond_init(cond, NULL); }
+void sys_cond_destroy(SysCond *cond) { pthread_cond_destroy(cond); }
+void sys_cond_wait(SysCond *cond, SysMutex *mutex) { pthread_cond_wait(cond, mutex); }
+void sys_cond_signal(SysCond *cond) { pthread_cond_signal(cond); }
+void sys_cond_broadcast(SysCond *cond) { pthread_cond_broadcast(cond); }
+
+size_t sys_atomic_fetch_add(volatile size_t *value, size_t delta)
+{
+    return __atomic_fetch_add(value, delta, __ATOMIC_SEQ_CST);
+}
+
+size_t sys_atomic_load(volatile size_t *value)
+{
+    return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+}
+
+void sys_atomic_store(volatile size_t *value, size_t new_value)
+{
+    __atomic_store_n(value, new_value, __ATOMIC_SEQ_CST);
+}
+
+int sys_cpu_count(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef SYS_THREAD_H
+#define SYS_THREAD_H
+
+#include <stddef.h>
+
+// Thin portability layer over Win32 and POSIX threads, kept free of SDL so the
+// simulation core can run without it.
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+typedef HANDLE SysThread;
+typedef CRITICAL_SECTION SysMutex;
+typedef CONDITION_VARIABLE SysCond;
+#else
+#include <pthread.h>
+typedef pthread_t SysThread;
+typedef pthread_mutex_t SysMutex;
+typedef pthread_cond_t SysCond;
+#endif
+
+// Returns 0 on failure
+int sys_thread_create(SysThread *thread, void (*entry)(void *arg), void *arg);
+void sys_thread_join(SysThread thread);
+
+void sys_mutex_init(SysMutex *mutex);
+void sys_mutex_destroy(SysMutex *mutex);
+void sys_mutex_lock(SysMutex *mutex);
+void sys_mutex_unlock(SysMutex *mutex);
+
+void sys_cond_init(SysCond *cond);
+void sys_cond_destroy(SysCond *cond);
+void sys_cond_wait(SysCond *cond, SysMutex *mutex);
+void sys_cond_signal(SysCond *cond);
+void sys_cond_broadcast(SysCond *cond);
+
+// Sequentially consistent atomics on size_t counters
+size_t sys_atomic_fetch_add(volatile size_t *value, size_t delta);
+size_t sys_atomic_load(volatile size_t *value);
+void sys_atomic_store(volatile size_t *value, size_t new_value);
+
+// Number of logical processors (at least 1)
+int sys_cpu_count(void);
+
+#endif // SYS_THREAD_H
@@ -0,0 +1,192 @@
+#include <stdlib.h>
+#include "thread_pool.h"
+#include "sys_thread.h"
+
+// Chunk range owned by one participant. Owner and thieves claim chunks with the
+// same atomic counter; padding keeps neighbouring counters off the same cache line.
+struct ThreadPoolShare
+{
+    volatile size_t next;
+    size_t end;
+    char padding[64 - 2 * sizeof(size_t)];
+};
+
+struct ThreadPoolWorker
+{
+    ThreadPool *pool;
+    int id;
+    SysThread thread;
+};
+
+struct ThreadPool
+{
+    int participants; // Workers + the calling thread
+    struct ThreadPoolWorker *workers;
+    struct ThreadPoolShare *shares;
+
+    SysMutex lock;
+    SysCond work_ready;
+    SysCond work_done;
+    size_t generation; // Bumped for every parallel_for
+    int busy_workers;
+    int shutting_down;
+
+    // Current loop
+    ThreadPoolTask task;
+    void *ctx;
+    size_t item_count;
+    size_t chunk_size;
+};
+
+static void thread_pool_run_chunk(ThreadPool *pool, size_t chunk)
+{
+    size_t begin = chunk * pool->chunk_size;
+    size_t end = begin + pool->chunk_size;
+    if (end > pool->item_count)
+        end = pool->item_count;
+    pool->task(pool->ctx, begin, end);
+}
+
+static void thread_pool_participate(ThreadPool *pool, int id)
+{
+    // Own share first, then steal from the others in ring order
+    for (int k = 0; k < pool->participants; ++k)
+    {
+        struct ThreadPoolShare *share = &pool->shares[(id + k) % pool->participants];
+        for (;;)
+        {
+            size_t chunk = sys_atomic_fetch_add(&share->next, 1);
+            if (chunk >= share->end)
+                break;
+            thread_pool_run_chunk(pool, chunk);
+        }
+    }
+}
+
+static void thread_pool_worker_main(void *arg)
+{
+    struct ThreadPoolWorker *worker = arg;
+    ThreadPool *pool = worker->pool;
+    size_t seen_generation = 0;
+
+    sys_mutex_lock(&pool->lock);
+    for (;;)
+    {
+        while (!pool->shutting_down && pool->generation == seen_generation)
+            sys_cond_wait(&pool->work_ready, &pool->lock);
+        if (pool->shutting_down)
+            break;
+        seen_generation = pool->generation;
+        sys_mutex_unlock(&pool->lock);
+
+        thread_pool_participate(pool, worker->id);
+
+        sys_mutex_lock(&pool->lock);
+        if (--pool->busy_workers == 0)
+            sys_cond_signal(&pool->work_done);
+    }
+    sys_mutex_unlock(&pool->lock);
+}
+
+ThreadPool *thread_pool_create(int thread_count)
+{
+    if (thread_count <= 0)
+        thread_count = sys_cpu_count();
+
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    if (!pool)
+        return NULL;
+    pool->shares = calloc((size_t)thread_count, sizeof(struct ThreadPoolShare));
+    pool->workers = calloc((size_t)thread_count, sizeof(struct ThreadPoolWorker));
+    if (!pool->shares || !pool->workers)
+    {
+        free(pool->shares);
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+    sys_mutex_init(&pool->lock);
+    sys_cond_init(&pool->work_ready);
+    sys_cond_init(&pool->work_done);
+
+    // Participant 0 is the thread calling parallel_for
+    pool->participants = 1;
+    for (int i = 1; i < thread_count; ++i)
+    {
+        struct ThreadPoolWorker *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->id = i;
+        if (!sys_thread_create(&worker->thread, thread_pool_worker_main, worker))
+            break;
+        pool->participants++;
+    }
+    return pool;
+}
+
+void thread_pool_destroy(ThreadPool *pool)
+{
+    if (!pool)
+        return;
+    sys_mutex_lock(&pool->lock);
+    pool->shutting_down = 1;
+    sys_cond_broadcast(&pool->work_ready);
+    sys_mutex_unlock(&pool->lock);
+    for (int i = 1; i < pool->participants; ++i)
+        sys_thread_join(pool->workers[i].thread);
+
+    sys_cond_destroy(&pool->work_done);
+    sys_cond_destroy(&pool->work_ready);
+    sys_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool->shares);
+    free(pool);
+}
+
+int thread_pool_size(const ThreadPool *pool)
+{
+    return pool ? pool->participants : 1;
+}
+
+void thread_pool_parallel_for(ThreadPool *pool, size_t item_count, size_t chunk_size,
+                              ThreadPoolTask task, void *ctx)
+{
+    if (item_count == 0)
+        return;
+    if (chunk_size == 0)
+        chunk_size = 1;
+    size_t chunk_count = (item_count + chunk_size - 1) / chunk_size;
+    if (!pool || pool->participants == 1 || chunk_count == 1)
+    {
+        task(ctx, 0, item_count);
+        return;
+    }
+
+    pool->task = task;
+    pool->ctx = ctx;
+    pool->item_count = item_count;
+    pool->chunk_size = chunk_size;
+
+    // Deal the chunks out in contiguous shares
+    size_t participants = (size_t)pool->participants;
+    size_t first = 0;
+    for (size_t p = 0; p < participants; ++p)
+    {
+        size_t count = chunk_count / participants + (p < chunk_count % participants ? 1 : 0);
+        pool->shares[p].end = first + count;
+        sys_atomic_store(&pool->shares[p].next, first);
+        first += count;
+    }
+
+    sys_mutex_lock(&pool->lock);
+    pool->busy_workers = pool->participants - 1;
+    pool->generation++;
+    sys_cond_broadcast(&pool->work_ready);
+    sys_mutex_unlock(&pool->lock);
+
+    thread_pool_participate(pool, 0);
+
+    sys_mutex_lock(&pool->lock);
+    while (pool->busy_workers > 0)
+        sys_cond_wait(&pool->work_done, &pool->lock);
+    sys_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,26 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+
+// Fixed-size pool of worker threads for data-parallel loops.
+// thread_pool_parallel_for splits a range into chunks and deals them out evenly;
+// each participant works through its own share first and then steals chunks from
+// the others, so uneven chunk costs still balance out. The call returns once every
+// chunk has finished, which makes it a barrier between consecutive loops.
+typedef struct ThreadPool ThreadPool;
+
+typedef void (*ThreadPoolTask)(void *ctx, size_t begin, size_t end);
+
+// thread_count = total participants including the calling thread (0 = one per CPU)
+ThreadPool *thread_pool_create(int thread_count);
+void thread_pool_destroy(ThreadPool *pool);
+
+// Participants including the caller
+int thread_pool_size(const ThreadPool *pool);
+
+// Run task over [0, item_count) in chunks of chunk_size items; the calling thread helps
+void thread_pool_parallel_for(ThreadPool *pool, size_t item_count, size_t chunk_size,
+                              ThreadPoolTask task, void *ctx);
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,442 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vlg_file.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define VLG_BYTE_ORDER_MARK 0x01020304u
+#define VLG_ALIGN 8
+
+// Section as seen by the writer
+struct VlgOutSection
+{
+    uint32_t id;
+    uint32_t elem_size;
+    const void *data;
+    uint64_t count;
+    int from_size_t; // data is size_t[], written as uint64_t
+};
+
+static int write_padding(FILE *f, uint64_t *pos)
+{
+    static const char zeros[VLG_ALIGN] = {0};
+    size_t pad = (size_t)((VLG_ALIGN - *pos % VLG_ALIGN) % VLG_ALIGN);
+    if (pad && fwrite(zeros, 1, pad, f) != pad)
+        return 0;
+    *pos += pad;
+    return 1;
+}
+
+static int write_section_data(FILE *f, const struct VlgOutSection *s)
+{
+    if (s->count == 0)
+        return 1;
+    if (s->from_size_t && sizeof(size_t) != sizeof(uint64_t))
+    {
+        const size_t *values = s->data;
+        for (uint64_t i = 0; i < s->count; ++i)
+        {
+            uint64_t v = values[i];
+            if (fwrite(&v, sizeof(v), 1, f) != 1)
+                return 0;
+        }
+        return 1;
+    }
+    return fwrite(s->data, s->elem_size, (size_t)s->count, f) == (size_t)s->count;
+}
+
+int vlg_save(const char *path, const struct VlgDesign *design, const struct Netlist *nl)
+{
+    struct VlgNetlistInfo info = {0};
+    info.gate_count = nl->gate_count;
+    info.net_count = nl->net_count;
+    info.group_count = nl->group_count;
+    info.depth = nl->depth;
+    size_t depth = (size_t)(nl->depth > 0 ? nl->depth : 0);
+
+    struct VlgOutSection sections[] = {
+        {VLG_SECTION_NETLIST_INFO, sizeof(info), &info, 1, 0},
+        {VLG_SECTION_GATE_TYPE, sizeof(uint8_t), nl->gate_type, nl->gate_count, 0},
+        {VLG_SECTION_GATE_IN1, sizeof(uint32_t), nl->gate_in1, nl->gate_count, 0},
+        {VLG_SECTION_GATE_IN2, sizeof(uint32_t), nl->gate_in2, nl->gate_count, 0},
+        {VLG_SECTION_GATE_OUT, sizeof(uint32_t), nl->gate_out, nl->gate_count, 0},
+        {VLG_SECTION_GATE_CYCLIC, sizeof(uint8_t), nl->gate_cyclic, nl->gate_count, 0},
+        {VLG_SECTION_LEVEL_START, sizeof(uint64_t), nl->level_start, depth + 1, 1},
+        {VLG_SECTION_LEVEL_CYCLIC, sizeof(uint8_t), nl->level_cyclic, depth, 0},
+        {VLG_SECTION_GROUP_START, sizeof(uint64_t), nl->group_start, nl->group_count + 1, 1},
+        {VLG_SECTION_GROUP_TYPE, sizeof(uint8_t), nl->group_type, nl->group_count, 0},
+        {VLG_SECTION_GROUP_CONTIGUOUS, sizeof(uint8_t), nl->group_contiguous, nl->group_count, 0},
+        {VLG_SECTION_LEVEL_GROUP_START, sizeof(uint64_t), nl->level_group_start, depth + 1, 1},
+        {VLG_SECTION_NET_DRIVER, sizeof(uint32_t), nl->net_driver, nl->net_count, 0},
+        {VLG_SECTION_NET_STATE, sizeof(uint8_t), design->net_state, nl->net_count, 0},
+        {VLG_SECTION_INPUT_NETS, sizeof(uint32_t), design->input_nets, design->input_count, 0},
+        {VLG_SECTION_OUTPUT_NETS, sizeof(uint32_t), design->output_nets, design->output_count, 0},
+        {VLG_SECTION_EDITOR_GATES, sizeof(struct VlgGateRecord), design->gates, design->gate_count, 0},
+        {VLG_SECTION_EDITOR_WIRES, sizeof(struct VlgWireRecord), design->wires, design->wire_count, 0},
+        {VLG_SECTION_WIRE_POINTS, sizeof(struct VlgPoint), design->points, design->point_count, 0},
+        {VLG_SECTION_EDITOR_LAMPS, sizeof(struct VlgLampRecord), design->lamps, design->lamp_count, 0},
+    };
+    const uint32_t section_count = (uint32_t)(sizeof(sections) / sizeof(sections[0]));
+
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return 0;
+
+    struct VlgHeader header;
+    memcpy(header.magic, VLG_MAGIC, sizeof(header.magic));
+    header.version = VLG_VERSION;
+    header.byte_order = VLG_BYTE_ORDER_MARK;
+    header.section_count = section_count;
+
+    // Lay the sections out after the table
+    struct VlgSection table[VLG_SECTION_COUNT];
+    uint64_t pos = sizeof(header) + section_count * sizeof(struct VlgSection);
+    for (uint32_t i = 0; i < section_count; ++i)
+    {
+        pos = (pos + VLG_ALIGN - 1) / VLG_ALIGN * VLG_ALIGN;
+        table[i].id = sections[i].id;
+        table[i].elem_size = sections[i].elem_size;
+        table[i].offset = pos;
+        table[i].count = sections[i].count;
+        pos += sections[i].count * sections[i].elem_size;
+    }
+
+    int ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+             fwrite(table, sizeof(struct VlgSection), section_count, f) == section_count;
+    pos = sizeof(header) + section_count * sizeof(struct VlgSection);
+    for (uint32_t i = 0; i < section_count && ok; ++i)
+    {
+        ok = write_padding(f, &pos) && write_section_data(f, &sections[i]);
+        pos += sections[i].count * sections[i].elem_size;
+    }
+    // Trailing empty sections sit at the aligned end, so the file must reach it
+    if (ok)
+        ok = write_padding(f, &pos);
+    if (fclose(f) != 0)
+        ok = 0;
+    return ok;
+}
+
+static int map_file(struct VlgFile *file, const char *path)
+{
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+        return 0;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0 || (unsigned long long)size.QuadPart > (size_t)-1)
+    {
+        CloseHandle(handle);
+        return 0;
+    }
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping)
+    {
+        CloseHandle(handle);
+        return 0;
+    }
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        CloseHandle(mapping);
+        CloseHandle(handle);
+        return 0;
+    }
+    file->file_handle = handle;
+    file->mapping_handle = mapping;
+    file->data = data;
+    file->size = (size_t)size.QuadPart;
+    return 1;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || (unsigned long long)st.st_size > (size_t)-1)
+    {
+        close(fd);
+        return 0;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid
+    if (data == MAP_FAILED)
+        return 0;
+    file->data = data;
+    file->size = (size_t)st.st_size;
+    return 1;
+#endif
+}
+
+static void unmap_file(struct VlgFile *file)
+{
+    if (!file->data)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(file->data);
+    CloseHandle(file->mapping_handle);
+    CloseHandle(file->file_handle);
+#else
+    munmap(file->data, file->size);
+#endif
+    file->data = NULL;
+}
+
+// Pointer to a section's array if it exists with the expected element size and count
+static const void *section_data(const struct VlgFile *file, const struct VlgSection *table, uint32_t section_count,
+                                uint32_t id, uint32_t elem_size, uint64_t *out_count)
+{
+    for (uint32_t i = 0; i < section_count; ++i)
+    {
+        const struct VlgSection *s = &table[i];
+        if (s->id != id)
+            continue;
+        if (s->elem_size != elem_size || s->offset % VLG_ALIGN != 0 || s->offset > file->size)
+            return NULL;
+        if (s->count > (file->size - s->offset) / elem_size)
+            return NULL;
+        *out_count = s->count;
+        return (const char *)file->data + s->offset;
+    }
+    return NULL;
+}
+
+// Offsets must rise from 0 to last and stay within limit
+static int check_offsets(const uint64_t *values, uint64_t count, uint64_t last)
+{
+    if (count == 0 || values[0] != 0 || values[count - 1] != last)
+        return 0;
+    for (uint64_t i = 1; i < count; ++i)
+    {
+        if (values[i] < values[i - 1])
+            return 0;
+    }
+    return 1;
+}
+
+static int check_nets(const uint32_t *nets, uint64_t count, uint64_t net_count, int allow_none)
+{
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        if (nets[i] >= net_count && !(allow_none && nets[i] == VLG_NONE))
+            return 0;
+    }
+    return 1;
+}
+
+static int validate_and_bind(struct VlgFile *file)
+{
+    if (file->size < sizeof(struct VlgHeader))
+        return 0;
+    const struct VlgHeader *header = file->data;
+    if (memcmp(header->magic, VLG_MAGIC, sizeof(header->magic)) != 0 || header->version != VLG_VERSION ||
+        header->byte_order != VLG_BYTE_ORDER_MARK)
+        return 0;
+    uint32_t section_count = header->section_count;
+    if (section_count > (file->size - sizeof(*header)) / sizeof(struct VlgSection))
+        return 0;
+    const struct VlgSection *table = (const struct VlgSection *)(header + 1);
+
+    uint64_t count;
+    const struct VlgNetlistInfo *info = section_data(file, table, section_count, VLG_SECTION_NETLIST_INFO,
+                                                     sizeof(struct VlgNetlistInfo), &count);
+    if (!info || count != 1 || info->depth < 0 || info->net_count < NETLIST_FIRST_NET ||
+        info->net_count > VLG_NONE || info->gate_count > VLG_NONE)
+        return 0;
+    uint64_t gates = info->gate_count, nets = info->net_count, groups = info->group_count;
+    uint64_t depth = (uint64_t)info->depth;
+
+    struct Netlist *nl = &file->netlist;
+    struct VlgDesign *d = &file->design;
+    nl->borrowed = 1; // Set first: a half-bound netlist must not free mapped memory
+    const uint64_t *level_start, *group_start, *level_group_start;
+    uint64_t c[20];
+#define VLG_BIND(dst, id, type, expected, slot)                                               \
+    ((dst) = (type)section_data(file, table, section_count, (id), sizeof(*(dst)), &c[slot])) && \
+        c[slot] == (expected)
+    int ok = VLG_BIND(nl->gate_type, VLG_SECTION_GATE_TYPE, uint8_t *, gates, 0) &&
+             VLG_BIND(nl->gate_in1, VLG_SECTION_GATE_IN1, uint32_t *, gates, 1) &&
+             VLG_BIND(nl->gate_in2, VLG_SECTION_GATE_IN2, uint32_t *, gates, 2) &&
+             VLG_BIND(nl->gate_out, VLG_SECTION_GATE_OUT, uint32_t *, gates, 3) &&
+             VLG_BIND(nl->gate_cyclic, VLG_SECTION_GATE_CYCLIC, uint8_t *, gates, 4) &&
+             VLG_BIND(level_start, VLG_SECTION_LEVEL_START, const uint64_t *, depth + 1, 5) &&
+             VLG_BIND(nl->level_cyclic, VLG_SECTION_LEVEL_CYCLIC, uint8_t *, depth, 6) &&
+             VLG_BIND(group_start, VLG_SECTION_GROUP_START, const uint64_t *, groups + 1, 7) &&
+             VLG_BIND(nl->group_type, VLG_SECTION_GROUP_TYPE, uint8_t *, groups, 8) &&
+             VLG_BIND(nl->group_contiguous, VLG_SECTION_GROUP_CONTIGUOUS, uint8_t *, groups, 9) &&
+             VLG_BIND(level_group_start, VLG_SECTION_LEVEL_GROUP_START, const uint64_t *, depth + 1, 10) &&
+             VLG_BIND(nl->net_driver, VLG_SECTION_NET_DRIVER, uint32_t *, nets, 11) &&
+             VLG_BIND(d->net_state, VLG_SECTION_NET_STATE, const uint8_t *, nets, 12);
+    if (!ok)
+        return 0;
+    // Variable-length sections
+    ok = (d->input_nets = section_data(file, table, section_count, VLG_SECTION_INPUT_NETS, sizeof(uint32_t), &c[13])) != NULL &&
+         (d->output_nets = section_data(file, table, section_count, VLG_SECTION_OUTPUT_NETS, sizeof(uint32_t), &c[14])) != NULL &&
+         (d->gates = section_data(file, table, section_count, VLG_SECTION_EDITOR_GATES, sizeof(struct VlgGateRecord), &c[15])) != NULL &&
+         (d->wires = section_data(file, table, section_count, VLG_SECTION_EDITOR_WIRES, sizeof(struct VlgWireRecord), &c[16])) != NULL &&
+         (d->points = section_data(file, table, section_count, VLG_SECTION_WIRE_POINTS, sizeof(struct VlgPoint), &c[17])) != NULL &&
+         (d->lamps = section_data(file, table, section_count, VLG_SECTION_EDITOR_LAMPS, sizeof(struct VlgLampRecord), &c[18])) != NULL;
+#undef VLG_BIND
+    if (!ok)
+        return 0;
+    d->input_count = (size_t)c[13];
+    d->output_count = (size_t)c[14];
+    d->gate_count = (size_t)c[15];
+    d->wire_count = (size_t)c[16];
+    d->point_count = (size_t)c[17];
+    d->lamp_count = (size_t)c[18];
+
+    // Everything the simulation kernels index with must stay in range
+    if (!check_offsets(level_start, depth + 1, gates) || !check_offsets(group_start, groups + 1, gates) ||
+        !check_offsets(level_group_start, depth + 1, groups))
+        return 0;
+    for (uint64_t r = 0; r < depth; ++r)
+    {
+        if (group_start[level_group_start[r]] != level_start[r])
+            return 0;
+    }
+    if (!check_nets(nl->gate_in1, gates, nets, 0) || !check_nets(nl->gate_in2, gates, nets, 0) ||
+        !check_nets(nl->gate_out, gates, nets, 0) || !check_nets(d->input_nets, d->input_count, nets, 0) ||
+        !check_nets(d->output_nets, d->output_count, nets, 1))
+        return 0;
+    // A net's driver writes it, every gate output has a driver, and no gate writes the constant net
+    for (uint64_t n = 0; n < nets; ++n)
+    {
+        uint32_t driver = nl->net_driver[n];
+        if (driver != NETLIST_NO_NET && (driver >= gates || nl->gate_out[driver] != n))
+            return 0;
+    }
+    for (uint64_t i = 0; i < gates; ++i)
+    {
+        if (nl->gate_type[i] >= GATE_TYPE_COUNT || nl->gate_out[i] < NETLIST_FIRST_NET ||
+            nl->net_driver[nl->gate_out[i]] == NETLIST_NO_NET)
+            return 0;
+    }
+    // Outside feedback loops, gates read only nets settled by earlier ranks. Clocked
+    // gates sample their inputs at edges and may read any rank.
+    for (uint64_t r = 0; r < depth; ++r)
+    {
+        for (uint64_t i = level_start[r]; i < level_start[r + 1]; ++i)
+        {
+            if (nl->gate_cyclic[i] || gate_is_clocked((GateType)nl->gate_type[i]))
+                continue;
+            uint32_t inputs[2] = {nl->gate_in1[i], nl->gate_in2[i]};
+            for (int k = 0; k < 2; ++k)
+            {
+                uint32_t driver = nl->net_driver[inputs[k]];
+                if (driver != NETLIST_NO_NET && driver >= level_start[r])
+                    return 0;
+            }
+        }
+    }
+    // Groups share one type, and contiguous ones are stored as one wide write from their first output
+    for (uint64_t g = 0; g < groups; ++g)
+    {
+        uint64_t begin = group_start[g], end = group_start[g + 1];
+        for (uint64_t i = begin; i < end; ++i)
+        {
+            if (nl->gate_type[i] != nl->group_type[g] ||
+                (nl->group_contiguous[g] && nl->gate_out[i] != nl->gate_out[begin] + (i - begin)))
+                return 0;
+        }
+    }
+    // Stimulus may only drive nets no gate drives
+    for (size_t i = 0; i < d->input_count; ++i)
+    {
+        if (nl->net_driver[d->input_nets[i]] != NETLIST_NO_NET)
+            return 0;
+    }
+
+    // Editor records refer to each other by index
+    for (size_t i = 0; i < d->gate_count; ++i)
+    {
+        const struct VlgGateRecord *g = &d->gates[i];
+        if ((g->input1_wire != VLG_NONE && g->input1_wire >= d->wire_count) ||
+            (g->input2_wire != VLG_NONE && g->input2_wire >= d->wire_count) ||
+            (g->output_wire != VLG_NONE && g->output_wire >= d->wire_count))
+            return 0;
+    }
+    for (size_t i = 0; i < d->wire_count; ++i)
+    {
+        const struct VlgWireRecord *w = &d->wires[i];
+        if (w->point_count == 0 || w->first_point > d->point_count || w->point_count > d->point_count - w->first_point ||
+            (w->net != VLG_NONE && w->net >= nets) ||
+            w->start_gate_index < -1 || w->start_gate_index >= (int64_t)d->gate_count ||
+            w->end_gate_index < -1 || w->end_gate_index >= (int64_t)d->gate_count)
+            return 0;
+    }
+    for (size_t i = 0; i < d->lamp_count; ++i)
+    {
+        if (d->lamps[i].input_wire != VLG_NONE && d->lamps[i].input_wire >= d->wire_count)
+            return 0;
+    }
+
+    nl->gate_count = (size_t)gates;
+    nl->net_count = (size_t)nets;
+    nl->group_count = (size_t)groups;
+    nl->depth = info->depth;
+    if (sizeof(size_t) == sizeof(uint64_t))
+    {
+        nl->level_start = (size_t *)level_start;
+        nl->group_start = (size_t *)group_start;
+        nl->level_group_start = (size_t *)level_group_start;
+    }
+    else
+    {
+        size_t total = (size_t)(depth + 1) * 2 + (size_t)groups + 1;
+        file->converted = malloc(total * sizeof(size_t));
+        if (!file->converted)
+            return 0;
+        nl->level_start = file->converted;
+        nl->level_group_start = nl->level_start + depth + 1;
+        nl->group_start = nl->level_group_start + depth + 1;
+        for (uint64_t i = 0; i <= depth; ++i)
+        {
+            nl->level_start[i] = (size_t)level_start[i];
+            nl->level_group_start[i] = (size_t)level_group_start[i];
+        }
+        for (uint64_t i = 0; i <= groups; ++i)
+            nl->group_start[i] = (size_t)group_start[i];
+    }
+    return 1;
+}
+
+int vlg_open(struct VlgFile *file, const char *path)
+{
+    memset(file, 0, sizeof(*file));
+    if (!map_file(file, path))
+        return 0;
+    if (!validate_and_bind(file))
+    {
+        vlg_close(file);
+        return 0;
+    }
+    return 1;
+}
+
+void vlg_close(struct VlgFile *file)
+{
+    netlist_free(&file->netlist);
+    free(file->converted);
+    unmap_file(file);
+    memset(file, 0, sizeof(*file));
+}
+
+void vlg_load_net_words(const struct VlgFile *file, PatternWord *net_words)
+{
+    const uint8_t *state = file->design.net_state;
+    net_words[NETLIST_NET_LOW] = 0;
+    for (size_t net = NETLIST_FIRST_NET; net < file->netlist.net_count; ++net)
+        net_words[net] = (state[net] == HIGH) ? ~(PatternWord)0 : 0;
+}
@@ -0,0 +1,144 @@
+#ifndef VLG_FILE_H
+#define VLG_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "netlist.h"
+
+// .vlg circuit files: a header, a section table and flat, 8-byte aligned arrays
+// addressed by file offset. The compiled netlist is stored in exactly the layout of
+// struct Netlist, so vlg_open maps the file and points a netlist at it without
+// parsing or allocating per object. Files are written in native byte order; a
+// byte-order mark in the header rejects files from the other endianness.
+#define VLG_MAGIC "VLG\0"
+#define VLG_VERSION 1
+#define VLG_NONE UINT32_MAX // No wire / no net
+
+typedef enum
+{
+    // Netlist (struct Netlist arrays)
+    VLG_SECTION_NETLIST_INFO = 1,
+    VLG_SECTION_GATE_TYPE,
+    VLG_SECTION_GATE_IN1,
+    VLG_SECTION_GATE_IN2,
+    VLG_SECTION_GATE_OUT,
+    VLG_SECTION_GATE_CYCLIC,
+    VLG_SECTION_LEVEL_START,
+    VLG_SECTION_LEVEL_CYCLIC,
+    VLG_SECTION_GROUP_START,
+    VLG_SECTION_GROUP_TYPE,
+    VLG_SECTION_GROUP_CONTIGUOUS,
+    VLG_SECTION_LEVEL_GROUP_START,
+    VLG_SECTION_NET_DRIVER,
+    VLG_SECTION_NET_STATE,   // SignalState per net at save time
+    VLG_SECTION_INPUT_NETS,  // Undriven nets (switch wires), in editor order
+    VLG_SECTION_OUTPUT_NETS, // Net of each lamp, VLG_NONE when unconnected
+    // Editor geometry
+    VLG_SECTION_EDITOR_GATES,
+    VLG_SECTION_EDITOR_WIRES,
+    VLG_SECTION_WIRE_POINTS,
+    VLG_SECTION_EDITOR_LAMPS,
+    VLG_SECTION_COUNT
+} VlgSectionId;
+
+struct VlgHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t byte_order; // 0x01020304 as written by the saving machine
+    uint32_t section_count;
+};
+
+struct VlgSection
+{
+    uint32_t id;        // VlgSectionId
+    uint32_t elem_size; // Bytes per element
+    uint64_t offset;    // From the start of the file, multiple of 8
+    uint64_t count;     // Elements
+};
+
+struct VlgNetlistInfo
+{
+    uint64_t gate_count;
+    uint64_t net_count;
+    uint64_t group_count;
+    int32_t depth;
+    uint32_t reserved;
+};
+
+struct VlgGateRecord
+{
+    float x, y, width, height;
+    uint32_t type;        // GateType
+    uint32_t input1_wire; // Index into the wire records, VLG_NONE if unconnected
+    uint32_t input2_wire;
+    uint32_t output_wire;
+};
+
+struct VlgWireRecord
+{
+    uint64_t first_point; // Into the point section
+    uint32_t point_count;
+    uint32_t net; // Netlist net of the segment; segments sharing a net are connected
+    int32_t start_gate_index; // -1 = none
+    int32_t end_gate_index;
+    uint8_t start_pin; // GatePinType
+    uint8_t end_pin;
+    uint8_t reserved[6];
+};
+
+struct VlgPoint
+{
+    float x, y;
+};
+
+struct VlgLampRecord
+{
+    float x, y, radius;
+    uint32_t input_wire; // VLG_NONE if unconnected
+};
+
+// Everything except the netlist, as flat arrays. vlg_save reads it; vlg_open fills it
+// with pointers into the mapped file.
+struct VlgDesign
+{
+    const struct VlgGateRecord *gates;
+    size_t gate_count;
+    const struct VlgWireRecord *wires;
+    size_t wire_count;
+    const struct VlgPoint *points;
+    size_t point_count;
+    const struct VlgLampRecord *lamps;
+    size_t lamp_count;
+    const uint8_t *net_state; // netlist.net_count entries
+    const uint32_t *input_nets;
+    size_t input_count;
+    const uint32_t *output_nets;
+    size_t output_count;
+};
+
+struct VlgFile
+{
+    void *data; // Read-only mapping of the whole file
+    size_t size;
+#ifdef _WIN32
+    void *file_handle;
+    void *mapping_handle;
+#endif
+    size_t *converted; // size_t arrays copied out when size_t is not 64-bit
+    struct VlgDesign design;
+    struct Netlist netlist; // Borrows the mapping: valid until vlg_close
+};
+
+// Write design and its compiled netlist (net_state must cover nl->net_count nets).
+// Returns 0 on failure.
+int vlg_save(const char *path, const struct VlgDesign *design, const struct Netlist *nl);
+
+// Map and validate a file. Returns 0 if it cannot be opened or is malformed.
+int vlg_open(struct VlgFile *file, const char *path);
+void vlg_close(struct VlgFile *file);
+
+// Initial net words from the saved states (HIGH = all ones)
+void vlg_load_net_words(const struct VlgFile *file, PatternWord *net_words);
+
+#endif // VLG_FILE_H
@@ -0,0 +1,295 @@
+#include <stdlib.h>
+#include <string.h>
+#include "waveform.h"
+
+// Change records: (signal << 2) | value. A time change is WAVEFORM_TIME_MARK followed
+// by the low and high halves of the time; the three words never straddle a block.
+#define WAVEFORM_TIME_MARK UINT32_MAX
+#define WAVEFORM_TIME_WORDS 3
+
+static const char waveform_value_chars[4] = {'0', '1', 'x', 'z'};
+
+int waveform_open(struct WaveformRecorder *rec, const char *path, size_t memory_budget, const char *timescale)
+{
+    memset(rec, 0, sizeof(*rec));
+    if (memory_budget == 0)
+        memory_budget = WAVEFORM_DEFAULT_BUDGET;
+    rec->block_count = memory_budget / (WAVEFORM_BLOCK_WORDS * sizeof(uint32_t));
+    if (rec->block_count < 2)
+        rec->block_count = 2;
+    snprintf(rec->timescale, sizeof(rec->timescale), "%s", timescale ? timescale : "1 ns");
+
+    rec->memory = malloc(rec->block_count * WAVEFORM_BLOCK_WORDS * sizeof(uint32_t));
+    rec->block_fill = calloc(rec->block_count, sizeof(size_t));
+    rec->full_queue = malloc(rec->block_count * sizeof(size_t));
+    rec->free_blocks = malloc(rec->block_count * sizeof(size_t));
+    rec->file = (rec->memory && rec->block_fill && rec->full_queue && rec->free_blocks) ? fopen(path, "wb") : NULL;
+    if (!rec->file)
+    {
+        free(rec->memory);
+        free(rec->block_fill);
+        free(rec->full_queue);
+        free(rec->free_blocks);
+        memset(rec, 0, sizeof(*rec));
+        return 0;
+    }
+    // Block 0 is filled first, the rest wait on the free stack
+    for (size_t b = rec->block_count; b-- > 1;)
+        rec->free_blocks[rec->free_count++] = b;
+    sys_mutex_init(&rec->mutex);
+    sys_cond_init(&rec->block_full);
+    sys_cond_init(&rec->block_free);
+    return 1;
+}
+
+uint32_t waveform_add_signal(struct WaveformRecorder *rec, const char *name, SignalState initial)
+{
+    if (rec->started || rec->signal_count >= WAVEFORM_MAX_SIGNALS)
+        return WAVEFORM_NO_SIGNAL;
+    if (rec->signal_count == rec->signal_capacity)
+    {
+        size_t new_capacity = rec->signal_capacity == 0 ? 64 : rec->signal_capacity * 2;
+        char **names = realloc(rec->names, new_capacity * sizeof(char *));
+        if (!names)
+            return WAVEFORM_NO_SIGNAL;
+        rec->names = names;
+        uint8_t *last = realloc(rec->last, new_capacity);
+        if (!last)
+            return WAVEFORM_NO_SIGNAL;
+        rec->last = last;
+        rec->signal_capacity = new_capacity;
+    }
+    size_t length = strlen(name);
+    char *copy = malloc(length + 1);
+    if (!copy)
+        return WAVEFORM_NO_SIGNAL;
+    for (size_t k = 0; k < length; ++k)
+    {
+        char c = name[k];
+        copy[k] = (c > ' ' && c < 127) ? c : '_';
+    }
+    copy[length] = '\0';
+    rec->names[rec->signal_count] = copy;
+    rec->last[rec->signal_count] = (uint8_t)(initial & 3);
+    return (uint32_t)rec->signal_count++;
+}
+
+// Identifier codes are base-94 numbers in the printable characters '!' to '~'
+static void waveform_make_code(char *code, size_t index)
+{
+    size_t k = 0;
+    do
+    {
+        code[k++] = (char)('!' + index % 94);
+        index /= 94;
+    } while (index > 0);
+    code[k] = '\0';
+}
+
+static void waveform_write_block(struct WaveformRecorder *rec, const uint32_t *words, size_t count)
+{
+    FILE *f = rec->file;
+    long long start = ftell(f);
+    for (size_t k = 0; k < count; ++k)
+    {
+        uint32_t word = words[k];
+        if (word == WAVEFORM_TIME_MARK && k + 2 < count)
+        {
+            uint64_t time = (uint64_t)words[k + 1] | ((uint64_t)words[k + 2] << 32);
+            fprintf(f, "#%llu\n", (unsigned long long)time);
+            k += 2;
+            continue;
+        }
+        putc(waveform_value_chars[word & 3], f);
+        fputs(rec->codes + (size_t)(word >> 2) * WAVEFORM_CODE_SIZE, f);
+        putc('\n', f);
+    }
+    long long end = ftell(f);
+    if (start >= 0 && end >= start)
+        rec->bytes_written += (uint64_t)(end - start);
+}
+
+static void waveform_writer_main(void *arg)
+{
+    struct WaveformRecorder *rec = arg;
+    sys_mutex_lock(&rec->mutex);
+    for (;;)
+    {
+        while (rec->full_count == 0 && !rec->stopping)
+            sys_cond_wait(&rec->block_full, &rec->mutex);
+        if (rec->full_count == 0)
+            break; // Stopping, and everything is written
+        size_t block = rec->full_queue[rec->full_head];
+        rec->full_head = (rec->full_head + 1) % rec->block_count;
+        rec->full_count--;
+        sys_mutex_unlock(&rec->mutex);
+
+        // The block belongs to this thread until it is back on the free stack
+        waveform_write_block(rec, rec->memory + block * WAVEFORM_BLOCK_WORDS, rec->block_fill[block]);
+        int failed = ferror(rec->file) != 0;
+
+        sys_mutex_lock(&rec->mutex);
+        rec->write_error |= failed;
+        rec->free_blocks[rec->free_count++] = block;
+        sys_cond_signal(&rec->block_free);
+    }
+    sys_mutex_unlock(&rec->mutex);
+}
+
+int waveform_start(struct WaveformRecorder *rec)
+{
+    if (rec->started || !rec->file)
+        return 0;
+    rec->codes = malloc((rec->signal_count + 1) * WAVEFORM_CODE_SIZE);
+    if (!rec->codes)
+        return 0;
+    for (size_t s = 0; s < rec->signal_count; ++s)
+        waveform_make_code(rec->codes + s * WAVEFORM_CODE_SIZE, s);
+
+    FILE *f = rec->file;
+    fprintf(f, "$version VirtualLogiGate $end\n$timescale %s $end\n$scope module top $end\n", rec->timescale);
+    for (size_t s = 0; s < rec->signal_count; ++s)
+        fprintf(f, "$var wire 1 %s %s $end\n", rec->codes + s * WAVEFORM_CODE_SIZE, rec->names[s]);
+    fputs("$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n", f);
+    for (size_t s = 0; s < rec->signal_count; ++s)
+        fprintf(f, "%c%s\n", waveform_value_chars[rec->last[s]], rec->codes + s * WAVEFORM_CODE_SIZE);
+    fputs("$end\n", f);
+
+    // Time 0 is in the header already
+    rec->time = 0;
+    rec->time_written = 1;
+    rec->started = sys_thread_create(&rec->writer, waveform_writer_main, rec);
+    return rec->started && !ferror(f);
+}
+
+// Queue the current block for the writer and take an empty one, waiting if the
+// writer still holds all of them
+static void waveform_next_block(struct WaveformRecorder *rec)
+{
+    sys_mutex_lock(&rec->mutex);
+    rec->block_fill[rec->current] = rec->fill;
+    rec->full_queue[(rec->full_head + rec->full_count) % rec->block_count] = rec->current;
+    rec->full_count++;
+    sys_cond_signal(&rec->block_full);
+    if (rec->free_count == 0)
+        rec->stalls++;
+    while (rec->free_count == 0)
+        sys_cond_wait(&rec->block_free, &rec->mutex);
+    rec->current = rec->free_blocks[--rec->free_count];
+    rec->fill = 0;
+    sys_mutex_unlock(&rec->mutex);
+}
+
+void waveform_step(struct WaveformRecorder *rec, uint64_t time)
+{
+    if (time != rec->time)
+    {
+        rec->time = time;
+        rec->time_written = 0;
+    }
+}
+
+void waveform_change(struct WaveformRecorder *rec, uint32_t signal, SignalState value)
+{
+    uint8_t v = (uint8_t)(value & 3);
+    if (!rec->started || signal >= rec->signal_count || rec->last[signal] == v)
+        return;
+    rec->last[signal] = v;
+    rec->changes++;
+    // Room for a time mark and the change in this block
+    if (rec->fill + WAVEFORM_TIME_WORDS + 1 > WAVEFORM_BLOCK_WORDS)
+        waveform_next_block(rec);
+    uint32_t *words = rec->memory + rec->current * WAVEFORM_BLOCK_WORDS;
+    if (!rec->time_written)
+    {
+        words[rec->fill++] = WAVEFORM_TIME_MARK;
+        words[rec->fill++] = (uint32_t)rec->time;
+        words[rec->fill++] = (uint32_t)(rec->time >> 32);
+        rec->time_written = 1;
+    }
+    words[rec->fill++] = (signal << 2) | v;
+}
+
+void waveform_sample_words(struct WaveformRecorder *rec, const uint32_t *signal_nets, const PatternWord *net_words,
+                           int lane)
+{
+    for (size_t s = 0; s < rec->signal_count; ++s)
+    {
+        if (signal_nets[s] == NETLIST_NO_NET)
+            continue;
+        uint8_t v = (uint8_t)((net_words[signal_nets[s]] >> lane) & 1);
+        if (v != rec->last[s])
+            waveform_change(rec, (uint32_t)s, (SignalState)v);
+    }
+}
+
+void waveform_sample_wires(struct WaveformRecorder *rec, struct Wire *const *wires)
+{
+    for (size_t s = 0; s < rec->signal_count; ++s)
+    {
+        if (!wires[s])
+            continue;
+        SignalState v = wire_state(wire_find(wires[s]));
+        if ((uint8_t)(v & 3) != rec->last[s])
+            waveform_change(rec, (uint32_t)s, v);
+    }
+}
+
+int waveform_close(struct WaveformRecorder *rec)
+{
+    if (!rec->file)
+        return 0;
+    int ok = 1;
+    if (rec->started)
+    {
+        sys_mutex_lock(&rec->mutex);
+        if (rec->fill > 0)
+        {
+            rec->block_fill[rec->current] = rec->fill;
+            rec->full_queue[(rec->full_head + rec->full_count) % rec->block_count] = rec->current;
+            rec->full_count++;
+        }
+        rec->stopping = 1;
+        sys_cond_signal(&rec->block_full);
+        sys_mutex_unlock(&rec->mutex);
+        sys_thread_join(rec->writer);
+        // Viewers take the last time stamp as the end of the recording
+        fprintf(rec->file, "#%llu\n", (unsigned long long)rec->time);
+        ok = !rec->write_error;
+    }
+    else
+        ok = 0;
+    ok = !ferror(rec->file) && ok;
+    ok = (fclose(rec->file) == 0) && ok;
+
+    sys_cond_destroy(&rec->block_free);
+    sys_cond_destroy(&rec->block_full);
+    sys_mutex_destroy(&rec->mutex);
+    for (size_t s = 0; s < rec->signal_count; ++s)
+        free(rec->names[s]);
+    free(rec->names);
+    free(rec->codes);
+    free(rec->last);
+    free(rec->memory);
+    free(rec->block_fill);
+    free(rec->full_queue);
+    free(rec->free_blocks);
+    size_t changes = rec->changes, stalls = rec->stalls;
+    uint64_t bytes_written = rec->bytes_written;
+    memset(rec, 0, sizeof(*rec));
+    rec->changes = changes;
+    rec->stalls = stalls;
+    rec->bytes_written = bytes_written;
+    return ok;
+}
+
+size_t waveform_memory_bytes(const struct WaveformRecorder *rec)
+{
+    size_t bytes = rec->block_count * (WAVEFORM_BLOCK_WORDS * sizeof(uint32_t) + 3 * sizeof(size_t));
+    bytes += rec->signal_capacity * (sizeof(char *) + 1);
+    if (rec->codes)
+        bytes += rec->signal_count * WAVEFORM_CODE_SIZE;
+    for (size_t s = 0; s < rec->signal_count; ++s)
+        bytes += strlen(rec->names[s]) + 1;
+    return bytes;
+}
@@ -0,0 +1,106 @@
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "logic.h"
+#include "netlist.h"
+#include "sys_thread.h"
+
+// Waveform recording to a VCD (Value Change Dump) file, readable by GTKWave and
+// most other waveform viewers.
+//
+// The simulation side only appends 4-byte change records to a block of the change
+// buffer; full blocks go to a writer thread that formats and writes them, then hands
+// them back. The buffer is a fixed number of blocks (the memory budget), so a run of
+// any length records in bounded memory. When the disk falls behind and every block
+// is waiting to be written, the simulation waits for one (counted in stalls).
+//
+// Usage: waveform_open, waveform_add_signal for every signal, waveform_start, then
+// per simulation step waveform_step followed by the changes (waveform_change, or one
+// of the sample helpers), and finally waveform_close.
+
+#define WAVEFORM_NO_SIGNAL UINT32_MAX
+#define WAVEFORM_MAX_SIGNALS (1u << 29)
+#define WAVEFORM_CODE_SIZE 6 // Identifier code: up to 5 printable characters
+#define WAVEFORM_BLOCK_WORDS 16384
+#define WAVEFORM_DEFAULT_BUDGET (4u << 20) // Bytes of change buffer
+
+struct WaveformRecorder
+{
+    FILE *file;
+    char timescale[16];
+
+    // Signals: VCD names, identifier codes, last recorded value (SignalState)
+    char **names;
+    char *codes; // WAVEFORM_CODE_SIZE bytes per signal, NUL-terminated
+    uint8_t *last;
+    size_t signal_count;
+    size_t signal_capacity;
+
+    // Change buffer: block_count blocks of WAVEFORM_BLOCK_WORDS words. Blocks cycle
+    // through current (filled by the simulation) -> full queue -> writer -> free stack.
+    uint32_t *memory;
+    size_t block_count;
+    size_t *block_fill; // Words used in each block
+    size_t current;     // Block being filled
+    size_t fill;
+    size_t *full_queue; // Ring of block indices waiting for the writer
+    size_t full_head;
+    size_t full_count;
+    size_t *free_blocks; // Stack of empty blocks
+    size_t free_count;
+
+    uint64_t time;    // Current step time
+    int time_written; // The current time has been written to the buffer
+
+    SysMutex mutex;
+    SysCond block_full; // Writer waits for work
+    SysCond block_free; // Simulation waits for an empty block
+    SysThread writer;
+    int started;
+    int stopping;
+    int write_error;
+
+    // Statistics
+    size_t changes;        // Value changes recorded
+    size_t stalls;         // Times the simulation had to wait for the writer
+    uint64_t bytes_written;
+};
+
+// Create path and size the change buffer (memory_budget bytes, 0 = default; at least
+// two blocks). timescale is the VCD unit of one time step, e.g. "1 ns". Returns 0 if
+// the file cannot be created or memory is short.
+int waveform_open(struct WaveformRecorder *rec, const char *path, size_t memory_budget, const char *timescale);
+
+// Add a signal (before waveform_start) with its value at the start. Characters a VCD
+// name cannot hold become '_'. Returns the signal index or WAVEFORM_NO_SIGNAL.
+uint32_t waveform_add_signal(struct WaveformRecorder *rec, const char *name, SignalState initial);
+
+// Write the VCD header with the initial values and start the writer thread.
+// Returns 0 on failure (the recorder must still be closed).
+int waveform_start(struct WaveformRecorder *rec);
+
+// Changes recorded from here on happen at time (never less than the previous step)
+void waveform_step(struct WaveformRecorder *rec, uint64_t time);
+
+// Record a signal's value; values equal to the last recorded one are skipped
+void waveform_change(struct WaveformRecorder *rec, uint32_t signal, SignalState value);
+
+// Record every signal from a lane of packed net words; signal i reads signal_nets[i]
+// (NETLIST_NO_NET: skipped)
+void waveform_sample_words(struct WaveformRecorder *rec, const uint32_t *signal_nets, const PatternWord *net_words,
+                           int lane);
+
+// Record every signal from the net state of logic wires; signal i reads wires[i] (NULL: skipped)
+void waveform_sample_wires(struct WaveformRecorder *rec, struct Wire *const *wires);
+
+// Write the remaining changes, stop the writer and close the file; only the
+// statistics stay readable. Returns 0 if anything could not be written.
+int waveform_close(struct WaveformRecorder *rec);
+
+// Bytes held by the recorder (change buffer and signal tables)
+size_t waveform_memory_bytes(const struct WaveformRecorder *rec);
+
+#endif // WAVEFORM_H
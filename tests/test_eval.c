@@ -0,0 +1,224 @@
+// Every evaluator against netlist_eval_packed (scalar) on generated circuits with random
+// input words: the AVX2 kernels, netlist_eval_parallel, the optimized netlist (kept
+// nets through net_map) and the compiled evaluator (skipped without a C compiler).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "circuit_gen.h"
+#include "netlist.h"
+#include "netlist_codegen.h"
+#include "netlist_opt.h"
+#include "thread_pool.h"
+
+#define TEST_GATES 3000
+#define TEST_SEEDS 4
+#define TEST_ITERATIONS 64
+
+static int failures;
+
+static uint32_t next_random(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static int compare_words(const char *name, const char *evaluator, const PatternWord *expected,
+                         const PatternWord *actual, size_t net_count)
+{
+    for (size_t n = 0; n < net_count; ++n)
+        if (expected[n] != actual[n])
+        {
+            fprintf(stderr, "FAIL %s %s: net %zu is %016llx, expected %016llx\n", name, evaluator, n,
+                    (unsigned long long)actual[n], (unsigned long long)expected[n]);
+            ++failures;
+            return 0;
+        }
+    return 1;
+}
+
+static void check_optimized(const char *name, const struct Netlist *nl, const struct GenCircuit *c,
+                            const uint32_t *input_nets, const PatternWord *inputs, const PatternWord *expected)
+{
+    uint32_t *keep = malloc((c->output_count + 1) * sizeof(uint32_t));
+    uint32_t *net_map = malloc(nl->net_count * sizeof(uint32_t));
+    struct Netlist opt;
+    if (!keep || !net_map)
+    {
+        fprintf(stderr, "FAIL %s optimize: out of memory\n", name);
+        ++failures;
+        free(keep);
+        free(net_map);
+        return;
+    }
+    size_t keep_count = 0;
+    for (size_t i = 0; i < c->output_count; ++i)
+    {
+        uint32_t net = netlist_net_of(nl, c->outputs[i]);
+        if (net != NETLIST_NO_NET)
+            keep[keep_count++] = net;
+    }
+    if (!netlist_optimize(nl, keep, keep_count, &opt, net_map, NULL))
+    {
+        fprintf(stderr, "FAIL %s optimize: netlist_optimize failed\n", name);
+        ++failures;
+        free(keep);
+        free(net_map);
+        return;
+    }
+
+    PatternWord *words = malloc(opt.net_count * sizeof(PatternWord));
+    if (words)
+    {
+        netlist_load_states(&opt, words);
+        for (size_t i = 0; i < c->input_count; ++i)
+            if (input_nets[i] != NETLIST_NO_NET && net_map[input_nets[i]] != NETLIST_NO_NET &&
+                net_map[input_nets[i]] != NETLIST_NET_LOW)
+                words[net_map[input_nets[i]]] = inputs[i];
+        netlist_eval_packed(&opt, words, TEST_ITERATIONS);
+        for (size_t i = 0; i < keep_count; ++i)
+        {
+            uint32_t mapped = net_map[keep[i]];
+            PatternWord actual = mapped == NETLIST_NET_LOW ? 0 : mapped == NETLIST_NO_NET ? ~expected[keep[i]]
+                                                                                           : words[mapped];
+            if (actual != expected[keep[i]])
+            {
+                fprintf(stderr, "FAIL %s optimize: kept net %u is %016llx, expected %016llx\n", name, keep[i],
+                        (unsigned long long)actual, (unsigned long long)expected[keep[i]]);
+                ++failures;
+                break;
+            }
+        }
+    }
+    else
+    {
+        fprintf(stderr, "FAIL %s optimize: out of memory\n", name);
+        ++failures;
+    }
+    free(words);
+    netlist_free(&opt);
+    free(keep);
+    free(net_map);
+}
+
+static void check_circuit(GenKind kind, uint32_t seed, ThreadPool *pool, int *codegen_available)
+{
+    char name[64];
+    snprintf(name, sizeof name, "%s/%u", gen_kind_name(kind), seed);
+
+    struct GenCircuit c;
+    struct Netlist nl;
+    if (!gen_build(&c, kind, TEST_GATES, seed))
+    {
+        fprintf(stderr, "FAIL %s: gen_build failed\n", name);
+        ++failures;
+        return;
+    }
+    if (!netlist_compile(&nl, c.gates, c.gate_count, c.outputs, c.output_count))
+    {
+        fprintf(stderr, "FAIL %s: netlist_compile failed\n", name);
+        ++failures;
+        gen_free(&c);
+        return;
+    }
+
+    size_t bytes = nl.net_count * sizeof(PatternWord);
+    PatternWord *initial = malloc(bytes);
+    PatternWord *expected = malloc(bytes);
+    PatternWord *actual = malloc(bytes);
+    uint32_t *input_nets = malloc((c.input_count + 1) * sizeof(uint32_t));
+    PatternWord *inputs = malloc((c.input_count + 1) * sizeof(PatternWord));
+    if (!initial || !expected || !actual || !input_nets || !inputs)
+    {
+        fprintf(stderr, "FAIL %s: out of memory\n", name);
+        ++failures;
+        goto done;
+    }
+
+    uint32_t rng = seed * 2654435761u + 1;
+    netlist_load_states(&nl, initial);
+    for (size_t i = 0; i < c.input_count; ++i)
+    {
+        input_nets[i] = netlist_net_of(&nl, c.inputs[i]);
+        inputs[i] = (PatternWord)next_random(&rng) << 32 | next_random(&rng);
+        if (input_nets[i] != NETLIST_NO_NET)
+            initial[input_nets[i]] = inputs[i];
+    }
+
+    netlist_set_simd(NETLIST_SIMD_SCALAR);
+    memcpy(expected, initial, bytes);
+    netlist_eval_packed(&nl, expected, TEST_ITERATIONS);
+
+    if (netlist_simd_supported() == NETLIST_SIMD_AVX2)
+    {
+        netlist_set_simd(NETLIST_SIMD_AVX2);
+        memcpy(actual, initial, bytes);
+        netlist_eval_packed(&nl, actual, TEST_ITERATIONS);
+        compare_words(name, "avx2", expected, actual, nl.net_count);
+    }
+    netlist_set_simd(netlist_simd_supported());
+
+    // One gate per rank is enough to hand every acyclic rank to the pool
+    memcpy(actual, initial, bytes);
+    netlist_eval_parallel(&nl, actual, TEST_ITERATIONS, pool, 1);
+    compare_words(name, "parallel", expected, actual, nl.net_count);
+
+    // A feedback loop that does not settle within the iteration limit ends wherever the
+    // gate order leaves it, and the optimizer reorders gates
+    if (kind != GEN_RING_OSCILLATOR)
+        check_optimized(name, &nl, &c, input_nets, inputs, expected);
+
+    if (*codegen_available)
+    {
+        struct NetlistCompiled compiled;
+        if (netlist_codegen_load(&compiled, &nl))
+        {
+            memcpy(actual, initial, bytes);
+            netlist_codegen_eval(&compiled, &nl, actual, TEST_ITERATIONS);
+            compare_words(name, "codegen", expected, actual, nl.net_count);
+            netlist_codegen_unload(&compiled);
+        }
+        else
+        {
+            printf("skipping codegen: no C compiler or no dynamic loading\n");
+            *codegen_available = 0;
+        }
+    }
+
+done:
+    free(initial);
+    free(expected);
+    free(actual);
+    free(input_nets);
+    free(inputs);
+    netlist_free(&nl);
+    gen_free(&c);
+}
+
+int main(void)
+{
+    ThreadPool *pool = thread_pool_create(4);
+    int codegen_available = 1;
+    if (!pool)
+    {
+        fprintf(stderr, "FAIL: thread_pool_create failed\n");
+        return 1;
+    }
+
+    for (int k = 0; k < GEN_KIND_COUNT; ++k)
+        check_circuit((GenKind)k, 1, pool, &codegen_available);
+    for (uint32_t seed = 2; seed < 2 + TEST_SEEDS; ++seed)
+        check_circuit(GEN_RANDOM_DAG, seed, pool, &codegen_available);
+
+    thread_pool_destroy(pool);
+    if (failures)
+    {
+        fprintf(stderr, "%d evaluator mismatches\n", failures);
+        return 1;
+    }
+    printf("all evaluators agree\n");
+    return 0;
+}
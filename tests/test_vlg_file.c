@@ -0,0 +1,269 @@
+// vlg_open on a valid file, on truncated copies, on files with one broken netlist
+// invariant each (all must be rejected), and on files with random bytes flipped
+// (rejected or, if accepted, safe to evaluate).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "circuit_gen.h"
+#include "netlist.h"
+#include "vlg_file.h"
+
+#define TEST_PATH "test_vlg_file.vlg"
+#define TEST_GATES 2000
+#define TEST_FLIPS 300
+
+static int failures;
+
+static uint32_t next_random(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static unsigned char *read_file(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    unsigned char *data = NULL;
+    long length;
+    if (!f)
+        return NULL;
+    if (fseek(f, 0, SEEK_END) == 0 && (length = ftell(f)) > 0 && fseek(f, 0, SEEK_SET) == 0 &&
+        (data = malloc((size_t)length)) != NULL && fread(data, 1, (size_t)length, f) != (size_t)length)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = data ? (size_t)length : 0;
+    return data;
+}
+
+static int write_file(const char *path, const unsigned char *data, size_t size)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return 0;
+    int ok = fwrite(data, 1, size, f) == size;
+    return fclose(f) == 0 && ok;
+}
+
+// Opens the file; a file that opens is evaluated once, so bad indices show up under
+// sanitizers
+static int try_open(void)
+{
+    struct VlgFile file;
+    if (!vlg_open(&file, TEST_PATH))
+        return 0;
+    PatternWord *words = malloc((file.netlist.net_count + 1) * sizeof(PatternWord));
+    if (words)
+    {
+        vlg_load_net_words(&file, words);
+        netlist_eval_packed(&file.netlist, words, 4);
+        free(words);
+    }
+    vlg_close(&file);
+    return 1;
+}
+
+static void expect_rejected(const char *what, const struct VlgDesign *design, const struct Netlist *nl)
+{
+    if (!vlg_save(TEST_PATH, design, nl))
+    {
+        fprintf(stderr, "FAIL %s: vlg_save failed\n", what);
+        ++failures;
+    }
+    else if (try_open())
+    {
+        fprintf(stderr, "FAIL %s: file was accepted\n", what);
+        ++failures;
+    }
+}
+
+static void check_invariants(struct VlgDesign *design, struct Netlist *nl, uint32_t *input_nets)
+{
+    uint8_t type = nl->gate_type[0];
+    nl->gate_type[0] = GATE_TYPE_COUNT;
+    expect_rejected("unknown gate type", design, nl);
+    nl->gate_type[0] = (uint8_t)(type == AND ? OR : AND);
+    expect_rejected("gate type differs from its group", design, nl);
+    nl->gate_type[0] = type;
+
+    uint32_t in2 = nl->gate_in2[0];
+    nl->gate_in2[0] = (uint32_t)nl->net_count;
+    expect_rejected("input net out of range", design, nl);
+    nl->gate_in2[0] = in2;
+
+    uint32_t out = nl->gate_out[0];
+    nl->gate_out[0] = NETLIST_NET_LOW;
+    expect_rejected("gate drives the LOW net", design, nl);
+    nl->gate_out[0] = out;
+
+    uint32_t driver = nl->net_driver[out];
+    nl->net_driver[out] = driver == 0 ? 1 : 0;
+    expect_rejected("net driver does not drive the net", design, nl);
+    nl->net_driver[out] = driver;
+
+    uint32_t input = input_nets[0];
+    input_nets[0] = out;
+    expect_rejected("input net has a driver", design, nl);
+    input_nets[0] = input;
+
+    // Swap two outputs of a contiguous group (and their drivers) so only the run breaks
+    for (size_t g = 0; g < nl->group_count; ++g)
+    {
+        size_t begin = nl->group_start[g];
+        if (!nl->group_contiguous[g] || nl->group_start[g + 1] - begin < 2)
+            continue;
+        uint32_t a = nl->gate_out[begin], b = nl->gate_out[begin + 1];
+        nl->gate_out[begin] = b;
+        nl->gate_out[begin + 1] = a;
+        nl->net_driver[a] = (uint32_t)(begin + 1);
+        nl->net_driver[b] = (uint32_t)begin;
+        expect_rejected("contiguous group out of order", design, nl);
+        nl->gate_out[begin] = a;
+        nl->gate_out[begin + 1] = b;
+        nl->net_driver[a] = (uint32_t)begin;
+        nl->net_driver[b] = (uint32_t)(begin + 1);
+        break;
+    }
+
+    // A rank-1 gate reading the output of the last (deepest) gate
+    if (nl->depth >= 2 && !nl->level_cyclic[1])
+    {
+        size_t reader = nl->level_start[1];
+        uint32_t in1 = nl->gate_in1[reader];
+        nl->gate_in1[reader] = nl->gate_out[nl->gate_count - 1];
+        expect_rejected("gate reads a later rank", design, nl);
+        nl->gate_in1[reader] = in1;
+    }
+}
+
+static void check_truncated(const unsigned char *data, size_t size)
+{
+    size_t lengths[] = {0, 1, 8, size / 4, size / 2, size - 8, size - 1};
+    for (size_t i = 0; i < sizeof lengths / sizeof lengths[0]; ++i)
+    {
+        if (!write_file(TEST_PATH, data, lengths[i]))
+        {
+            fprintf(stderr, "FAIL truncated to %zu bytes: cannot write\n", lengths[i]);
+            ++failures;
+        }
+        else if (try_open())
+        {
+            fprintf(stderr, "FAIL truncated to %zu bytes: file was accepted\n", lengths[i]);
+            ++failures;
+        }
+    }
+}
+
+static void check_corrupted(const unsigned char *data, size_t size)
+{
+    unsigned char *copy = malloc(size);
+    uint32_t rng = 12345;
+    size_t accepted = 0;
+    if (!copy)
+    {
+        fprintf(stderr, "FAIL corrupted: out of memory\n");
+        ++failures;
+        return;
+    }
+    // Half of the flips land in the first 256 bytes (header and section table)
+    for (int i = 0; i < TEST_FLIPS; ++i)
+    {
+        size_t limit = (i & 1) && size > 256 ? 256 : size;
+        size_t at = next_random(&rng) % limit;
+        memcpy(copy, data, size);
+        copy[at] ^= (unsigned char)(1u << (next_random(&rng) & 7));
+        if (!write_file(TEST_PATH, copy, size))
+        {
+            fprintf(stderr, "FAIL corrupted: cannot write\n");
+            ++failures;
+            break;
+        }
+        accepted += (size_t)try_open();
+    }
+    printf("%zu of %d corrupted files accepted\n", accepted, TEST_FLIPS);
+    free(copy);
+}
+
+int main(void)
+{
+    struct GenCircuit c;
+    struct Netlist nl;
+    if (!gen_build(&c, GEN_RANDOM_DAG, TEST_GATES, 1))
+    {
+        fprintf(stderr, "FAIL: gen_build failed\n");
+        return 1;
+    }
+    if (!netlist_compile(&nl, c.gates, c.gate_count, c.outputs, c.output_count))
+    {
+        fprintf(stderr, "FAIL: netlist_compile failed\n");
+        gen_free(&c);
+        return 1;
+    }
+
+    uint8_t *net_state = calloc(nl.net_count, 1);
+    uint32_t *input_nets = malloc((c.input_count + 1) * sizeof(uint32_t));
+    unsigned char *data = NULL;
+    size_t size = 0;
+    if (!net_state || !input_nets)
+    {
+        fprintf(stderr, "FAIL: out of memory\n");
+        ++failures;
+        goto done;
+    }
+    for (size_t i = 0; i < c.input_count; ++i)
+        input_nets[i] = netlist_net_of(&nl, c.inputs[i]);
+
+    struct VlgPoint point = {0};
+    struct VlgWireRecord wire = {0};
+    wire.point_count = 1;
+    wire.net = UINT32_MAX;
+    wire.start_gate_index = -1;
+    wire.end_gate_index = -1;
+
+    struct VlgDesign design = {0};
+    design.wires = &wire;
+    design.wire_count = 1;
+    design.points = &point;
+    design.point_count = 1;
+    design.net_state = net_state;
+    design.input_nets = input_nets;
+    design.input_count = c.input_count;
+
+    if (!vlg_save(TEST_PATH, &design, &nl) || !try_open())
+    {
+        fprintf(stderr, "FAIL: valid file rejected\n");
+        ++failures;
+        goto done;
+    }
+    if (!(data = read_file(TEST_PATH, &size)))
+    {
+        fprintf(stderr, "FAIL: cannot read back the valid file\n");
+        ++failures;
+        goto done;
+    }
+
+    check_invariants(&design, &nl, input_nets);
+    check_truncated(data, size);
+    check_corrupted(data, size);
+
+done:
+    remove(TEST_PATH);
+    free(data);
+    free(net_state);
+    free(input_nets);
+    netlist_free(&nl);
+    gen_free(&c);
+    if (failures)
+    {
+        fprintf(stderr, "%d loader checks failed\n", failures);
+        return 1;
+    }
+    printf("loader checks passed\n");
+    return 0;
+}
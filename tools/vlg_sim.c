@@ -0,0 +1,714 @@
+// Headless simulator: loads a .vlg circuit, applies input vectors from a stimulus
+// file and prints the lamp states after each one. Needs no display, so large
+// regression runs can go on server machines.
+//
+// Stimulus files hold one vector per line: one '0' or '1' per input (the undriven
+// switch wires, in editor order). Spaces, tabs and '_' are ignored, '#' starts a
+// comment. Without a stimulus file the saved input states are simulated once.
+//
+// Output: one line per vector with one character per lamp ('0', '1', or 'x' for
+// lamps without a wire), followed by a summary on stderr.
+//
+// With -O the netlist is simplified first (netlist_optimize, keeping the lamps), so
+// only the logic that can reach a lamp is evaluated. With -c the netlist is compiled
+// to native code first (netlist_codegen_load); long stimulus runs repay the compile
+// time, and without a C compiler the interpreter is used.
+//
+// With -C N every vector is followed by N clock cycles (netlist_clock_cycles) before
+// the lamps are read, and the summary reports the cycle rate.
+//
+// With -T the critical path of the netlist is reported (netlist_timing_analyze) and
+// every vector's input change goes through the timed simulation (netlist_wheel), so
+// the summary can count glitches and the longest settle time. -D changes the gate
+// delays, e.g. -D XOR=45,DFF=60.
+//
+// With -w FILE the inputs and lamps (with -a every net) are recorded to a VCD file,
+// one time step per vector and, in sequential mode, per clock edge. Independent
+// vectors are recorded one after the other, each with its final state only.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "netlist.h"
+#include "netlist_codegen.h"
+#include "netlist_opt.h"
+#include "netlist_timing.h"
+#include "thread_pool.h"
+#include "vlg_file.h"
+#include "waveform.h"
+
+#define DEFAULT_LOOP_ITERATIONS 64
+
+struct Options
+{
+    const char *circuit_path;
+    const char *stimulus_path;
+    int passes;          // Evaluation passes per vector
+    int loop_iterations; // Limit for ranks with feedback loops
+    int sequential;      // Carry net state from one vector to the next
+    int threads;         // 1 = no thread pool
+    int quiet;           // Summary only
+    int optimize;        // Simulate the simplified netlist
+    int compile;         // Generate and load native code for the netlist
+    int cycles;          // Clock cycles after each vector
+    int timing;          // Critical path and timed input changes
+    struct TimingModel delays;
+    const char *wave_path; // VCD output, NULL = no recording
+    int wave_all;          // Record every net, not only inputs and lamps
+};
+
+// -w state: the recorder, the net each signal follows and the next time step
+struct Wave
+{
+    struct WaveformRecorder rec;
+    uint32_t *nets;
+    uint64_t time;
+};
+
+// What gets simulated: the netlist stored in the file, or its simplified copy
+struct Target
+{
+    const struct Netlist *nl;
+    const uint32_t *input_nets;
+    const uint32_t *output_nets; // VLG_NONE for lamps without a wire
+    const uint32_t *net_map;     // File net -> target net, NULL when simulating the file itself
+    struct NetlistCompiled compiled; // Native evaluator, unloaded when not requested or unavailable
+};
+
+// Settles the target between clock edges the way evaluate does
+struct Settler
+{
+    const struct Target *t;
+    ThreadPool *pool;
+};
+
+// -T state: the timing wheel and what it saw across all vectors
+struct Timed
+{
+    struct NetlistWheel wheel;
+    uint64_t horizon;      // Give up on settling after this long (oscillation)
+    size_t glitches;       // (net, vector) pairs that changed more than once
+    uint64_t settle_time;  // Longest settle time of any vector
+    size_t unsettled;      // Vector groups still changing at the horizon
+    int lost;              // An input event did not fit in memory
+};
+
+// Input vectors, one byte (0/1) per input, vector_count * input_count values
+struct Stimulus
+{
+    uint8_t *values;
+    size_t vector_count;
+    size_t capacity;
+};
+
+static void print_usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [options] circuit.vlg [stimulus.txt]\n"
+            "  -n N   evaluation passes per vector (default 1)\n"
+            "  -l N   iteration limit for feedback loops (default %d)\n"
+            "  -s     sequential: keep net states between vectors instead of starting\n"
+            "         every vector from the saved states (64 vectors per pass)\n"
+            "  -j N   threads, 0 = one per CPU (default 1)\n"
+            "  -O     simplify the logic first (constants, inverters, duplicates, dead gates)\n"
+            "  -c     compile the netlist to native code with the system C compiler\n"
+            "         (single-threaded; falls back to the interpreter)\n"
+            "  -C N   clock cycles to run after each vector (default 0)\n"
+            "  -T     report the critical path and simulate input changes with gate\n"
+            "         delays, counting glitches\n"
+            "  -D S   gate delays in ps for -T, e.g. AND=20,XOR=35 (types LOW HIGH AND\n"
+            "         OR NOT NAND NOR XOR XNOR CLK DFF LATCH TRI)\n"
+            "  -w F   record inputs and lamps to the VCD file F\n"
+            "  -a     with -w, record every net\n"
+            "  -q     print only the summary\n",
+            program, DEFAULT_LOOP_ITERATIONS);
+}
+
+static int parse_int(const char *text, int min, int *out)
+{
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (*text == '\0' || *end != '\0' || value < min || value > 1000000000L)
+        return 0;
+    *out = (int)value;
+    return 1;
+}
+
+static int parse_options(int argc, char **argv, struct Options *opt)
+{
+    memset(opt, 0, sizeof(*opt));
+    opt->passes = 1;
+    opt->loop_iterations = DEFAULT_LOOP_ITERATIONS;
+    opt->threads = 1;
+    timing_model_default(&opt->delays);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        if (strcmp(arg, "-s") == 0)
+            opt->sequential = 1;
+        else if (strcmp(arg, "-q") == 0)
+            opt->quiet = 1;
+        else if (strcmp(arg, "-O") == 0)
+            opt->optimize = 1;
+        else if (strcmp(arg, "-c") == 0)
+            opt->compile = 1;
+        else if (strcmp(arg, "-T") == 0)
+            opt->timing = 1;
+        else if (strcmp(arg, "-a") == 0)
+            opt->wave_all = 1;
+        else if (strcmp(arg, "-w") == 0)
+        {
+            if (i + 1 >= argc)
+                return 0;
+            opt->wave_path = argv[++i];
+        }
+        else if (strcmp(arg, "-D") == 0)
+        {
+            if (i + 1 >= argc || !timing_model_parse(&opt->delays, argv[++i]))
+                return 0;
+        }
+        else if (strcmp(arg, "-n") == 0 || strcmp(arg, "-l") == 0 || strcmp(arg, "-j") == 0 ||
+                 strcmp(arg, "-C") == 0)
+        {
+            if (i + 1 >= argc)
+                return 0;
+            int *target = arg[1] == 'n'   ? &opt->passes
+                          : arg[1] == 'l' ? &opt->loop_iterations
+                          : arg[1] == 'C' ? &opt->cycles
+                                          : &opt->threads;
+            if (!parse_int(argv[++i], (arg[1] == 'j' || arg[1] == 'C') ? 0 : 1, target))
+                return 0;
+        }
+        else if (arg[0] == '-')
+            return 0;
+        else if (!opt->circuit_path)
+            opt->circuit_path = arg;
+        else if (!opt->stimulus_path)
+            opt->stimulus_path = arg;
+        else
+            return 0;
+    }
+    return opt->circuit_path != NULL;
+}
+
+static int stimulus_push(struct Stimulus *st, const uint8_t *vector, size_t input_count)
+{
+    if (st->vector_count == st->capacity)
+    {
+        size_t new_capacity = st->capacity == 0 ? 64 : st->capacity * 2;
+        uint8_t *values = realloc(st->values, new_capacity * (input_count ? input_count : 1));
+        if (!values)
+            return 0;
+        st->values = values;
+        st->capacity = new_capacity;
+    }
+    memcpy(st->values + st->vector_count * input_count, vector, input_count);
+    st->vector_count++;
+    return 1;
+}
+
+static int load_stimulus(struct Stimulus *st, const char *path, size_t input_count)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        fprintf(stderr, "Cannot open stimulus file %s\n", path);
+        return 0;
+    }
+
+    uint8_t *vector = malloc(input_count ? input_count : 1);
+    if (!vector)
+    {
+        fclose(f);
+        return 0;
+    }
+    size_t filled = 0;
+    int line = 1, in_comment = 0, ok = 1;
+    for (int c = fgetc(f);; c = fgetc(f))
+    {
+        if (c == '\n' || c == EOF)
+        {
+            if (filled > 0 && filled != input_count)
+            {
+                fprintf(stderr, "%s:%d: expected %zu input values, got %zu\n", path, line, input_count, filled);
+                ok = 0;
+                break;
+            }
+            if (filled > 0 && !stimulus_push(st, vector, input_count))
+            {
+                ok = 0;
+                break;
+            }
+            if (c == EOF)
+                break;
+            filled = 0;
+            in_comment = 0;
+            line++;
+        }
+        else if (in_comment || c == ' ' || c == '\t' || c == '\r' || c == '_')
+            continue;
+        else if (c == '#')
+            in_comment = 1;
+        else if ((c == '0' || c == '1') && filled < input_count)
+            vector[filled++] = (uint8_t)(c - '0');
+        else
+        {
+            fprintf(stderr, "%s:%d: unexpected '%c'\n", path, line, c);
+            ok = 0;
+            break;
+        }
+    }
+    free(vector);
+    fclose(f);
+    return ok;
+}
+
+static size_t settle_once(void *context, const struct Netlist *nl, PatternWord *words, int max_loop_iterations)
+{
+    const struct Settler *settler = context;
+    if (settler->t->compiled.eval)
+        return netlist_codegen_eval(&settler->t->compiled, nl, words, max_loop_iterations);
+    if (settler->pool)
+        return netlist_eval_parallel(nl, words, max_loop_iterations, settler->pool, NETLIST_PARALLEL_MIN_GATES);
+    return netlist_eval_packed(nl, words, max_loop_iterations);
+}
+
+static size_t evaluate(const struct Target *t, PatternWord *words, const struct Options *opt, ThreadPool *pool)
+{
+    struct Settler settler = {t, pool};
+    size_t evaluations = 0;
+    for (int p = 0; p < opt->passes; ++p)
+        evaluations += settle_once(&settler, t->nl, words, opt->loop_iterations);
+    return evaluations;
+}
+
+// Next -w time step: record lane of words
+static void wave_sample(struct Wave *wave, const PatternWord *words, int lane)
+{
+    if (!wave)
+        return;
+    waveform_step(&wave->rec, ++wave->time);
+    waveform_sample_words(&wave->rec, wave->nets, words, lane);
+}
+
+// Start recording the inputs and lamps (every net with -a) from their values in
+// lane 0 of words. Returns 0 on failure.
+static int wave_open(struct Wave *wave, const struct Target *t, const struct VlgDesign *d, const struct Options *opt,
+                     const PatternWord *words)
+{
+    memset(wave, 0, sizeof(*wave));
+    size_t count = d->input_count + d->output_count + (opt->wave_all ? t->nl->net_count : 0);
+    wave->nets = malloc((count + 1) * sizeof(uint32_t));
+    if (!wave->nets || !waveform_open(&wave->rec, opt->wave_path, 0, "1 ns"))
+    {
+        free(wave->nets);
+        return 0;
+    }
+    char name[32];
+    size_t signals = 0;
+    int ok = 1;
+    for (size_t k = 0; k < count && ok; ++k)
+    {
+        uint32_t net;
+        if (k < d->input_count)
+        {
+            net = t->input_nets[k];
+            snprintf(name, sizeof(name), "in%zu", k);
+        }
+        else if (k < d->input_count + d->output_count)
+        {
+            net = t->output_nets[k - d->input_count];
+            snprintf(name, sizeof(name), "lamp%zu", k - d->input_count);
+        }
+        else
+        {
+            net = (uint32_t)(k - d->input_count - d->output_count);
+            snprintf(name, sizeof(name), "net%u", net);
+        }
+        SignalState initial = (net == VLG_NONE) ? UNKNOWN : (words[net] & 1) ? HIGH : LOW;
+        wave->nets[signals++] = net;
+        ok = waveform_add_signal(&wave->rec, name, initial) != WAVEFORM_NO_SIGNAL;
+    }
+    if (!ok || !waveform_start(&wave->rec))
+    {
+        waveform_close(&wave->rec);
+        free(wave->nets);
+        return 0;
+    }
+    return 1;
+}
+
+// Run the -C cycles on settled words; clock->cycles counts them across calls. With
+// wave, lane 0 is recorded after every edge. Returns the gate evaluations, 0 also
+// when the clock state cannot be allocated.
+static size_t run_cycles(const struct Target *t, PatternWord *words, const struct Options *opt, ThreadPool *pool,
+                         struct NetlistClock *clock, struct Wave *wave)
+{
+    struct Settler settler = {t, pool};
+    uint64_t done = clock->cycles;
+    // Start over from these words: every vector (or lane group) sees its own first edge
+    netlist_clock_free(clock);
+    if (!netlist_clock_init(clock, t->nl, words))
+        return 0;
+    clock->settle = settle_once;
+    clock->settle_context = &settler;
+    clock->cycles = done;
+    size_t evaluations = 0;
+    if (!wave)
+        evaluations = netlist_clock_cycles(clock, t->nl, words, (uint64_t)opt->cycles, opt->loop_iterations);
+    for (int c = 0; wave && c < opt->cycles; ++c)
+    {
+        evaluations += netlist_clock_edge(clock, t->nl, words, 1, opt->loop_iterations);
+        wave_sample(wave, words, 0);
+        evaluations += netlist_clock_edge(clock, t->nl, words, 0, opt->loop_iterations);
+        wave_sample(wave, words, 0);
+        clock->cycles++;
+    }
+    clock->settle = NULL;
+    clock->settle_context = NULL;
+    return evaluations;
+}
+
+// Print the critical path of the target and start the timing wheel on settled words.
+// Returns 0 on allocation failure.
+static int timed_init(struct Timed *timed, const struct Target *t, const struct Options *opt,
+                      const PatternWord *words)
+{
+    memset(timed, 0, sizeof(*timed));
+    struct NetlistTiming timing;
+    if (!netlist_timing_analyze(&timing, t->nl, &opt->delays))
+        return 0;
+    fprintf(stderr, "Critical path: %u ps through %zu gates", timing.critical_delay, timing.path_length);
+    if (timing.critical_delay > 0)
+        fprintf(stderr, " (max clock %.1f MHz)", 1e6 / (double)timing.critical_delay);
+    if (timing.loop_gates > 0)
+        fprintf(stderr, ", %zu gates in feedback loops (cut where they close)", timing.loop_gates);
+    fprintf(stderr, "\n ");
+    for (size_t k = 0; k < timing.path_length && k < 24; ++k)
+        fprintf(stderr, " %s", timing_gate_type_name((GateType)t->nl->gate_type[timing.path[k]]));
+    fprintf(stderr, timing.path_length > 24 ? " ...\n" : "\n");
+
+    uint32_t longest = 1;
+    for (int type = 0; type < TIMING_GATE_TYPES; ++type)
+        longest = opt->delays.delay[type] > longest ? opt->delays.delay[type] : longest;
+    timed->horizon = ((uint64_t)timing.critical_delay + longest) * (uint64_t)opt->loop_iterations;
+    netlist_timing_free(&timing);
+    return netlist_wheel_init(&timed->wheel, t->nl, &opt->delays, words);
+}
+
+// Set an input for the next settle_vector: directly, or as an event on the wheel
+static void set_input(PatternWord *words, uint32_t net, PatternWord value, struct Timed *timed)
+{
+    if (!timed)
+        words[net] = value;
+    else if (!netlist_wheel_drive(&timed->wheel, net, value))
+    {
+        words[net] = value;
+        timed->lost = 1;
+    }
+}
+
+// Settle after the inputs of a vector (or lane group) were set. With -T the wheel
+// carries the change through the gates first; lanes selects the lanes in use.
+static size_t settle_vector(const struct Target *t, PatternWord *words, const struct Options *opt, ThreadPool *pool,
+                            struct Timed *timed, PatternWord lanes)
+{
+    if (!timed)
+        return evaluate(t, words, opt, pool);
+    size_t evaluations = netlist_wheel_run(&timed->wheel, words, timed->horizon);
+    timed->glitches += netlist_wheel_glitches(&timed->wheel, lanes);
+    if (timed->wheel.last_change > timed->settle_time)
+        timed->settle_time = timed->wheel.last_change;
+    int passes = opt->passes - 1;
+    if (timed->wheel.pending > 0 || timed->lost)
+    {
+        // Oscillating (or out of memory): finish the way an untimed run would
+        timed->unsettled++;
+        timed->lost = 0;
+        passes++;
+    }
+    struct Settler settler = {t, pool};
+    for (int p = 0; p < passes; ++p)
+        evaluations += settle_once(&settler, t->nl, words, opt->loop_iterations);
+    return evaluations;
+}
+
+static void print_lamps(const struct Target *t, size_t output_count, const PatternWord *words, int lane, char *line)
+{
+    for (size_t j = 0; j < output_count; ++j)
+    {
+        uint32_t net = t->output_nets[j];
+        line[j] = (net == VLG_NONE) ? 'x' : ((words[net] >> lane) & 1) ? '1' : '0';
+    }
+    line[output_count] = '\0';
+    puts(line);
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Saved net states as pattern words of the target netlist
+static void load_base_words(const struct VlgFile *file, const struct Target *t, PatternWord *base)
+{
+    if (!t->net_map)
+    {
+        vlg_load_net_words(file, base);
+        return;
+    }
+    // Several file nets may share a target net; only undriven nets keep their value
+    memset(base, 0, (t->nl->net_count + 1) * sizeof(PatternWord));
+    for (size_t net = NETLIST_FIRST_NET; net < file->netlist.net_count; ++net)
+    {
+        uint32_t target = t->net_map[net];
+        if (target != NETLIST_NO_NET && target != NETLIST_NET_LOW)
+            base[target] = (file->design.net_state[net] == HIGH) ? ~(PatternWord)0 : 0;
+    }
+}
+
+// Simplify the file's netlist keeping every lamp; nets holds the target input nets
+// followed by the output nets. Returns 0 on allocation failure.
+static int optimize_target(const struct VlgFile *file, struct Netlist *optimized, uint32_t *net_map, uint32_t *nets)
+{
+    const struct VlgDesign *d = &file->design;
+    uint32_t *keep = malloc((d->output_count + 1) * sizeof(uint32_t));
+    if (!keep)
+        return 0;
+    size_t keep_count = 0;
+    for (size_t j = 0; j < d->output_count; ++j)
+    {
+        if (d->output_nets[j] != VLG_NONE)
+            keep[keep_count++] = d->output_nets[j];
+    }
+    struct NetlistOptStats stats;
+    int ok = netlist_optimize(&file->netlist, keep, keep_count, optimized, net_map, &stats);
+    free(keep);
+    if (!ok)
+        return 0;
+    for (size_t i = 0; i < d->input_count; ++i)
+        nets[i] = net_map[d->input_nets[i]];
+    for (size_t j = 0; j < d->output_count; ++j)
+        nets[d->input_count + j] = (d->output_nets[j] == VLG_NONE) ? VLG_NONE : net_map[d->output_nets[j]];
+    fprintf(stderr, "Optimized %zu -> %zu gates (%zu folded, %zu inversions collapsed, %zu merged, %zu dead)\n",
+            stats.gates_before, stats.gates_after, stats.folded, stats.collapsed, stats.merged, stats.removed);
+    return 1;
+}
+
+static void run(const struct VlgFile *file, const struct Target *t, const struct Stimulus *st,
+                const struct Options *opt, ThreadPool *pool, PatternWord *base, PatternWord *words, char *line)
+{
+    const struct Netlist *nl = t->nl;
+    const struct VlgDesign *d = &file->design;
+    double start = now_seconds();
+    size_t evaluations = 0;
+    struct NetlistClock clock = {0};
+    struct Timed timed_state, *timed = NULL;
+    struct Wave wave_state, *wave = NULL;
+    load_base_words(file, t, base);
+    if (opt->timing)
+    {
+        // Input changes are timed from the settled saved state
+        struct Settler settler = {t, pool};
+        evaluations += settle_once(&settler, nl, base, opt->loop_iterations);
+        if (!timed_init(&timed_state, t, opt, base))
+        {
+            fprintf(stderr, "Out of memory\n");
+            return;
+        }
+        timed = &timed_state;
+    }
+    if (opt->wave_path)
+    {
+        if (!wave_open(&wave_state, t, d, opt, base))
+        {
+            fprintf(stderr, "Cannot record to %s\n", opt->wave_path);
+            if (timed)
+                netlist_wheel_free(&timed->wheel);
+            return;
+        }
+        wave = &wave_state;
+    }
+    if (opt->sequential)
+    {
+        // Every lane carries the same vector; lane 0 is reported
+        memcpy(words, base, nl->net_count * sizeof(PatternWord));
+        for (size_t v = 0; v < st->vector_count; ++v)
+        {
+            const uint8_t *vector = st->values + v * d->input_count;
+            if (timed)
+                netlist_wheel_reset(&timed->wheel, words);
+            for (size_t i = 0; i < d->input_count; ++i)
+                set_input(words, t->input_nets[i], vector[i] ? ~(PatternWord)0 : 0, timed);
+            evaluations += settle_vector(t, words, opt, pool, timed, 1);
+            wave_sample(wave, words, 0);
+            if (opt->cycles > 0)
+                evaluations += run_cycles(t, words, opt, pool, &clock, wave);
+            if (!opt->quiet)
+                print_lamps(t, d->output_count, words, 0, line);
+        }
+    }
+    else
+    {
+        // Independent vectors, 64 per pass: vector v runs in lane v % 64
+        for (size_t first = 0; first < st->vector_count; first += NETLIST_PATTERNS_PER_WORD)
+        {
+            size_t lanes = st->vector_count - first;
+            if (lanes > NETLIST_PATTERNS_PER_WORD)
+                lanes = NETLIST_PATTERNS_PER_WORD;
+            memcpy(words, base, nl->net_count * sizeof(PatternWord));
+            if (timed)
+                netlist_wheel_reset(&timed->wheel, words);
+            for (size_t i = 0; i < d->input_count; ++i)
+            {
+                PatternWord w = 0;
+                for (size_t k = 0; k < lanes; ++k)
+                    w |= (PatternWord)st->values[(first + k) * d->input_count + i] << k;
+                set_input(words, t->input_nets[i], w, timed);
+            }
+            PatternWord lane_mask = lanes == NETLIST_PATTERNS_PER_WORD ? ~(PatternWord)0
+                                                                       : ((PatternWord)1 << lanes) - 1;
+            evaluations += settle_vector(t, words, opt, pool, timed, lane_mask);
+            if (opt->cycles > 0)
+                evaluations += run_cycles(t, words, opt, pool, &clock, NULL);
+            for (size_t k = 0; k < lanes && wave; ++k)
+                wave_sample(wave, words, (int)k);
+            for (size_t k = 0; k < lanes && !opt->quiet; ++k)
+                print_lamps(t, d->output_count, words, (int)k, line);
+        }
+    }
+    double seconds = now_seconds() - start;
+
+    fprintf(stderr, "%zu vectors, %zu gates, %zu inputs, %zu lamps, %zu gate evaluations in %.3f s",
+            st->vector_count, nl->gate_count, d->input_count, d->output_count, evaluations, seconds);
+    if (seconds > 0.0)
+        fprintf(stderr, " (%.1f M gate evals/s)", (double)evaluations / seconds / 1e6);
+    fprintf(stderr, "\n");
+    if (opt->cycles > 0)
+    {
+        fprintf(stderr, "%llu clock cycles, %zu clock sources, %zu flip-flops", (unsigned long long)clock.cycles,
+                clock.clock_count, clock.dff_count);
+        if (seconds > 0.0)
+            fprintf(stderr, " (%.0f cycles/s)", (double)clock.cycles / seconds);
+        fprintf(stderr, "\n");
+    }
+    if (timed)
+    {
+        fprintf(stderr, "Timed: %zu glitches, settled within %llu ps", timed->glitches,
+                (unsigned long long)timed->settle_time);
+        if (timed->unsettled > 0)
+            fprintf(stderr, ", %zu vector groups still changing after %llu ps", timed->unsettled,
+                    (unsigned long long)timed->horizon);
+        fprintf(stderr, "\n");
+        netlist_wheel_free(&timed->wheel);
+    }
+    if (wave)
+    {
+        size_t signals = wave->rec.signal_count;
+        size_t memory = waveform_memory_bytes(&wave->rec);
+        if (!waveform_close(&wave->rec))
+            fprintf(stderr, "Error writing %s\n", opt->wave_path);
+        fprintf(stderr, "Waveform: %zu signals, %zu changes, %.1f MB to %s (%zu KB buffer, %zu stalls)\n", signals,
+                wave->rec.changes, (double)wave->rec.bytes_written / 1e6, opt->wave_path, memory / 1024,
+                wave->rec.stalls);
+        free(wave->nets);
+    }
+    netlist_clock_free(&clock);
+}
+
+int main(int argc, char **argv)
+{
+    struct Options opt;
+    if (!parse_options(argc, argv, &opt))
+    {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    struct VlgFile file;
+    if (!vlg_open(&file, opt.circuit_path))
+    {
+        fprintf(stderr, "Cannot load circuit %s\n", opt.circuit_path);
+        return 1;
+    }
+    const struct Netlist *nl = &file.netlist;
+    const struct VlgDesign *d = &file.design;
+
+    struct Stimulus st = {0};
+    int ok = 1;
+    if (opt.stimulus_path)
+        ok = load_stimulus(&st, opt.stimulus_path, d->input_count);
+    else
+    {
+        // Saved input states as the only vector
+        uint8_t *vector = malloc(d->input_count ? d->input_count : 1);
+        ok = vector != NULL;
+        for (size_t i = 0; ok && i < d->input_count; ++i)
+            vector[i] = d->net_state[d->input_nets[i]] == HIGH;
+        ok = ok && stimulus_push(&st, vector, d->input_count);
+        free(vector);
+    }
+
+    struct Target target = {nl, d->input_nets, d->output_nets, NULL, {0}};
+    struct Netlist optimized;
+    int have_optimized = 0;
+    uint32_t *net_map = NULL, *target_nets = NULL;
+    if (ok && opt.optimize)
+    {
+        net_map = malloc((nl->net_count + 1) * sizeof(uint32_t));
+        target_nets = malloc((d->input_count + d->output_count + 1) * sizeof(uint32_t));
+        have_optimized = net_map && target_nets && optimize_target(&file, &optimized, net_map, target_nets);
+        ok = have_optimized;
+        if (!ok)
+            fprintf(stderr, "Out of memory\n");
+        else
+        {
+            target.nl = &optimized;
+            target.input_nets = target_nets;
+            target.output_nets = target_nets + d->input_count;
+            target.net_map = net_map;
+        }
+    }
+
+    if (ok && opt.compile)
+    {
+        double start = now_seconds();
+        if (netlist_codegen_load(&target.compiled, target.nl))
+            fprintf(stderr, "Compiled %zu gates to native code in %.2f s\n", target.nl->gate_count,
+                    now_seconds() - start);
+        else
+            fprintf(stderr, "No C compiler available, using the interpreter\n");
+    }
+
+    PatternWord *base = malloc((target.nl->net_count + 1) * sizeof(PatternWord));
+    PatternWord *words = malloc((target.nl->net_count + 1) * sizeof(PatternWord));
+    char *line = malloc(d->output_count + 1);
+    ThreadPool *pool = opt.threads != 1 ? thread_pool_create(opt.threads) : NULL;
+    if (!ok || !base || !words || !line || (opt.threads != 1 && !pool))
+    {
+        if (ok)
+            fprintf(stderr, "Out of memory\n");
+        ok = 0;
+    }
+
+    if (ok)
+        run(&file, &target, &st, &opt, pool, base, words, line);
+
+    netlist_codegen_unload(&target.compiled);
+    if (have_optimized)
+        netlist_free(&optimized);
+    free(net_map);
+    free(target_nets);
+    thread_pool_destroy(pool);
+    free(line);
+    free(words);
+    free(base);
+    free(st.values);
+    vlg_close(&file);
+    return ok ? 0 : 1;
+}